@@ -22,6 +22,7 @@
 #include <airdcpp/core/header/format.h>
 #include <airdcpp/util/AppUtil.h>
 #include <airdcpp/core/io/File.h>
+#include <airdcpp/core/timer/Tracer.h>
 #include <airdcpp/util/PathUtil.h>
 #include <airdcpp/util/text/StringTokenizer.h>
 #include <airdcpp/util/ValueGenerator.h>
@@ -60,6 +61,7 @@
 namespace dcpp {
 
 #define RUNNING_FLAG AppUtil::getPath(AppUtil::PATH_USER_LOCAL) + "RUNNING"
+#define TRACE_FILE AppUtil::getPath(AppUtil::PATH_USER_LOCAL) + "trace.json"
 
 void initializeUtil(const string& aConfigPath) noexcept {
 	AppUtil::initialize(aConfigPath);
@@ -137,6 +139,10 @@ void startup(StepFunction aStepF, MessageFunction aMessageF, Callback aRunWizard
 	SettingsManager::getInstance()->load(loader);
 	FavoriteManager::getInstance()->load();
 
+	if (SETTING(ENABLE_TRACING)) {
+		Tracer::setEnabled(true);
+	}
+
 	UploadManager::getInstance()->setFreeSlotMatcher();
 	Localization::init();
 	if (SETTING(WIZARD_PENDING) && aRunWizardF) {
@@ -220,6 +226,15 @@ void shutdown(StepFunction stepF, ProgressFunction progressF, ShutdownUnloadCall
 	FavoriteManager::getInstance()->shutdown();
 	SettingsManager::getInstance()->save();
 
+	if (Tracer::isEnabled()) {
+		// Only the latest spans of each thread are kept (see Tracer::RING_SIZE)
+		try {
+			Tracer::exportChromeTrace(TRACE_FILE);
+		} catch (const FileException&) {
+			// The trace is only diagnostic data
+		}
+	}
+
 	announce(STRING(SHUTTING_DOWN));
 
 	if (aModuleDestroyF) {
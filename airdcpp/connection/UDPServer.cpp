@@ -73,19 +73,38 @@ void UDPServer::addTask(Callback&& aTask) noexcept {
 }
 
 constexpr auto BUFSIZE = 8192;
-int UDPServer::run() {
-	int len;
-	string remoteAddr;
 
+// Maximum number of queued packets that are handled in a single task
+constexpr size_t MAX_PACKET_BATCH = 64;
+
+int UDPServer::run() {
 	while(!stop) {
 		try {
 			if(!socket->wait(400, true, false).first) {
 				continue;
 			}
 
-			auto buffer = vector<uint8_t>(BUFSIZE);
-			if((len = socket->read(buffer.data(), BUFSIZE, remoteAddr)) > 0) {
-				pp.addTask([buf = std::move(buffer), len, remoteAddr, this] { handlePacket(buf, len, remoteAddr); });
+			// Read the whole burst that is waiting in the socket buffer
+			PacketList packets;
+			do {
+				Packet packet;
+				packet.buf.resize(BUFSIZE);
+
+				auto len = socket->read(packet.buf.data(), BUFSIZE, packet.remoteIp);
+				if (len <= 0) {
+					break;
+				}
+
+				packet.buf.resize(static_cast<size_t>(len));
+				packets.push_back(std::move(packet));
+			} while (packets.size() < MAX_PACKET_BATCH && !stop && socket->wait(0, true, false).first);
+
+			if (!packets.empty()) {
+				pp.addTask([p = std::move(packets), this] {
+					for (const auto& packet: p) {
+						handlePacket(packet.buf, packet.buf.size(), packet.remoteIp);
+					}
+				});
 				continue;
 			}
 		} catch(const SocketException& e) {
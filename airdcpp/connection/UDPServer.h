@@ -45,6 +45,13 @@ private:
 	bool stop;
 
 	DispatcherQueue pp;
+
+	struct Packet {
+		ByteVector buf;
+		string remoteIp;
+	};
+
+	using PacketList = vector<Packet>;
 	void handlePacket(const ByteVector& aBuf, size_t aLen, const string& aRemoteIp);
 
 	// Search results
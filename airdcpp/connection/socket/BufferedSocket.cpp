@@ -29,6 +29,7 @@
 #include <airdcpp/core/io/stream/StreamBase.h>
 #include <airdcpp/connection/ThrottleManager.h>
 #include <airdcpp/core/timer/TimerManager.h>
+#include <airdcpp/core/timer/Tracer.h>
 #include <airdcpp/core/io/compress/ZUtils.h>
 
 namespace dcpp {
@@ -36,6 +37,9 @@ namespace dcpp {
 using std::min;
 using std::max;
 
+static Tracer::Counter& bytesRead = Tracer::getCounter(Tracer::SOCKET, "bytesRead");
+static Tracer::Counter& bytesWritten = Tracer::getCounter(Tracer::SOCKET, "bytesWritten");
+
 // Polling is used for tasks...should be fixed...
 constexpr auto POLL_TIMEOUT = 250;
 
@@ -221,6 +225,8 @@ void BufferedSocket::threadRead() {
 		throw SocketException(STRING(CONNECTION_CLOSED));
 	}
 
+	bytesRead.add(left);
+
 	string::size_type pos = 0;
 	// always uncompressed data
 	string l;
@@ -455,6 +461,7 @@ void BufferedSocket::threadSendData() {
 			if(n > 0) {
 				left -= n;
 				done += n;
+				bytesWritten.add(n);
 			}
 		}
 	}
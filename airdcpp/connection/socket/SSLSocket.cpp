@@ -60,7 +60,12 @@ bool SSLSocket::waitConnected(uint64_t millis) {
 
 		if(!verifyData) {
 			SSL_set_verify(ssl, SSL_VERIFY_NONE, NULL);
-		} else SSL_set_ex_data(ssl, CryptoManager::idxVerifyData, verifyData.get());
+		} else {
+			SSL_set_ex_data(ssl, CryptoManager::idxVerifyData, verifyData.get());
+			if (!SSL_is_server(ssl)) {
+				CryptoManager::getInstance()->setCachedSession(ssl, verifyData->second);
+			}
+		}
 
 		if (!hostname.empty()) {
 			// https://github.com/openssl/openssl/issues/7147#issuecomment-419621673
@@ -78,6 +83,7 @@ bool SSLSocket::waitConnected(uint64_t millis) {
 		int ret = SSL_is_server(ssl) ? SSL_accept(ssl) : SSL_connect(ssl);
 		if(ret == 1) {
 			dcdebug("Connected to SSL server using %s as %s\n", SSL_get_cipher(ssl), SSL_is_server(ssl) ? "server" : "client");
+			CryptoManager::getInstance()->onHandshakeCompleted(ssl);
 			return true;
 		}
 		if(!waitWant(ret, millis)) {
@@ -110,6 +116,7 @@ bool SSLSocket::waitAccepted(uint64_t millis) {
 		int ret = SSL_accept(ssl);
 		if(ret == 1) {
 			dcdebug("Connected to SSL client using %s\n", SSL_get_cipher(ssl));
+			CryptoManager::getInstance()->onHandshakeCompleted(ssl);
 			return true;
 		}
 		if(!waitWant(ret, millis)) {
@@ -260,7 +267,13 @@ std::string SSLSocket::getEncryptionInfo() const noexcept {
 
 	string cipher = SSL_get_cipher_name(ssl);
 	string protocol = SSL_get_version(ssl);
-	return protocol + " / " + cipher;
+	auto ret = protocol + " / " + cipher;
+
+	// Resumption statistics of all connections
+	auto stats = CryptoManager::getInstance()->getSessionStats();
+	ret += SSL_session_reused(ssl) ? " (resumed, " : " (";
+	ret += Util::toString(stats.resumedHandshakes) + "/" + Util::toString(stats.fullHandshakes + stats.resumedHandshakes) + " handshakes resumed)";
+	return ret;
 }
 
 ByteVector SSLSocket::getKeyprint() const noexcept {
@@ -19,9 +19,15 @@
 #ifndef DCPLUSPLUS_DCPP_SPEAKER_H
 #define DCPLUSPLUS_DCPP_SPEAKER_H
 
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <tuple>
+#include <typeinfo>
 #include <utility>
 #include <vector>
 
+#include <airdcpp/core/SpeakerStats.h>
 #include <airdcpp/core/thread/CriticalSection.h>
 #include <airdcpp/core/header/debug.h>
 
@@ -29,65 +35,215 @@ namespace dcpp {
 
 using std::vector;
 
+// Number of listener lists that are being dispatched by the current thread
+inline thread_local int speakerDispatchDepth = 0;
+
+// Event dispatching doesn't take any locks
+//
+// Listeners are called from an immutable snapshot of the listener list that gets replaced whenever listeners are
+// added or removed. Removing a listener will block until the listener is no longer being called by other threads.
+// When a listener is removed from inside a callback (of any speaker), the call won't block: the listener is skipped by
+// the dispatches that are already running but another thread may still be inside its callback after the call returns.
 template<typename Listener>
 class Speaker {
-	typedef vector<Listener*> ListenerList;
+	struct ListenerEntry {
+		explicit ListenerEntry(Listener* aListener) noexcept : listener(aListener) { }
+
+		Listener* const listener;
+
+		// Set when the listener is removed so that the snapshots that are being dispatched will skip it
+		std::atomic<bool> removed = false;
+	};
+
+	using ListenerEntryPtr = std::shared_ptr<ListenerEntry>;
+	using ListenerList = vector<ListenerEntryPtr>;
+	using ListenerListPtr = std::shared_ptr<const ListenerList>;
 
 public:
-	Speaker() noexcept { }
-	virtual ~Speaker() { 
-		dcassert(listeners.empty());
+	Speaker() noexcept : listeners(makeList(ListenerList())) { }
+	virtual ~Speaker() {
+		dcassert(listeners.load()->empty());
 	}
 
 	template<typename... ArgT>
 	void fire(ArgT&&... args) noexcept {
-		Lock l(listenerCS);
-		tmpListeners = listeners;
-		for(auto listener: tmpListeners) {
-			listener->on(std::forward<ArgT>(args)...);
-		}
+		dispatchListeners<false>(std::forward<ArgT>(args)...);
 	}
-	
-	// Fire listeners in a reversed order 
+
+	// Fire listeners in a reversed order
 	// (e.g. during a shutdown sequence the listeners that were added last should be uninitialized first)
 	template<typename... ArgT>
 	void fireReversed(ArgT&&... args) noexcept {
-		Lock l(listenerCS);
-		tmpListeners = listeners;
-		for (auto listener : tmpListeners | views::reverse) {
-			listener->on(std::forward<ArgT>(args)...);
-		}
+		dispatchListeners<true>(std::forward<ArgT>(args)...);
 	}
 
 	void addListener(Listener* aListener) noexcept {
 		Lock l(listenerCS);
-		if(ranges::find(listeners, aListener) == listeners.end())
-			listeners.push_back(aListener);
+		auto current = listeners.load();
+		if (findListener(*current, aListener) != current->end()) {
+			return;
+		}
+
+		auto newListeners = *current;
+		newListeners.push_back(std::make_shared<ListenerEntry>(aListener));
+		replaceListeners(std::move(current), makeList(std::move(newListeners)));
 	}
 
+	// Blocks until the listener isn't being called by other threads (unless called from a listener callback)
 	void removeListener(Listener* aListener) noexcept {
-		Lock l(listenerCS);
-		auto it = ranges::find(listeners, aListener);
-		if(it != listeners.end())
-			listeners.erase(it);
+		vector<std::weak_ptr<const ListenerList>> inUse;
+
+		{
+			Lock l(listenerCS);
+			auto current = listeners.load();
+			auto i = findListener(*current, aListener);
+			if (i == current->end()) {
+				return;
+			}
+
+			auto entry = *i;
+			entry->removed.store(true, std::memory_order_release);
+
+			auto newListeners = *current;
+			std::erase(newListeners, entry);
+			replaceListeners(std::move(current), makeList(std::move(newListeners)));
+
+			for (const auto& retired: retiredListeners) {
+				if (auto r = retired.lock(); r && ranges::find(*r, entry) != r->end()) {
+					inUse.push_back(retired);
+				}
+			}
+		}
+
+		waitReleased(inUse);
 	}
 
 	bool hasListener(Listener* aListener) const noexcept {
-		Lock l(listenerCS);
-		return ranges::find(listeners, aListener) != listeners.end();
+		auto current = listeners.load();
+		return findListener(*current, aListener) != current->end();
+	}
+
+	bool hasListeners() const noexcept {
+		return !listeners.load()->empty();
 	}
 
+	// Blocks until none of the listeners are being called by other threads (unless called from a listener callback)
 	void removeListeners() noexcept {
-		Lock l(listenerCS);
-		listeners.clear();
+		vector<std::weak_ptr<const ListenerList>> inUse;
+
+		{
+			Lock l(listenerCS);
+			auto current = listeners.load();
+			for (const auto& entry: *current) {
+				entry->removed.store(true, std::memory_order_release);
+			}
+
+			replaceListeners(std::move(current), makeList(ListenerList()));
+			inUse = retiredListeners;
+		}
+
+		waitReleased(inUse);
 	}
-	
+
 protected:
-	ListenerList listeners;
-	ListenerList tmpListeners;
+	template<bool Reversed, typename... ArgT>
+	void dispatchListeners(ArgT&&... args) noexcept {
+		using EventT = std::decay_t<std::tuple_element_t<0, std::tuple<ArgT...>>>;
+		static SpeakerEventStats& stats = SpeakerStats::getEvent(typeid(EventT).name());
+
+		stats.dispatches.fetch_add(1, std::memory_order_relaxed);
+
+		auto current = listeners.load();
+		if (current->empty()) {
+			return;
+		}
+
+		dispatchList<Reversed>(*current, stats, std::forward<ArgT>(args)...);
+	}
+
+	template<bool Reversed, typename... ArgT>
+	void dispatchList(const ListenerList& aListeners, SpeakerEventStats& aStats, ArgT&&... args) noexcept {
+		aStats.listenerCalls.fetch_add(aListeners.size(), std::memory_order_relaxed);
+
+		const auto trackLatency = SpeakerStats::isLatencyTracking();
+		const auto start = trackLatency ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+
+		speakerDispatchDepth++;
+		if constexpr (Reversed) {
+			for (const auto& entry: aListeners | views::reverse) {
+				if (!entry->removed.load(std::memory_order_acquire)) {
+					entry->listener->on(std::forward<ArgT>(args)...);
+				}
+			}
+		} else {
+			for (const auto& entry: aListeners) {
+				if (!entry->removed.load(std::memory_order_acquire)) {
+					entry->listener->on(std::forward<ArgT>(args)...);
+				}
+			}
+		}
+		speakerDispatchDepth--;
+
+		if (trackLatency) {
+			auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+			aStats.addLatency(static_cast<uint64_t>(elapsed.count()));
+		}
+	}
+
+	static typename ListenerList::const_iterator findListener(const ListenerList& aListeners, Listener* aListener) noexcept {
+		return ranges::find_if(aListeners, [aListener](const auto& aEntry) { return aEntry->listener == aListener; });
+	}
+
+	// Waiters are woken up whenever the last reference to a list is released (by a dispatch or anyone else)
+	ListenerListPtr makeList(ListenerList&& aListeners) noexcept {
+		return ListenerListPtr(new ListenerList(std::move(aListeners)), [this](const ListenerList* aList) {
+			delete aList;
+
+			releaseCounter.fetch_add(1);
+			releaseCounter.notify_all();
+		});
+	}
+
+	// Must be called with listenerCS held
+	void replaceListeners(ListenerListPtr&& aOld, ListenerListPtr&& aNew) noexcept {
+		std::erase_if(retiredListeners, [](const auto& r) { return r.expired(); });
+		retiredListeners.emplace_back(aOld);
+		listeners.store(std::move(aNew));
+	}
+
+	// Waits until the lists are no longer being dispatched by other threads
+	void waitReleased(const vector<std::weak_ptr<const ListenerList>>& aLists) noexcept {
+		if (speakerDispatchDepth > 0) {
+			// Lists that are being dispatched by the current thread would never be released and
+			// other threads may be waiting for our own callbacks to return
+			return;
+		}
+
+		for (const auto& list: aLists) {
+			for (;;) {
+				auto released = releaseCounter.load();
+				if (list.expired()) {
+					break;
+				}
+
+				releaseCounter.wait(released);
+			}
+		}
+	}
+
+	// Incremented when a list is destroyed
+	// (declared before the lists as the deleter of the lists uses it)
+	std::atomic<uint32_t> releaseCounter = 0;
+
+	std::atomic<ListenerListPtr> listeners;
+
+	// Lists that have been replaced but may still be dispatched by other threads
+	vector<std::weak_ptr<const ListenerList>> retiredListeners;
+
+	// Serializes modifications
 	mutable CriticalSection listenerCS;
 };
 
 } // namespace dcpp
 
-#endif // !defined(SPEAKER_H)
\ No newline at end of file
+#endif // !defined(SPEAKER_H)
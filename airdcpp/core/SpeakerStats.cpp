@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2011-2024 AirDC++ Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "stdinc.h"
+#include <airdcpp/core/SpeakerStats.h>
+
+#include <airdcpp/core/thread/CriticalSection.h>
+
+namespace dcpp {
+
+atomic<bool> SpeakerStats::latencyTracking { false };
+
+namespace {
+	// Function statics so that the registry is available for speakers that fire during static initialization
+	CriticalSection& getRegistryCS() noexcept {
+		static CriticalSection cs;
+		return cs;
+	}
+
+	map<string, unique_ptr<SpeakerEventStats>>& getRegistry() noexcept {
+		static map<string, unique_ptr<SpeakerEventStats>> events;
+		return events;
+	}
+}
+
+void SpeakerEventStats::addLatency(uint64_t aMicroseconds) noexcept {
+	auto bucket = min(static_cast<size_t>(bit_width(aMicroseconds)), LATENCY_BUCKETS - 1);
+	latency[bucket].fetch_add(1, memory_order_relaxed);
+}
+
+SpeakerEventStats& SpeakerStats::getEvent(const char* aTypeName) noexcept {
+	Lock l(getRegistryCS());
+	auto& stats = getRegistry()[aTypeName];
+	if (!stats) {
+		stats = make_unique<SpeakerEventStats>();
+	}
+
+	return *stats;
+}
+
+vector<SpeakerStats::Event> SpeakerStats::getEvents() noexcept {
+	vector<Event> ret;
+
+	Lock l(getRegistryCS());
+	for (const auto& [name, stats]: getRegistry()) {
+		auto dispatches = stats->dispatches.load(memory_order_relaxed);
+		if (dispatches == 0) {
+			continue;
+		}
+
+		Event e { name, dispatches, stats->listenerCalls.load(memory_order_relaxed), {} };
+		for (size_t i = 0; i < SpeakerEventStats::LATENCY_BUCKETS; ++i) {
+			e.latency[i] = stats->latency[i].load(memory_order_relaxed);
+		}
+
+		ret.push_back(std::move(e));
+	}
+
+	return ret;
+}
+
+} // namespace dcpp
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2011-2024 AirDC++ Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef DCPLUSPLUS_DCPP_SPEAKER_STATS_H
+#define DCPLUSPLUS_DCPP_SPEAKER_STATS_H
+
+#include <array>
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace dcpp {
+
+// Dispatch counters of a single listener event type
+struct SpeakerEventStats {
+	// Latency buckets, bucket N contains dispatches that took less than 2^N microseconds
+	// (the last bucket contains everything slower than that)
+	static const size_t LATENCY_BUCKETS = 24;
+
+	std::atomic<uint64_t> dispatches { 0 };
+	std::atomic<uint64_t> listenerCalls { 0 };
+	std::array<std::atomic<uint64_t>, LATENCY_BUCKETS> latency {};
+
+	void addLatency(uint64_t aMicroseconds) noexcept;
+};
+
+// Registry of the event dispatch statistics for all speakers
+class SpeakerStats {
+public:
+	struct Event {
+		std::string name;
+		uint64_t dispatches;
+		uint64_t listenerCalls;
+		std::array<uint64_t, SpeakerEventStats::LATENCY_BUCKETS> latency;
+	};
+
+	// Returns the counters for the event type, the returned reference remains valid until the process exits
+	static SpeakerEventStats& getEvent(const char* aTypeName) noexcept;
+
+	// Returns a copy of the current counters (events with no dispatches are skipped)
+	static std::vector<Event> getEvents() noexcept;
+
+	// Latency measurement is disabled by default as it requires reading the clock twice for each dispatch
+	static bool isLatencyTracking() noexcept {
+		return latencyTracking.load(std::memory_order_relaxed);
+	}
+
+	static void setLatencyTracking(bool aEnabled) noexcept {
+		latencyTracking.store(aEnabled, std::memory_order_relaxed);
+	}
+private:
+	static std::atomic<bool> latencyTracking;
+};
+
+} // namespace dcpp
+
+#endif // !defined(DCPLUSPLUS_DCPP_SPEAKER_STATS_H)
@@ -80,6 +80,26 @@ public:
 		return { p.first, true };
 	}
 
+	// Appends the item without keeping the order, sort_unique must be called before the container is accessed by key
+	// Avoids moving the existing items when a large number of unsorted items is being added
+	template<typename... ArgT>
+	void emplace_unsorted(ArgT&& ... args) {
+		ContainerT<T>::emplace_back(std::forward<ArgT>(args)...);
+	}
+
+	// Sorts the items added with emplace_unsorted
+	// Returns the first item that has a duplicate key (or end if all keys are unique)
+	typename ContainerT<T>::const_iterator sort_unique() {
+		auto less = [](const T& a, const T& b) { return SortOperator()(NameOperator()(a), NameOperator()(b)) < 0; };
+		if (!std::is_sorted(ContainerT<T>::begin(), ContainerT<T>::end(), less)) {
+			std::sort(ContainerT<T>::begin(), ContainerT<T>::end(), less);
+		}
+
+		return std::adjacent_find(ContainerT<T>::cbegin(), ContainerT<T>::cend(), [](const T& a, const T& b) {
+			return SortOperator()(NameOperator()(a), NameOperator()(b)) == 0;
+		});
+	}
+
 	typename ContainerT<T>::const_iterator find(const keyType& aKey) const {
 		auto pos = getPos(ContainerT<T>::cbegin(), ContainerT<T>::cend(), aKey);
 		return pos.second ? pos.first : ContainerT<T>::cend();
@@ -90,6 +110,10 @@ public:
 		return pos.second ? pos.first : ContainerT<T>::end();
 	}
 
+	bool contains(const keyType& aKey) const {
+		return getPos(ContainerT<T>::cbegin(), ContainerT<T>::cend(), aKey).second;
+	}
+
 	bool erase_key(const keyType& aKey) {
 		auto pos = getPos(ContainerT<T>::begin(), ContainerT<T>::end(), aKey);
 		if (pos.second) {
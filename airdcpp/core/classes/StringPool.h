@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2011-2024 AirDC++ Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef DCPLUSPLUS_DCPP_STRINGPOOL_H
+#define DCPLUSPLUS_DCPP_STRINGPOOL_H
+
+#include <airdcpp/core/header/typedefs.h>
+#include <airdcpp/core/classes/Pointer.h>
+
+namespace dcpp {
+
+/* Append-only storage for strings that are freed together with the pool. The strings are copied in large blocks,
+which avoids the string object overhead and a separate allocation for each string. Not thread safe. */
+
+class StringPool : boost::noncopyable {
+public:
+	StringPool() = default;
+	StringPool(StringPool&& aPool) = default;
+
+	// Returns a null-terminated copy of the string that stays valid until the pool is destroyed
+	string_view add(string_view aStr) noexcept {
+		const auto len = aStr.size() + 1;
+		if (len > left) {
+			if (len > BLOCK_SIZE / 4) {
+				// Don't waste the current block
+				return copy(allocateBlock(len), aStr);
+			}
+
+			pos = allocateBlock(BLOCK_SIZE);
+			left = BLOCK_SIZE;
+		}
+
+		auto ret = copy(pos, aStr);
+		pos += len;
+		left -= len;
+		return ret;
+	}
+
+private:
+	static const size_t BLOCK_SIZE = 64 * 1024;
+
+	static string_view copy(char* dest_, string_view aStr) noexcept {
+		memcpy(dest_, aStr.data(), aStr.size());
+		dest_[aStr.size()] = '\0';
+		return { dest_, aStr.size() };
+	}
+
+	char* allocateBlock(size_t aSize) noexcept {
+		blocks.push_back(make_unique_for_overwrite<char[]>(aSize));
+		return blocks.back().get();
+	}
+
+	vector<unique_ptr<char[]>> blocks;
+	char* pos = nullptr;
+	size_t left = 0;
+};
+
+// Pool that is freed when the last object referencing its strings is destroyed
+class SharedStringPool : public StringPool, public intrusive_ptr_base<SharedStringPool> {
+
+};
+
+using SharedStringPoolPtr = boost::intrusive_ptr<SharedStringPool>;
+
+}
+
+#endif
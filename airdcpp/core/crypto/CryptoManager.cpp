@@ -34,6 +34,10 @@
 #include <openssl/rsa.h>
 
 
+#if OPENSSL_VERSION_NUMBER < 0x30000000L
+#   define SSL_get1_peer_certificate SSL_get_peer_certificate
+#endif
+
 namespace dcpp {
 
 int CryptoManager::idxVerifyData = 0;
@@ -63,6 +67,20 @@ CryptoManager::CryptoManager()
 
 		SSL_CTX_set_verify(clientContext, SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT, verify_callback);
 		SSL_CTX_set_verify(serverContext, SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT, verify_callback);
+
+		// Session resumption
+		// Client sessions are stored in our own cache (see setCachedSession), the server uses the internal cache 
+		// and session tickets
+		SSL_CTX_set_session_cache_mode(clientContext, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+		SSL_CTX_sess_set_new_cb(clientContext, newSessionCallback);
+
+		// Peer certificates are verified so the context must be set for resumption to work
+		const unsigned char sessionIdContext[] = "AirDC++";
+		SSL_CTX_set_session_id_context(serverContext, sessionIdContext, sizeof(sessionIdContext) - 1);
+#if OPENSSL_VERSION_NUMBER >= 0x1010100fL
+		// Only a single session is cached for each peer
+		SSL_CTX_set_num_tickets(serverContext, 1);
+#endif
 	}
 }
 
@@ -140,10 +158,125 @@ void CryptoManager::setContextOptions(SSL_CTX* aCtx, bool aServer) noexcept {
 }
 
 CryptoManager::~CryptoManager() {
+	clearSessionCache();
+
 	clientContext.reset();
 	serverContext.reset();
 }
 
+int CryptoManager::newSessionCallback(::SSL* aSSL, SSL_SESSION* aSession) {
+	// Don't resume sessions with peers that didn't pass the verification
+	if (SSL_get_verify_result(aSSL) != X509_V_OK || !SSL_SESSION_is_resumable(aSession)) {
+		return 0;
+	}
+
+	// The verify data has been cleared after a successful keyprint validation, use the keyprint of the certificate
+	auto cert = SSL_get1_peer_certificate(aSSL);
+	if (!cert) {
+		return 0;
+	}
+
+	auto kp = ssl::X509_digest(cert, EVP_sha256());
+	X509_free(cert);
+	if (kp.empty()) {
+		return 0;
+	}
+
+	// The reference is taken over by the cache
+	getInstance()->cacheSession(keyprintToString(kp), aSession);
+	return 1;
+}
+
+void CryptoManager::cacheSession(const string& aKeyprint, SSL_SESSION* aSession) noexcept {
+	Lock l(sessionCS);
+	if (auto i = sessionIndex.find(aKeyprint); i != sessionIndex.end()) {
+		SSL_SESSION_free(i->second->second);
+		sessions.erase(i->second);
+		sessionIndex.erase(i);
+	}
+
+	sessions.emplace_front(aKeyprint, aSession);
+	sessionIndex[aKeyprint] = sessions.begin();
+
+	if (sessions.size() > MAX_CACHED_SESSIONS) {
+		SSL_SESSION_free(sessions.back().second);
+		sessionIndex.erase(sessions.back().first);
+		sessions.pop_back();
+	}
+}
+
+void CryptoManager::setCachedSession(::SSL* aSSL, const string& aKeyprint) noexcept {
+	if (aKeyprint.empty()) {
+		return;
+	}
+
+	SSL_SESSION* session = nullptr;
+
+	{
+		Lock l(sessionCS);
+		auto i = sessionIndex.find(aKeyprint);
+		if (i == sessionIndex.end()) {
+			return;
+		}
+
+		session = i->second->second;
+
+		auto expires = static_cast<time_t>(SSL_SESSION_get_time(session)) + static_cast<time_t>(SSL_SESSION_get_timeout(session));
+		auto singleUse = SSL_SESSION_get_protocol_version(session) == TLS1_3_VERSION;
+
+		// OpenSSL invalidates the session if the connection that received it wasn't shut down properly
+		auto invalid = expires < GET_TIME() || !SSL_SESSION_is_resumable(session);
+		if (singleUse || invalid) {
+			// TLS 1.3 tickets shouldn't be reused, the server will send a new one
+			sessions.erase(i->second);
+			sessionIndex.erase(i);
+
+			if (invalid) {
+				SSL_SESSION_free(session);
+				return;
+			}
+		} else {
+			// Move to front
+			sessions.splice(sessions.begin(), sessions, i->second);
+			SSL_SESSION_up_ref(session);
+		}
+	}
+
+	SSL_set_session(aSSL, session);
+	SSL_SESSION_free(session);
+}
+
+void CryptoManager::onHandshakeCompleted(::SSL* aSSL) noexcept {
+	if (SSL_session_reused(aSSL)) {
+		resumedHandshakes++;
+	} else {
+		fullHandshakes++;
+	}
+}
+
+CryptoManager::SessionStats CryptoManager::getSessionStats() const noexcept {
+	SessionStats ret;
+	ret.fullHandshakes = fullHandshakes;
+	ret.resumedHandshakes = resumedHandshakes;
+
+	{
+		Lock l(sessionCS);
+		ret.cachedSessions = sessions.size();
+	}
+
+	return ret;
+}
+
+void CryptoManager::clearSessionCache() noexcept {
+	Lock l(sessionCS);
+	for (const auto& s: sessions | views::values) {
+		SSL_SESSION_free(s);
+	}
+
+	sessions.clear();
+	sessionIndex.clear();
+}
+
 string CryptoManager::keyprintToString(const ByteVector& aKP) noexcept {
 	return "SHA256/" + Encoder::toBase32(&aKP[0], aKP.size());
 }
@@ -22,6 +22,7 @@
 #include <airdcpp/message/Message.h>
 #include <airdcpp/core/Singleton.h>
 #include <airdcpp/core/crypto/SSL.h>
+#include <airdcpp/core/thread/CriticalSection.h>
 
 //This is for earlier OpenSSL versions that don't have this error code yet..
 #ifndef X509_V_ERR_UNSPECIFIED
@@ -71,6 +72,22 @@ public:
 	// Options that can also be shared with external contexts
 	static void setContextOptions(SSL_CTX* aSSL, bool aServer) noexcept;
 	static string keyprintToString(const ByteVector& aKP) noexcept;
+
+	struct SessionStats {
+		int64_t fullHandshakes = 0;
+		int64_t resumedHandshakes = 0;
+		size_t cachedSessions = 0;
+	};
+
+	// Client sessions with verified peers are cached by the keyprint of the peer certificate so that
+	// reconnections to the same user or hub can skip the full handshake
+	// Sets a cached session for the connection if one is available for the expected keyprint
+	void setCachedSession(::SSL* aSSL, const string& aKeyprint) noexcept;
+	void onHandshakeCompleted(::SSL* aSSL) noexcept;
+
+	SessionStats getSessionStats() const noexcept;
+
+	static const size_t MAX_CACHED_SESSIONS = 1000;
 private:
 	friend class Singleton<CryptoManager>;
 
@@ -87,6 +104,19 @@ private:
 
 	static int getKeyLength(TLSTmpKeys key) noexcept;
 
+	static int newSessionCallback(::SSL* aSSL, SSL_SESSION* aSession);
+	void cacheSession(const string& aKeyprint, SSL_SESSION* aSession) noexcept;
+	void clearSessionCache() noexcept;
+
+	// Least recently used sessions are at the end
+	using SessionList = std::list<pair<string, SSL_SESSION*>>;
+	SessionList sessions;
+	unordered_map<string, SessionList::iterator> sessionIndex;
+	mutable CriticalSection sessionCS;
+
+	atomic<int64_t> fullHandshakes { 0 };
+	atomic<int64_t> resumedHandshakes { 0 };
+
 	bool certsLoaded = false;
 
 	static char idxVerifyDataName[];
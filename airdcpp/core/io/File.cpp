@@ -41,6 +41,10 @@
 #include <fcntl.h>
 #endif
 
+#ifdef HAVE_SYNC_FILE_RANGE
+#include <fcntl.h>
+#endif
+
 #ifdef HAVE_MNTENT_H
 #include <mntent.h>
 #endif
@@ -167,11 +171,22 @@ int64_t File::getPos() const noexcept {
 }
 
 void File::setSize(int64_t newSize) {
-	int64_t pos = getPos();
-	setPos(newSize);
-	setEOF();
-	setPos(pos);
+	// Positional reads and writes move the file pointer as well, don't rely on it
+	FILE_END_OF_FILE_INFO info;
+	info.EndOfFile.QuadPart = newSize;
+	if (!::SetFileInformationByHandle(h, FileEndOfFileInfo, &info, sizeof(info))) {
+		throw FileException(SystemUtil::translateError(GetLastError()));
+	}
 }
+void File::preallocate(int64_t aSize) {
+	// Setting the end of file allocates the clusters
+	setSize(aSize);
+}
+
+void File::dropCache(int64_t /*aPos*/, int64_t /*aLen*/) noexcept {
+	// Not supported
+}
+
 void File::setPos(int64_t pos) noexcept {
 	LONG x = (LONG) (pos>>32);
 	::SetFilePointer(h, (DWORD)(pos & 0xffffffff), &x, FILE_BEGIN);
@@ -203,6 +218,39 @@ size_t File::write(const void* buf, size_t len) {
 	dcassert(x == len);
 	return x;
 }
+
+size_t File::readAt(void* buf, size_t len, int64_t aPos) {
+	OVERLAPPED ov = { 0 };
+	ov.Offset = (DWORD)(aPos & 0xffffffff);
+	ov.OffsetHigh = (DWORD)(aPos >> 32);
+
+	DWORD x;
+	if (!::ReadFile(h, buf, (DWORD)len, &x, &ov)) {
+		auto error = GetLastError();
+		if (error == ERROR_HANDLE_EOF) {
+			return 0;
+		}
+
+		throw FileException(SystemUtil::translateError(error));
+	}
+
+	return x;
+}
+
+size_t File::writeAt(const void* buf, size_t len, int64_t aPos) {
+	OVERLAPPED ov = { 0 };
+	ov.Offset = (DWORD)(aPos & 0xffffffff);
+	ov.OffsetHigh = (DWORD)(aPos >> 32);
+
+	DWORD x;
+	if (!::WriteFile(h, buf, (DWORD)len, &x, &ov)) {
+		throw FileException(SystemUtil::translateError(GetLastError()));
+	}
+
+	dcassert(x == len);
+	return x;
+}
+
 void File::setEOF() {
 	dcassert(isOpen());
 	if(!SetEndOfFile(h)) {
@@ -511,6 +559,38 @@ size_t File::write(const void* buf, size_t len) {
 	return len;
 }
 
+size_t File::readAt(void* buf, size_t len, int64_t aPos) {
+	ssize_t result;
+	do {
+		result = ::pread(h, buf, len, (off_t)aPos);
+	} while (result == -1 && errno == EINTR);
+
+	if (result == -1) {
+		throw FileException(SystemUtil::translateError(errno));
+	}
+
+	return (size_t)result;
+}
+
+size_t File::writeAt(const void* buf, size_t len, int64_t aPos) {
+	auto pointer = (const char*)buf;
+	size_t left = len;
+
+	while (left > 0) {
+		auto result = ::pwrite(h, pointer, left, (off_t)aPos);
+		if (result == -1) {
+			if (errno != EINTR) {
+				throw FileException(SystemUtil::translateError(errno));
+			}
+		} else {
+			pointer += result;
+			aPos += result;
+			left -= result;
+		}
+	}
+	return len;
+}
+
 // some ftruncate implementations can't extend files like SetEndOfFile,
 // not sure if the client code needs this...
 int File::extendFile(int64_t len) noexcept {
@@ -539,10 +619,41 @@ void File::setEOF() {
 }
 
 void File::setSize(int64_t newSize) {
-	int64_t pos = getPos();
-	setPos(newSize);
-	setEOF();
-	setPos(pos);
+	// Doesn't touch the file position (extended files are sparse)
+	if (ftruncate(h, (off_t)newSize) == -1) {
+		throw FileException(SystemUtil::translateError(errno));
+	}
+}
+
+void File::preallocate(int64_t aSize) {
+#ifdef HAVE_POSIX_FALLOCATE
+	auto ret = posix_fallocate(h, 0, (off_t)aSize);
+	if (ret == 0) {
+		// Allocation doesn't shrink existing files
+		if (getSize() > aSize) {
+			setSize(aSize);
+		}
+
+		return;
+	}
+
+	if (ret != EOPNOTSUPP && ret != EINVAL) {
+		throw FileException(SystemUtil::translateError(ret));
+	}
+#endif
+
+	setSize(aSize);
+}
+
+void File::dropCache(int64_t aPos, int64_t aLen) noexcept {
+#ifdef HAVE_SYNC_FILE_RANGE
+	// Dirty pages aren't dropped, write them first
+	sync_file_range(h, (off_t)aPos, (off_t)aLen, SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+#endif
+
+#ifdef HAVE_POSIX_FADVISE
+	posix_fadvise(h, (off_t)aPos, (off_t)aLen, POSIX_FADV_DONTNEED);
+#endif
 }
 
 size_t File::flushBuffers(bool aForce) {
@@ -113,6 +113,14 @@ public:
 	int64_t getSize() const noexcept override;
 	void setSize(int64_t newSize);
 
+	// Reserves the disk space and sets the file size
+	// Falls back to setSize if the file system doesn't support allocation
+	void preallocate(int64_t aSize);
+
+	// Writes the range on disk (when supported) and advises the system to drop it from the page cache
+	// Blocks until the data has been written
+	void dropCache(int64_t aPos, int64_t aLen) noexcept;
+
 	int64_t getPos() const noexcept;
 	void setPos(int64_t pos) noexcept override;
 	void setEndPos(int64_t pos) noexcept;
@@ -125,6 +133,11 @@ public:
 	size_t read(void* buf, size_t& len) override;
 	size_t write(const void* buf, size_t len) override;
 
+	// Positional I/O, the result doesn't depend on the current file position
+	// These may be called concurrently for the same handle
+	size_t readAt(void* buf, size_t len, int64_t aPos);
+	size_t writeAt(const void* buf, size_t len, int64_t aPos);
+
 	// This has no effect if aForce is false
 	// Generally the operating system should decide when the buffered data is written on disk
 	size_t flushBuffers(bool aForce = true) override;
@@ -21,6 +21,9 @@
 
 #include <airdcpp/core/classes/Exception.h>
 #include <airdcpp/core/localization/ResourceManager.h>
+#include <airdcpp/core/thread/concurrency.h>
+
+#include <thread>
 
 namespace dcpp {
 	
@@ -142,4 +145,284 @@ void BZUtil::decodeBZ2(const uint8_t* is, size_t sz, string& os) {
 	}
 }
 
-} // namespace dcpp
\ No newline at end of file
+namespace {
+
+// Markers are located at arbitrary bit positions (blocks aren't byte-aligned)
+const uint64_t BLOCK_MAGIC = 0x314159265359ULL;
+const uint64_t EOS_MAGIC = 0x177245385090ULL;
+const int MAGIC_BITS = 48;
+const int CRC_BITS = 32;
+
+// Bit scanning is split in ranges of this size
+const size_t MARKER_SCAN_RANGE = 4 * 1024 * 1024;
+
+// Number of blocks to decompress in a single batch for each CPU thread
+// (limits the number of decompressed blocks kept in memory in addition to the output)
+const size_t BLOCKS_PER_THREAD = 2;
+
+// The compressor starts a new block when the current one has (level * 100k - 19) bytes after the initial run-length encoding
+// Decoding the runs expands the data, except that runs of exactly four bytes are stored in five bytes
+uint64_t getMinFullBlockOutput(char aLevel) noexcept {
+	return (static_cast<uint64_t>(aLevel - '0') * 100000 - 19) * 4 / 5;
+}
+
+struct BZMarker {
+	uint64_t bitPos;
+	bool eos;
+};
+
+using BZMarkerList = vector<BZMarker>;
+
+class BitReader {
+public:
+	BitReader(const uint8_t* aData, size_t aSize) : data(aData), size(aSize) { }
+
+	// Bits past the end are returned as zeros
+	uint8_t getByte(uint64_t aBitPos) const noexcept {
+		const auto pos = static_cast<size_t>(aBitPos / 8);
+		const auto shift = static_cast<int>(aBitPos % 8);
+
+		const uint16_t word = (at(pos) << 8) | at(pos + 1);
+		return static_cast<uint8_t>(word >> (8 - shift));
+	}
+
+	bool getBit(uint64_t aBitPos) const noexcept {
+		return (at(static_cast<size_t>(aBitPos / 8)) >> (7 - aBitPos % 8)) & 1;
+	}
+
+	uint64_t getWindow(size_t aPos) const noexcept {
+		uint64_t ret = 0;
+		for (size_t i = 0; i < 8; ++i) {
+			ret = (ret << 8) | at(aPos + i);
+		}
+
+		return ret;
+	}
+private:
+	uint16_t at(size_t aPos) const noexcept {
+		return aPos < size ? data[aPos] : 0;
+	}
+
+	const uint8_t* data;
+	const size_t size;
+};
+
+class BitWriter {
+public:
+	explicit BitWriter(string& aOut) : out(aOut) { }
+
+	void putBit(bool aBit) noexcept {
+		if (bits % 8 == 0) {
+			out.push_back(0);
+		}
+
+		if (aBit) {
+			out.back() |= static_cast<char>(1 << (7 - bits % 8));
+		}
+
+		bits++;
+	}
+
+	void putBits(uint64_t aValue, int aCount) noexcept {
+		for (int i = aCount - 1; i >= 0; --i) {
+			putBit((aValue >> i) & 1);
+		}
+	}
+
+	void copyBits(const BitReader& aReader, uint64_t aBitPos, uint64_t aCount) noexcept {
+		uint64_t i = 0;
+		if (bits % 8 == 0) {
+			// Copy full bytes while the output is aligned
+			for (; i + 8 <= aCount; i += 8) {
+				out.push_back(static_cast<char>(aReader.getByte(aBitPos + i)));
+			}
+
+			bits += i;
+		}
+
+		for (; i < aCount; ++i) {
+			putBit(aReader.getBit(aBitPos + i));
+		}
+	}
+private:
+	string& out;
+	uint64_t bits = 0;
+};
+
+void findMarkers(const BitReader& aReader, size_t aDataSize, size_t aBegin, size_t aEnd, BZMarkerList& markers_) noexcept {
+	const auto totalBits = static_cast<uint64_t>(aDataSize) * 8;
+	auto window = aReader.getWindow(aBegin);
+	for (auto pos = aBegin; pos < aEnd; ++pos, window = (window << 8) | aReader.getByte(static_cast<uint64_t>(pos + 7) * 8)) {
+		for (int shift = 0; shift < 8; ++shift) {
+			const auto value = (window << shift) >> (64 - MAGIC_BITS);
+			if (value != BLOCK_MAGIC && value != EOS_MAGIC) {
+				continue;
+			}
+
+			const auto bitPos = static_cast<uint64_t>(pos) * 8 + shift;
+			if (bitPos + MAGIC_BITS <= totalBits) {
+				markers_.push_back({ bitPos, value == EOS_MAGIC });
+			}
+		}
+	}
+}
+
+// Creates a standalone bzip2 stream from a single block
+// The stream CRC of a single-block stream equals with the block CRC
+string createBlockStream(const BitReader& aReader, uint64_t aBlockStart, uint64_t aBlockEnd) noexcept {
+	string ret = "BZh9";
+	ret.reserve(static_cast<size_t>((aBlockEnd - aBlockStart) / 8) + 32);
+
+	BitWriter writer(ret);
+	writer.copyBits(aReader, aBlockStart, aBlockEnd - aBlockStart);
+	writer.putBits(EOS_MAGIC, MAGIC_BITS);
+	writer.copyBits(aReader, aBlockStart + MAGIC_BITS, CRC_BITS);
+	return ret;
+}
+
+optional<string> decompressBlock(const string& aStream) noexcept {
+	bz_stream bs;
+	memzero(&bs, sizeof(bs));
+	if (BZ2_bzDecompressInit(&bs, 0, 0) != BZ_OK) {
+		return nullopt;
+	}
+
+	string ret;
+	ret.resize(aStream.size() * 8);
+
+	bs.next_in = const_cast<char*>(aStream.data());
+	bs.avail_in = static_cast<unsigned int>(aStream.size());
+
+	int err = BZ_OK;
+	size_t outPos = 0;
+	while (err == BZ_OK) {
+		if (outPos == ret.size()) {
+			ret.resize(ret.size() * 2);
+		}
+
+		bs.next_out = &ret[outPos];
+		bs.avail_out = static_cast<unsigned int>(ret.size() - outPos);
+
+		err = BZ2_bzDecompress(&bs);
+		outPos = ret.size() - bs.avail_out;
+
+		if (err == BZ_OK && bs.avail_in == 0 && bs.avail_out > 0) {
+			// Truncated
+			err = BZ_UNEXPECTED_EOF;
+		}
+	}
+
+	BZ2_bzDecompressEnd(&bs);
+	if (err != BZ_STREAM_END) {
+		return nullopt;
+	}
+
+	ret.resize(outPos);
+	return ret;
+}
+
+}
+
+optional<string> BZUtil::decodeBZ2Parallel(const string& aData, size_t aMaxSize) noexcept {
+	const BitReader reader(reinterpret_cast<const uint8_t*>(aData.data()), aData.size());
+
+	// Find the block boundaries
+	vector<BZMarkerList> rangeMarkers((aData.size() + MARKER_SCAN_RANGE - 1) / MARKER_SCAN_RANGE);
+	{
+		vector<size_t> ranges(rangeMarkers.size());
+		iota(ranges.begin(), ranges.end(), 0);
+		parallel_for_each(ranges.begin(), ranges.end(), [&](size_t aRange) {
+			const auto begin = aRange * MARKER_SCAN_RANGE;
+			findMarkers(reader, aData.size(), begin, min(begin + MARKER_SCAN_RANGE, aData.size()), rangeMarkers[aRange]);
+		});
+	}
+
+	BZMarkerList markers;
+	for (const auto& m: rangeMarkers) {
+		markers.insert(markers.end(), m.begin(), m.end());
+	}
+
+	// The first block follows the stream header
+	if (aData.compare(0, 3, "BZh") != 0 || aData[3] < '1' || aData[3] > '9' || markers.empty() || markers.front().bitPos != 32 || markers.front().eos) {
+		return nullopt;
+	}
+
+	vector<pair<uint64_t, uint64_t>> blocks;
+	uint64_t fullBlocks = 0;
+	for (size_t i = 0; i + 1 < markers.size(); ++i) {
+		if (!markers[i].eos) {
+			blocks.emplace_back(markers[i].bitPos, markers[i + 1].bitPos);
+
+			// Blocks that are followed by another block of the same stream are full
+			if (!markers[i + 1].eos) {
+				fullBlocks++;
+			}
+		}
+	}
+
+	if (blocks.size() < 2) {
+		return nullopt;
+	}
+
+	// Don't decompress anything if the output is known to be too large
+	if (fullBlocks * getMinFullBlockOutput(aData[3]) > aMaxSize) {
+		return nullopt;
+	}
+
+	// Decompress
+	const auto batchSize = static_cast<size_t>(max(std::thread::hardware_concurrency(), 1U)) * BLOCKS_PER_THREAD;
+
+	string ret;
+	vector<optional<string>> output;
+	vector<size_t> blockIndexes;
+	for (size_t batchStart = 0; batchStart < blocks.size(); batchStart += batchSize) {
+		const auto batchEnd = min(batchStart + batchSize, blocks.size());
+
+		blockIndexes.resize(batchEnd - batchStart);
+		iota(blockIndexes.begin(), blockIndexes.end(), batchStart);
+
+		output.assign(blockIndexes.size(), nullopt);
+		parallel_for_each(blockIndexes.begin(), blockIndexes.end(), [&](size_t aBlock) {
+			const auto& [start, end] = blocks[aBlock];
+			output[aBlock - batchStart] = decompressBlock(createBlockStream(reader, start, end));
+		});
+
+		size_t batchOutputSize = 0;
+		for (const auto& o: output) {
+			if (!o) {
+				// Most likely a marker sequence inside compressed data (the decompressor validates the block CRCs)
+				dcdebug("BZUtil::decodeBZ2Parallel: failed to decompress a block\n");
+				return nullopt;
+			}
+
+			batchOutputSize += o->size();
+		}
+
+		if (ret.size() + batchOutputSize > aMaxSize) {
+			return nullopt;
+		}
+
+		if (batchStart == 0) {
+			// Estimate the total size based on the compression ratio of the first batch
+			// Give up early if the output is likely to be too large instead of finding it out after decompressing most of the data
+			const auto batchBits = static_cast<double>(blocks[batchEnd - 1].second - blocks[batchStart].first);
+			const auto totalBits = static_cast<double>(blocks.back().second - blocks.front().first);
+			const auto estimate = static_cast<double>(batchOutputSize) * (totalBits / batchBits);
+			if (estimate > static_cast<double>(aMaxSize)) {
+				return nullopt;
+			}
+
+			// Reserve some extra so that the output won't need to be reallocated
+			ret.reserve(static_cast<size_t>(min(estimate * 1.1, static_cast<double>(aMaxSize))));
+		}
+
+		for (auto& o: output) {
+			ret += *o;
+			o.reset();
+		}
+	}
+
+	return ret;
+}
+
+} // namespace dcpp
@@ -60,6 +60,14 @@ private:
 class BZUtil {
 public:
 	static void decodeBZ2(const uint8_t* is, size_t sz, string& os);
+
+	// Decompresses a complete bzip2 file
+	// The data is split at block boundaries and the blocks are decompressed in parallel batches that are appended to the output as they finish
+	// Returns nullopt if the data can't be split into blocks, a block can't be decompressed or the output would exceed aMaxSize
+	// (the data should be decompressed as a stream in such cases)
+	// The output size is estimated from the number of full blocks before decompressing and from the compression ratio of the first batch,
+	// so that oversized data is normally rejected before most of it has been decompressed
+	static optional<string> decodeBZ2Parallel(const string& aData, size_t aMaxSize) noexcept;
 };
 
 } // namespace dcpp
@@ -80,6 +80,9 @@ public:
 	// TODO 64-bits?
 	void operator()(const void* buf, size_t len) { crc = crc32(crc, (const Bytef*)buf, (uInt)len); }
 	uint32_t getValue() const { return crc; }
+
+	// Returns the checksum of concatenated data blocks
+	static uint32_t combine(uint32_t aCRC1, uint32_t aCRC2, int64_t aLen2) { return crc32_combine(aCRC1, aCRC2, (z_off_t)aLen2); }
 private:
 	uint32_t crc;
 };
@@ -34,6 +34,30 @@ class DbSnapshot {
 
 };
 
+// Collects write operations that will be committed with a single database write
+class DbWriteBatch {
+public:
+	virtual void put(void* aKey, size_t keyLen, void* aValue, size_t valueLen) = 0;
+	virtual void remove(void* aKey, size_t keyLen) = 0;
+
+	// Number of queued operations
+	virtual size_t size() const noexcept = 0;
+	bool empty() const noexcept { return size() == 0; }
+
+	virtual ~DbWriteBatch() { }
+};
+
+using DbKeyList = std::vector<std::pair<void*, size_t>>;
+
+// Key range [start, end), an empty key means that the range isn't limited from that side
+struct DbKeyRange {
+	string start;
+	string end;
+};
+
+using DbKeyRangeList = std::vector<DbKeyRange>;
+using DbIterF = std::function<bool(void* aKey, size_t keyLen, void* aValue, size_t valueLen)>;
+
 // Most methods throw DbException in case of errors
 class DbHandler : boost::noncopyable {
 public:
@@ -48,10 +72,22 @@ public:
 
 	virtual bool hasKey(void* key, size_t keyLen, DbSnapshot* aSnapshot = nullptr) = 0;
 
+	virtual std::unique_ptr<DbWriteBatch> createWriteBatch() = 0;
+	virtual void write(DbWriteBatch& aBatch) = 0;
+
+	// Look up multiple keys at once, loadF is called for each found key with its index in the key list
+	virtual void multiGet(const DbKeyList& aKeys, const std::function<void(size_t aKeyIndex, void* aValue, size_t aValueLen)>& loadF, DbSnapshot* aSnapshot = nullptr) = 0;
+
 	virtual size_t size(bool thorough, DbSnapshot* aSnapshot = nullptr) = 0;
 	virtual int64_t getSizeOnDisk() = 0;
 
 	virtual void remove_if(std::function<bool(void* aKey, size_t keyLen, void* aValue, size_t valueLen)> f, DbSnapshot* aSnapshot = nullptr) = 0;
+
+	// Iterate over the entries within a key range, iteration is stopped if the function returns false
+	virtual void forEach(const DbKeyRange& aRange, const DbIterF& f, DbSnapshot* aSnapshot = nullptr) = 0;
+
+	// Split the key space into ranges containing approximately equal amount of data (for parallel processing)
+	virtual DbKeyRangeList getKeyRanges(size_t /*aMaxRanges*/) { return { DbKeyRange() }; }
 	virtual void compact() {}
 
 	virtual string getStats() { return "Not supported"; }
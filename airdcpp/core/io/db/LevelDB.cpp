@@ -165,6 +165,83 @@ string LevelDB::getStats() {
 	return ret;
 }
 
+void LevelDB::LevelWriteBatch::put(void* aKey, size_t keyLen, void* aValue, size_t valueLen) {
+	wb.Put(leveldb::Slice((const char*)aKey, keyLen), leveldb::Slice((const char*)aValue, valueLen));
+	operations++;
+}
+
+void LevelDB::LevelWriteBatch::remove(void* aKey, size_t keyLen) {
+	wb.Delete(leveldb::Slice((const char*)aKey, keyLen));
+	operations++;
+}
+
+unique_ptr<DbWriteBatch> LevelDB::createWriteBatch() {
+	return make_unique<LevelWriteBatch>();
+}
+
+void LevelDB::write(DbWriteBatch& aBatch) {
+	if (aBatch.empty()) {
+		return;
+	}
+
+	auto& batch = static_cast<LevelWriteBatch&>(aBatch);
+	totalWrites += batch.size();
+
+	// A single (synchronized) write for the whole batch
+	DBACTION(db->Write(writeoptions, &batch.wb));
+}
+
+void LevelDB::multiGet(const DbKeyList& aKeys, const std::function<void(size_t aKeyIndex, void* aValue, size_t aValueLen)>& loadF, DbSnapshot* aSnapshot /*nullptr*/) {
+	totalReads += aKeys.size();
+
+	leveldb::ReadOptions options = readoptions;
+	if (aSnapshot)
+		options.snapshot = static_cast<LevelSnapshot*>(aSnapshot)->snapshot;
+
+	if (aKeys.size() < MULTIGET_ITERATOR_LIMIT) {
+		string value;
+		for (size_t i = 0; i < aKeys.size(); ++i) {
+			leveldb::Slice key((const char*)aKeys[i].first, aKeys[i].second);
+			auto ret = DBACTION(db->Get(options, key, &value));
+			if (ret.ok()) {
+				loadF(i, (void*)value.data(), value.size());
+			}
+		}
+
+		return;
+	}
+
+	// Go through the keys in the database order so that the iterator can mostly move forward within the already loaded blocks
+	vector<size_t> order(aKeys.size());
+	iota(order.begin(), order.end(), 0);
+
+	auto toSlice = [&aKeys](size_t aIndex) {
+		return leveldb::Slice((const char*)aKeys[aIndex].first, aKeys[aIndex].second);
+	};
+
+	ranges::sort(order, [&toSlice](size_t a, size_t b) { return toSlice(a).compare(toSlice(b)) < 0; });
+
+	auto it = unique_ptr<leveldb::Iterator>(db->NewIterator(options));
+	bool positioned = false;
+	for (auto i: order) {
+		auto key = toSlice(i);
+		if (!positioned || it->key().compare(key) < 0) {
+			it->Seek(key);
+			checkDbError(it->status());
+			positioned = true;
+		}
+
+		if (!it->Valid()) {
+			// Past the last key (the remaining keys are larger)
+			break;
+		}
+
+		if (it->key().compare(key) == 0) {
+			loadF(i, (void*)it->value().data(), it->value().size());
+		}
+	}
+}
+
 bool LevelDB::hasKey(void* aKey, size_t keyLen, DbSnapshot* /*aSnapshot*/ /*nullptr*/) {
 	string value;
 	leveldb::Slice key((const char*)aKey, keyLen);
@@ -228,6 +305,116 @@ void LevelDB::remove_if(std::function<bool(void* aKey, size_t key_len, void* aVa
 	DBACTION(db->Write(writeoptions, &wb));
 }
 
+void LevelDB::forEach(const DbKeyRange& aRange, const DbIterF& f, DbSnapshot* aSnapshot /*nullptr*/) {
+	leveldb::ReadOptions options;
+	options.fill_cache = false;
+	options.verify_checksums = false;
+	if (aSnapshot)
+		options.snapshot = static_cast<LevelSnapshot*>(aSnapshot)->snapshot;
+
+	auto it = unique_ptr<leveldb::Iterator>(db->NewIterator(options));
+	if (aRange.start.empty()) {
+		it->SeekToFirst();
+	} else {
+		it->Seek(aRange.start);
+	}
+
+	leveldb::Slice end(aRange.end);
+	for (; it->Valid(); it->Next()) {
+		checkDbError(it->status());
+		if (!aRange.end.empty() && it->key().compare(end) >= 0) {
+			break;
+		}
+
+		if (!f((void*)it->key().data(), it->key().size(), (void*)it->value().data(), it->value().size())) {
+			break;
+		}
+	}
+}
+
+vector<uint64_t> LevelDB::getPrefixSizes(const string& aPrefix) {
+	vector<string> keys;
+	keys.reserve(257);
+	for (int b = 0; b < 256; ++b) {
+		keys.push_back(aPrefix + static_cast<char>(b));
+	}
+
+	// There is no successor for the prefix itself, use a key that is larger than any realistic key with the prefix
+	keys.push_back(aPrefix + string(64, '\xff'));
+
+	vector<leveldb::Range> ranges;
+	ranges.reserve(256);
+	for (int b = 0; b < 256; ++b) {
+		ranges.emplace_back(keys[b], keys[b + 1]);
+	}
+
+	vector<uint64_t> sizes(256);
+	db->GetApproximateSizes(ranges.data(), static_cast<int>(ranges.size()), sizes.data());
+	return sizes;
+}
+
+DbKeyRangeList LevelDB::getKeyRanges(size_t aMaxRanges) {
+	if (aMaxRanges <= 1) {
+		return { DbKeyRange() };
+	}
+
+	// Estimate the data distribution by key prefixes (in key order)
+	// Prefixes containing most data are split further
+	vector<pair<string, uint64_t>> prefixes;
+	auto addChildren = [this, &prefixes](vector<pair<string, uint64_t>>::iterator aPos, const string& aPrefix) {
+		auto sizes = getPrefixSizes(aPrefix);
+
+		vector<pair<string, uint64_t>> children;
+		for (int b = 0; b < 256; ++b) {
+			children.emplace_back(aPrefix + static_cast<char>(b), sizes[b]);
+		}
+
+		prefixes.insert(aPos, children.begin(), children.end());
+	};
+
+	addChildren(prefixes.end(), Util::emptyString);
+
+	uint64_t totalSize = 0;
+	for (const auto& p: prefixes) {
+		totalSize += p.second;
+	}
+
+	if (totalSize == 0) {
+		// Everything is still in memory
+		return { DbKeyRange() };
+	}
+
+	const auto targetSize = totalSize / aMaxRanges;
+	for (int i = 0; i < MAX_KEY_RANGE_REFINEMENTS; ++i) {
+		auto largest = ranges::max_element(prefixes, [](const auto& a, const auto& b) { return a.second < b.second; });
+		if (largest->second <= targetSize || largest->first.size() >= 16) {
+			break;
+		}
+
+		auto prefix = largest->first;
+		addChildren(prefixes.erase(largest), prefix);
+	}
+
+	// Combine consecutive prefixes
+	DbKeyRangeList ret;
+	DbKeyRange current;
+	uint64_t currentSize = 0;
+	for (const auto& [prefix, size]: prefixes) {
+		if (currentSize >= targetSize && ret.size() + 1 < aMaxRanges) {
+			current.end = prefix;
+			ret.push_back(current);
+
+			current = { prefix, Util::emptyString };
+			currentSize = 0;
+		}
+
+		currentSize += size;
+	}
+
+	ret.push_back(current);
+	return ret;
+}
+
 // free up some space, https://code.google.com/p/leveldb/issues/detail?id=158
 // LevelDB will perform some kind of compaction on every startup but it's not as comprehensive as manual one
 // The issue has been "fixed" in version 1.13 but it still won't match the manual one (possibly because only ranges that are iterated
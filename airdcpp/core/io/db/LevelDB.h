@@ -26,6 +26,7 @@
 #include <leveldb/db.h>
 #include <leveldb/env.h>
 #include <leveldb/options.h>
+#include <leveldb/write_batch.h>
 
 namespace dcpp {
 
@@ -41,12 +42,18 @@ public:
 	void remove(void* aKey, size_t keyLen, DbSnapshot* aSnapshot /*nullptr*/);
 	bool hasKey(void* aKey, size_t keyLen, DbSnapshot* aSnapshot /*nullptr*/);
 
+	unique_ptr<DbWriteBatch> createWriteBatch();
+	void write(DbWriteBatch& aBatch);
+	void multiGet(const DbKeyList& aKeys, const std::function<void(size_t aKeyIndex, void* aValue, size_t aValueLen)>& loadF, DbSnapshot* aSnapshot /*nullptr*/);
+
 	string getStats();
 
 	size_t size(bool /*thorough*/, DbSnapshot* aSnapshot /*nullptr*/);
 	int64_t getSizeOnDisk();
 
 	void remove_if(std::function<bool(void* aKey, size_t key_len, void* aValue, size_t valueLen)> f, DbSnapshot* aSnapshot /*nullptr*/);
+	void forEach(const DbKeyRange& aRange, const DbIterF& f, DbSnapshot* aSnapshot /*nullptr*/);
+	DbKeyRangeList getKeyRanges(size_t aMaxRanges);
 	void compact();
 	void repair(StepFunction stepF, MessageFunction messageF);
 	void open(StepFunction stepF, MessageFunction messageF);
@@ -65,7 +72,29 @@ private:
 		const leveldb::Snapshot* snapshot;
 	};
 
+	class LevelWriteBatch : public DbWriteBatch {
+	public:
+		void put(void* aKey, size_t keyLen, void* aValue, size_t valueLen);
+		void remove(void* aKey, size_t keyLen);
+		size_t size() const noexcept { return operations; }
+
+		leveldb::WriteBatch wb;
+	private:
+		size_t operations = 0;
+	};
+
+	// Batches smaller than this are looked up with point reads (which can use the bloom filter)
+	// Larger batches are read with a single iterator in key order
+	static const size_t MULTIGET_ITERATOR_LIMIT = 8;
+
+	// Maximum number of times that a key prefix is split when estimating the key distribution
+	static const int MAX_KEY_RANGE_REFINEMENTS = 8;
+
 	string getRepairFlag() const;
+
+	// Approximate data sizes for keys starting with aPrefix followed by each possible byte value
+	vector<uint64_t> getPrefixSizes(const string& aPrefix);
+
 	leveldb::Status performDbOperation(function<leveldb::Status()> f);
 	void checkDbError(leveldb::Status aStatus);
 
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2011-2024 AirDC++ Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "stdinc.h"
+#include <airdcpp/core/io/stream/SegmentOutputStream.h>
+
+#include <airdcpp/core/classes/Exception.h>
+#include <airdcpp/core/io/File.h>
+#include <airdcpp/core/io/stream/SharedFileStream.h>
+
+namespace dcpp {
+
+namespace {
+	atomic<int64_t> receivedBytes { 0 };
+	atomic<int64_t> writtenBytes { 0 };
+	atomic<int64_t> writes { 0 };
+	atomic<int64_t> committedBytes { 0 };
+	atomic<int64_t> preallocatedBytes { 0 };
+	atomic<int64_t> preallocatedFiles { 0 };
+}
+
+double SegmentOutputStream::Stats::getWriteAmplification() const noexcept {
+	return committedBytes > 0 ? static_cast<double>(writtenBytes) / static_cast<double>(committedBytes) : 0;
+}
+
+int64_t SegmentOutputStream::Stats::getAverageWriteSize() const noexcept {
+	return writes > 0 ? writtenBytes / writes : 0;
+}
+
+SegmentOutputStream::SegmentOutputStream(const string& aPath, int64_t aFileSize, int64_t aSegmentStart, const Options& aOptions) :
+	dropCache(aOptions.dropCache), buf(aOptions.bufferSize), pos(aSegmentStart), dropPos(aSegmentStart) {
+
+	file = make_unique<SharedFileStream>(aPath, File::WRITE, File::OPEN | File::CREATE | File::SHARED_WRITE | aOptions.fileFlags);
+
+	if (file->getSize() != aFileSize) {
+		if (aOptions.preallocate) {
+			file->preallocate(aFileSize);
+			preallocatedBytes += aFileSize;
+			preallocatedFiles++;
+		} else {
+			file->setSize(aFileSize);
+		}
+	}
+}
+
+SegmentOutputStream::~SegmentOutputStream() {
+	try {
+		// We must do this in order not to lose bytes when a download
+		// is disconnected prematurely
+		flushBuffer();
+	} catch (const Exception&) { }
+}
+
+size_t SegmentOutputStream::getChunkLimit() const noexcept {
+	return buf.size() - static_cast<size_t>(pos % static_cast<int64_t>(buf.size()));
+}
+
+size_t SegmentOutputStream::write(const void* aBuf, size_t aLen) {
+	receivedBytes += aLen;
+
+	auto b = static_cast<const uint8_t*>(aBuf);
+	auto len = aLen;
+	if (buf.empty()) {
+		writeChunk(b, len);
+		return aLen;
+	}
+
+	auto bufSize = buf.size();
+	while (len > 0) {
+		if (used == 0 && len >= bufSize && pos % static_cast<int64_t>(bufSize) == 0) {
+			// Aligned, write the full chunks directly
+			auto direct = len - len % bufSize;
+			writeChunk(b, direct);
+			b += direct;
+			len -= direct;
+			continue;
+		}
+
+		auto limit = getChunkLimit();
+		auto n = min(limit - used, len);
+		memcpy(&buf[used], b, n);
+		b += n;
+		len -= n;
+		used += n;
+
+		if (used == limit) {
+			flushBuffer();
+		}
+	}
+
+	return aLen;
+}
+
+size_t SegmentOutputStream::flushBuffers(bool aForce) {
+	flushBuffer();
+	file->flushBuffers(aForce);
+
+	if (dropCache) {
+		dropWrittenRange();
+	}
+
+	return 0;
+}
+
+void SegmentOutputStream::flushBuffer() {
+	if (used > 0) {
+		writeChunk(&buf[0], used);
+		used = 0;
+	}
+}
+
+void SegmentOutputStream::writeChunk(const uint8_t* aData, size_t aLen) {
+	file->setPos(pos);
+	file->write(aData, aLen);
+
+	pos += static_cast<int64_t>(aLen);
+	if (dropCache && pos - dropPos >= DROP_CACHE_INTERVAL) {
+		dropWrittenRange();
+	}
+
+	writtenBytes += aLen;
+	writes++;
+}
+
+void SegmentOutputStream::dropWrittenRange() noexcept {
+	if (pos > dropPos) {
+		file->dropCache(dropPos, pos - dropPos);
+		dropPos = pos;
+	}
+}
+
+void SegmentOutputStream::addCommittedBytes(int64_t aBytes) noexcept {
+	committedBytes += aBytes;
+}
+
+SegmentOutputStream::Stats SegmentOutputStream::getStats() noexcept {
+	Stats ret;
+	ret.receivedBytes = receivedBytes;
+	ret.writtenBytes = writtenBytes;
+	ret.writes = writes;
+	ret.committedBytes = committedBytes;
+	ret.preallocatedBytes = preallocatedBytes;
+	ret.preallocatedFiles = preallocatedFiles;
+	return ret;
+}
+
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2011-2024 AirDC++ Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef DCPLUSPLUS_DCPP_SEGMENT_OUTPUT_STREAM_H
+#define DCPLUSPLUS_DCPP_SEGMENT_OUTPUT_STREAM_H
+
+#include <airdcpp/core/header/typedefs.h>
+
+#include <airdcpp/core/io/stream/StreamBase.h>
+
+namespace dcpp {
+
+class SharedFileStream;
+
+// Writes a single segment of a shared download file
+//
+// Incoming data is coalesced into chunks of the buffer size that are aligned to the same boundary in the file
+// so that the parallel segments won't produce small interleaved writes. The written ranges can optionally be
+// dropped from the page cache.
+class SegmentOutputStream : public OutputStream {
+public:
+	struct Options {
+		// Chunk size for disk writes, 0 to write the data as it arrives
+		size_t bufferSize = 0;
+
+		// Reserve the disk space when the file is created
+		bool preallocate = false;
+
+		// Write the received data on disk in DROP_CACHE_INTERVAL ranges and drop them from the page cache
+		bool dropCache = false;
+
+		// Additional File mode flags for opening the file
+		int fileFlags = 0;
+	};
+
+	struct Stats {
+		// Bytes passed to the segment streams
+		int64_t receivedBytes = 0;
+
+		// Bytes written on disk and the number of write calls
+		int64_t writtenBytes = 0;
+		int64_t writes = 0;
+
+		// Bytes that were marked as downloaded in the queue
+		int64_t committedBytes = 0;
+
+		int64_t preallocatedBytes = 0;
+		int64_t preallocatedFiles = 0;
+
+		// Written bytes in relation to the bytes that were actually kept
+		// Data from aborted partial blocks and failed integrity checks will be written again
+		double getWriteAmplification() const noexcept;
+		int64_t getAverageWriteSize() const noexcept;
+	};
+
+	// Opens (and sizes) the file and positions the stream at the start of the segment
+	// Throws FileException on errors
+	SegmentOutputStream(const string& aPath, int64_t aFileSize, int64_t aSegmentStart, const Options& aOptions);
+	~SegmentOutputStream() override;
+
+	size_t write(const void* aBuf, size_t aLen) override;
+	size_t flushBuffers(bool aForce) override;
+
+	static Stats getStats() noexcept;
+	static void addCommittedBytes(int64_t aBytes) noexcept;
+
+	SegmentOutputStream(const SegmentOutputStream&) = delete;
+	SegmentOutputStream& operator=(const SegmentOutputStream&) = delete;
+private:
+	// Bytes to write before the written range is dropped from the page cache (the call waits for the disk)
+	static const int64_t DROP_CACHE_INTERVAL = 8 * 1024 * 1024;
+
+	void writeChunk(const uint8_t* aData, size_t aLen);
+	void flushBuffer();
+	void dropWrittenRange() noexcept;
+
+	// Number of bytes that fit in the buffer before the next aligned boundary
+	size_t getChunkLimit() const noexcept;
+
+	unique_ptr<SharedFileStream> file;
+	const bool dropCache;
+
+	ByteVector buf;
+	size_t used = 0;
+
+	// File position of the first buffered byte
+	int64_t pos;
+
+	// Start of the written range that is still in the page cache
+	int64_t dropPos;
+};
+
+}
+
+#endif // !defined(DCPLUSPLUS_DCPP_SEGMENT_OUTPUT_STREAM_H)
@@ -59,37 +59,36 @@ SharedFileStream::~SharedFileStream() {
 }
 
 size_t SharedFileStream::write(const void* buf, size_t len) {
-	Lock l(sfh->cs);
+	sfh->writeAt(buf, len, pos);
 
-	sfh->setPos(pos);
-	sfh->write(buf, len);
-
-    pos += len;
+	pos += len;
 	return len;
 }
 
 size_t SharedFileStream::read(void* buf, size_t& len) {
-	Lock l(sfh->cs);
-
-	sfh->setPos(pos);
-	len = sfh->read(buf, len);
+	len = sfh->readAt(buf, len, pos);
 
-    pos += len;
+	pos += len;
 	return len;
 }
 
 int64_t SharedFileStream::getSize() const noexcept {
-	Lock l(sfh->cs);
 	return sfh->getSize();
 }
 
 void SharedFileStream::setSize(int64_t newSize) {
-	Lock l(sfh->cs);
 	sfh->setSize(newSize);
 }
 
+void SharedFileStream::preallocate(int64_t aSize) {
+	sfh->preallocate(aSize);
+}
+
+void SharedFileStream::dropCache(int64_t aPos, int64_t aLen) noexcept {
+	sfh->dropCache(aPos, aLen);
+}
+
 size_t SharedFileStream::flushBuffers(bool aForce) {
-	Lock l(sfh->cs);
 	return sfh->flushBuffers(aForce);
 }
 
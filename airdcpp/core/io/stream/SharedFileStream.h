@@ -30,7 +30,6 @@ struct SharedFileHandle : File {
 	SharedFileHandle(const string& aPath, int access, int mode);
 	~SharedFileHandle() noexcept = default;
 
-	CriticalSection cs;
 	int	ref_cnt;
 	string path;
 	int mode;
@@ -50,6 +49,8 @@ public:
 
 	int64_t getSize() const noexcept override;
 	void setSize(int64_t newSize);
+	void preallocate(int64_t aSize);
+	void dropCache(int64_t aPos, int64_t aLen) noexcept;
 
 	size_t flushBuffers(bool aForce) override;
 
@@ -60,7 +61,7 @@ public:
 	void setPos(int64_t aPos) noexcept override;
 private:
 	SharedFileHandle* sfh;
-	int64_t pos;
+	int64_t pos = 0;
 };
 
 }
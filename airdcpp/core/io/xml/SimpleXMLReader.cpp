@@ -23,9 +23,43 @@
 
 #include <airdcpp/util/text/Text.h>
 #include <airdcpp/core/io/stream/Streams.h>
+#include <airdcpp/core/timer/Tracer.h>
+
+#include <bit>
+#include <charconv>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DCPP_XML_SSE2
+#endif
 
 namespace dcpp {
 
+// Returns the position of the first a or b character (or aLen if neither one was found)
+static size_t findEither(const char* aData, size_t aLen, char a, char b) noexcept {
+	size_t i = 0;
+
+#ifdef DCPP_XML_SSE2
+	const auto va = _mm_set1_epi8(a);
+	const auto vb = _mm_set1_epi8(b);
+	for (; i + 16 <= aLen; i += 16) {
+		const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aData + i));
+		const auto mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, va), _mm_cmpeq_epi8(chunk, vb)));
+		if (mask != 0) {
+			return i + std::countr_zero(static_cast<unsigned>(mask));
+		}
+	}
+#endif
+
+	for (; i < aLen; ++i) {
+		if (aData[i] == a || aData[i] == b) {
+			return i;
+		}
+	}
+
+	return aLen;
+}
+
 static bool isSpace(int c) {
 	return c == 0x20 || c == 0x09 || c == 0x0d || c == 0x0a;
 }
@@ -89,6 +123,7 @@ SimpleXMLReader::SimpleXMLReader(SimpleXMLReader::CallBack* callback, int aFlags
 {
 	elements.reserve(64);
 	attribs.reserve(16);
+	attribViews.reserve(16);
 }
 
 void SimpleXMLReader::append(std::string& str, size_t maxLen, int c) const {
@@ -98,7 +133,7 @@ void SimpleXMLReader::append(std::string& str, size_t maxLen, int c) const {
 	str.append(1, (std::string::value_type)c);
 }
 
-void SimpleXMLReader::append(std::string& str, size_t maxLen, std::string::const_iterator begin, std::string::const_iterator end) const {
+void SimpleXMLReader::append(std::string& str, size_t maxLen, const char* begin, const char* end) const {
 	if(str.size() + (end - begin) > maxLen) {
 		error("Buffer overflow");
 	}
@@ -107,9 +142,10 @@ void SimpleXMLReader::append(std::string& str, size_t maxLen, std::string::const
 
 /// @todo This is cheating - we should be converting from the encoding, but since we simplify a few things
 /// this is ok
-int SimpleXMLReader::charAt(size_t n) const { return buf[bufPos + n]; }
+int SimpleXMLReader::charAt(size_t n) const { return input[bufPos + n]; }
 void SimpleXMLReader::advancePos(size_t n) { bufPos += n; pos += n; }
-string::size_type SimpleXMLReader::bufSize() const { return buf.size() - bufPos; }
+string::size_type SimpleXMLReader::bufSize() const { return input.size() - bufPos; }
+void SimpleXMLReader::setBuffer() { input = buf; externalInput = false; }
 
 bool SimpleXMLReader::error(const char* e) const {
 	throw SimpleXMLException(Util::toString(pos) + ": " + e);
@@ -127,6 +163,48 @@ const string& SimpleXMLReader::CallBack::getAttrib(StringPairList& attribs, cons
 	}
 }
 
+string_view SimpleXMLReader::CallBack::getAttrib(const AttribViewList& attribs, string_view name, size_t hint) noexcept {
+	hint = min(hint, attribs.size());
+
+	auto matchName = [&name](const auto& aAttrib) { return aAttrib.first == name; };
+	auto i = find_if(attribs.begin() + hint, attribs.end(), matchName);
+	if (i == attribs.end()) {
+		i = find_if(attribs.begin(), attribs.begin() + hint, matchName);
+		return i == attribs.begin() + hint ? string_view() : i->second;
+	}
+
+	return i->second;
+}
+
+template<typename T>
+static T parseNumber(string_view aValue) noexcept {
+	T ret = 0;
+	std::from_chars(aValue.data(), aValue.data() + aValue.size(), ret);
+	return ret;
+}
+
+int64_t SimpleXMLReader::CallBack::toInt64(string_view aValue) noexcept {
+	return parseNumber<int64_t>(aValue);
+}
+
+int SimpleXMLReader::CallBack::toInt(string_view aValue) noexcept {
+	return parseNumber<int>(aValue);
+}
+
+uint32_t SimpleXMLReader::CallBack::toUInt32(string_view aValue) noexcept {
+	return parseNumber<uint32_t>(aValue);
+}
+
+void SimpleXMLReader::CallBack::startTagView(const string& aName, const AttribViewList& aAttribs, bool aSimple) {
+	StringPairList attribs;
+	attribs.reserve(aAttribs.size());
+	for (const auto& [name, value]: aAttribs) {
+		attribs.emplace_back(name, value);
+	}
+
+	startTag(aName, attribs, aSimple);
+}
+
 bool SimpleXMLReader::literal(const char* lit, size_t len, bool withSpace, ParseState newState) {
 	string::size_type n = 0, nend = bufSize();
 	for(; n < nend && n < len; ++n) {
@@ -167,6 +245,7 @@ bool SimpleXMLReader::element() {
 		elements.emplace_back();
 		append(elements.back(), MAX_NAME_SIZE, c);
 
+		tagStart = bufPos;
 		advancePos(2);
 
 		return true;
@@ -181,22 +260,21 @@ bool SimpleXMLReader::elementName() {
 		int c = charAt(i);
 
 		if(isSpace(c)) {
-			append(elements.back(), MAX_NAME_SIZE, buf.begin() + bufPos, buf.begin() + bufPos + i);
+			append(elements.back(), MAX_NAME_SIZE, bufPtr(), bufPtr() + i);
 
 			state = STATE_ELEMENT_ATTR;
 			advancePos(i + 1);
 			return true;
 		} else if(c == '/') {
-			append(elements.back(), MAX_NAME_SIZE, buf.begin() + bufPos, buf.begin() + bufPos + i);
+			append(elements.back(), MAX_NAME_SIZE, bufPtr(), bufPtr() + i);
 
 			state = STATE_ELEMENT_END_SIMPLE;
 			advancePos(i + 1);
 			return true;
 		} else if(c == '>') {
-			append(elements.back(), MAX_NAME_SIZE, buf.begin() + bufPos, buf.begin() + bufPos + i);
+			append(elements.back(), MAX_NAME_SIZE, bufPtr(), bufPtr() + i);
 
-			cb->startTag(elements.back(), attribs, false);
-			attribs.clear();
+			startTag(false);
 
 			state = STATE_CONTENT;
 			advancePos(i + 1);
@@ -206,7 +284,7 @@ bool SimpleXMLReader::elementName() {
 		}
 	}
 
-	append(elements.back(), MAX_NAME_SIZE, buf.begin() + bufPos, buf.begin() + bufPos + i);
+	append(elements.back(), MAX_NAME_SIZE, bufPtr(), bufPtr() + i);
 	advancePos(i);
 
 	return true;
@@ -220,7 +298,7 @@ bool SimpleXMLReader::elementAttr() {
 	int c = charAt(0);
 	if(isNameStartChar(c)) {
 		attribs.emplace_back();
-		append(attribs.back().first, MAX_NAME_SIZE, c);
+		attribs.back().nameStart = bufPos - tagStart;
 
 		state = STATE_ELEMENT_ATTR_NAME;
 		advancePos(1);
@@ -232,20 +310,16 @@ bool SimpleXMLReader::elementAttr() {
 }
 
 bool SimpleXMLReader::elementAttrName() {
+	auto& attrib = attribs.back();
+
 	size_t i = 0;
 	for(size_t iend = bufSize(); i < iend; ++i) {
 		int c = charAt(i);
 
-		if(isSpace(c)) {
-			append(attribs.back().first, MAX_NAME_SIZE, buf.begin() + bufPos, buf.begin() + bufPos + i);
-
-			state = STATE_ELEMENT_ATTR_EQ;
-			advancePos(i + 1);
-			return true;
-		} else if(c == '=') {
-			append(attribs.back().first, MAX_NAME_SIZE, buf.begin() + bufPos, buf.begin() + bufPos + i);
+		if(isSpace(c) || c == '=') {
+			attrib.nameLen = bufPos + i - tagStart - attrib.nameStart;
 
-			state = STATE_ELEMENT_ATTR_VALUE;
+			state = c == '=' ? STATE_ELEMENT_ATTR_VALUE : STATE_ELEMENT_ATTR_EQ;
 			advancePos(i + 1);
 			return true;
 		} else if(!isNameChar(c)) {
@@ -253,46 +327,97 @@ bool SimpleXMLReader::elementAttrName() {
 		}
 	}
 
-	append(attribs.back().first, MAX_NAME_SIZE, buf.begin() + bufPos, buf.begin() + bufPos + i);
+	if(bufPos + i - tagStart - attrib.nameStart > MAX_NAME_SIZE) {
+		error("Buffer overflow");
+	}
+
 	advancePos(i);
 	return true;
 }
 
 bool SimpleXMLReader::elementAttrValue() {
-	size_t i = 0;
-	for(size_t iend = bufSize(); i < iend; ++i) {
-		int c = charAt(i);
+	auto& attrib = attribs.back();
+	if(attrib.valueStart == string::npos) {
+		attrib.valueStart = bufPos - tagStart;
+	}
+
+	const auto n = bufSize();
+	const auto i = findEither(bufPtr(), n, state == STATE_ELEMENT_ATTR_VALUE_APOS ? '\'' : '"', '&');
 
-		if((state == STATE_ELEMENT_ATTR_VALUE_APOS && c == '\'') || (state == STATE_ELEMENT_ATTR_VALUE_QUOT && c == '"')) {
-			append(attribs.back().second, MAX_VALUE_SIZE, buf.begin() + bufPos, buf.begin() + bufPos + i);
+	if(attrib.decoded >= 0) {
+		// Value containing entities, copy it
+		auto& decoded = decodedValues[attrib.decoded];
+		append(decoded, MAX_VALUE_SIZE, bufPtr(), bufPtr() + i);
+		if(i == n) {
+			advancePos(i);
+			return true;
+		}
 
-			decodeString(attribs.back().second);
+		if(charAt(i) == '&') {
+			advancePos(i);
+			return entref(decoded);
+		}
 
-			state = STATE_ELEMENT_ATTR;
-			advancePos(i + 1);
+		decodeString(decoded);
+	} else {
+		// Reference the value in the buffer
+		const auto len = bufPos + i - tagStart - attrib.valueStart;
+		if(len > MAX_VALUE_SIZE) {
+			error("Buffer overflow");
+		}
+
+		if(i == n) {
+			advancePos(i);
 			return true;
-		} else if(c == '&') {
-			append(attribs.back().second, MAX_VALUE_SIZE, buf.begin() + bufPos, buf.begin() + bufPos + i);
+		}
+
+		const string_view valueView(input.data() + tagStart + attrib.valueStart, len);
+		if(charAt(i) == '&') {
+			attrib.decoded = static_cast<int>(decodedValues.size());
+			decodedValues.emplace_back(valueView);
 			advancePos(i);
-			return entref(attribs.back().second);
+			return entref(decodedValues.back());
 		}
-	}
 
-	append(attribs.back().second, MAX_VALUE_SIZE, buf.begin() + bufPos, buf.begin() + bufPos + i);
-	advancePos(i);
+		if(needsDecoding(valueView)) {
+			attrib.decoded = static_cast<int>(decodedValues.size());
+			decodedValues.emplace_back(valueView);
+			decodeString(decodedValues.back());
+		} else {
+			attrib.valueLen = len;
+		}
+	}
 
+	state = STATE_ELEMENT_ATTR;
+	advancePos(i + 1);
 	return true;
 }
 
+void SimpleXMLReader::startTag(bool aSimple) {
+	attribViews.clear();
+	for(const auto& a: attribs) {
+		const auto tag = input.data() + tagStart;
+		attribViews.emplace_back(
+			string_view(tag + a.nameStart, a.nameLen),
+			a.decoded >= 0 ? string_view(decodedValues[a.decoded]) : string_view(tag + a.valueStart, a.valueLen)
+		);
+	}
+
+	cb->startTagView(elements.back(), attribViews, aSimple);
+
+	attribs.clear();
+	decodedValues.clear();
+	tagStart = string::npos;
+}
+
 bool SimpleXMLReader::elementEndSimple() {
 	if(!needChars(1)) {
 		return true;
 	}
 
 	if(charAt(0) == '>') {
-		cb->startTag(elements.back(), attribs, true);
+		startTag(true);
 		elements.pop_back();
-		attribs.clear();
 
 		state = STATE_CONTENT;
 		advancePos(1);
@@ -308,8 +433,7 @@ bool SimpleXMLReader::elementEndComplex() {
 	}
 
 	if(charAt(0) == '>') {
-		cb->startTag(elements.back(), attribs, false);
-		attribs.clear();
+		startTag(false);
 
 		state = STATE_CONTENT;
 		advancePos(1);
@@ -372,6 +496,7 @@ bool SimpleXMLReader::declEncodingValue() {
 
 		if((state == STATE_DECL_ENCODING_NAME_APOS && c == '\'') || (state == STATE_DECL_ENCODING_NAME_QUOT && c == '"')) {
 			encoding = Text::toLower(encoding);
+			utf8Input = encoding.empty() || compare(encoding, Text::utf8) == 0;
 			state = STATE_DECL_STANDALONE;
 			advancePos(1);
 			return true;
@@ -507,9 +632,11 @@ bool SimpleXMLReader::content() {
 		return entref(value);
 	}
 
-	append(value, MAX_VALUE_SIZE, c);
+	// Consume everything until the next markup or entity
+	const auto i = 1 + findEither(bufPtr() + 1, bufSize() - 1, '<', '&');
+	append(value, MAX_VALUE_SIZE, bufPtr(), bufPtr() + i);
 
-	advancePos(1);
+	advancePos(i);
 
 	return true;
 }
@@ -524,7 +651,7 @@ bool SimpleXMLReader::elementEnd() {
 		return true;
 	}
 
-	if(top.compare(0, top.size(), &buf[bufPos], top.size()) == 0) {
+	if(top.compare(0, top.size(), bufPtr(), top.size()) == 0) {
 		state = STATE_ELEMENT_END_END;
 		advancePos(top.size());
 		return true;
@@ -568,17 +695,21 @@ bool SimpleXMLReader::skipSpace(bool store) {
 }
 
 bool SimpleXMLReader::needChars(size_t n) const {
-	return bufPos + n <= buf.size();
+	return bufPos + n <= input.size();
 }
 
 #define LITN(x) x, sizeof(x)-1
 
 void SimpleXMLReader::parse(InputStream& stream, size_t maxSize) {
+	static auto& parseDuration = Tracer::getHistogram(Tracer::XML, "parseStream");
+	Tracer::Span span(Tracer::XML, "parseStream", &parseDuration);
+
 	const size_t BUF_SIZE = 64*1024;
 	size_t bytesRead = 0;
 	do {
+		// The current tag is kept in the buffer so there may be more than BUF_SIZE of unparsed data
 		size_t old = buf.size();
-		buf.resize(BUF_SIZE);
+		buf.resize(max(BUF_SIZE, old + BUF_SIZE / 4));
 
 		size_t n = buf.size() - old;
 		size_t len = stream.read(&buf[old], n);
@@ -595,14 +726,32 @@ void SimpleXMLReader::parse(InputStream& stream, size_t maxSize) {
 		}
 		buf.resize(old + len);
 		bytesRead += len;
+		setBuffer();
 	} while(process());
 }
 
 bool SimpleXMLReader::parse(const char* data, size_t len) {
 	buf.append(data, len);
+	setBuffer();
 	return process();
 }
 
+void SimpleXMLReader::parseDocument(string_view aDocument) {
+	static auto& parseDuration = Tracer::getHistogram(Tracer::XML, "parseDocument");
+	Tracer::Span span(Tracer::XML, "parseDocument", &parseDuration);
+
+	dcassert(buf.empty() && bufPos == 0);
+
+	input = aDocument;
+	externalInput = true;
+
+	if(process() && !elements.empty()) {
+		error("Unexpected end of document");
+	}
+
+	input = string_view();
+}
+
 bool SimpleXMLReader::parse(const string& str) {
 	return parse(str.c_str(), str.size());
 }
@@ -737,6 +886,7 @@ bool SimpleXMLReader::process() {
 			break;
 		case STATE_END:
 			buf.clear();
+			input = string_view();
 			return false;
 		default:
 			error("Unexpected state"); break;
@@ -744,9 +894,16 @@ bool SimpleXMLReader::process() {
 
 		if(oldState == state && oldPos == bufPos) {
 			// Need more data...
-			if(bufPos > 0) {
-				buf.erase(buf.begin(), buf.begin() + bufPos);
-				bufPos = 0;
+			// Unfinished tags are kept in the buffer because the attributes reference it
+			auto consumed = min(bufPos, tagStart);
+			if(!externalInput && consumed > 0) {
+				buf.erase(buf.begin(), buf.begin() + consumed);
+				setBuffer();
+
+				bufPos -= consumed;
+				if(tagStart != string::npos) {
+					tagStart -= consumed;
+				}
 			}
 			return true;
 		}
@@ -765,10 +922,12 @@ bool SimpleXMLReader::process() {
 	return false;
 };
 
-void SimpleXMLReader::decodeString(string& str_) const {
-	auto isUtf8 = encoding.empty() || compare(encoding, Text::utf8) == 0;
+bool SimpleXMLReader::needsDecoding(string_view str) const noexcept {
+	return !utf8Input || !Text::validateUtf8(str);
+}
 
-	if (!isUtf8) {
+void SimpleXMLReader::decodeString(string& str_) const {
+	if (!utf8Input) {
 		str_ = Text::toUtf8(str_, encoding);
 	} else if (!Text::validateUtf8(str_)) {
 		if (flags & FLAG_REPLACE_INVALID_UTF8) {
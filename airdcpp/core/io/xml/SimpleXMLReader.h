@@ -28,9 +28,20 @@ namespace dcpp {
 
 class SimpleXMLReader {
 public:
+	// Attribute name / value pairs referencing the parser buffers
+	using AttribViewList = std::vector<std::pair<std::string_view, std::string_view>>;
+
 	struct CallBack : private boost::noncopyable {
 		virtual ~CallBack() = default;
 
+		/** A new XML tag has been encountered.
+		@param name Name of the tag.
+		@param attribs List of attribute name / contents pairs representing attributes of the tag.
+		The views are valid only during the call. Override this instead of the StringPairList version
+		to avoid copying the attributes. The default implementation copies the attributes and calls startTag.
+		@param simple Whether this tag is void of any data (<example/>). */
+		virtual void startTagView(const std::string& name, const AttribViewList& attribs, bool simple);
+
 		/** A new XML tag has been encountered.
 		@param name Name of the tag.
 		@param attribs List of attribute name / contents pairs representing attributes of the tag.
@@ -51,6 +62,13 @@ public:
 
 	protected:
 		static const std::string& getAttrib(StringPairList& attribs, const std::string& name, size_t hint);
+		static std::string_view getAttrib(const AttribViewList& attribs, std::string_view name, size_t hint) noexcept;
+
+		// Numeric conversions for attribute views (values that can't be parsed are returned as 0)
+		static int64_t toInt64(std::string_view value) noexcept;
+		static int toInt(std::string_view value) noexcept;
+		static uint32_t toUInt32(std::string_view value) noexcept;
+		static time_t toTimeT(std::string_view value) noexcept { return static_cast<time_t>(toInt64(value)); }
 	};
 
 	struct ThreadedCallBack : public CallBack {
@@ -83,6 +101,10 @@ public:
 	bool parse(const char* data, size_t len);
 	bool parse(const string& str);
 
+	// Parses a complete document from memory without copying it into the internal buffer
+	// The data must stay valid until the call returns
+	void parseDocument(std::string_view aDocument);
+
 private:
 
 	static const size_t MAX_NAME_SIZE = 1024; 
@@ -163,28 +185,51 @@ private:
 	};
 
 
+	// Position of an attribute in the buffer, offsets are relative to the start of the tag
+	struct AttribPos {
+		size_t nameStart = 0;
+		size_t nameLen = 0;
+		size_t valueStart = std::string::npos;
+		size_t valueLen = 0;
+
+		// Index in decodedValues for values that contain entities or had to be converted
+		int decoded = -1;
+	};
+
+	// Data that is being parsed (either buf or an external document)
+	std::string_view input;
+	bool externalInput = false;
+
 	std::string buf;
 	std::string::size_type bufPos = 0;
 	uint64_t pos = 0;
 
-	StringPairList attribs;
+	// Start of the current tag in the buffer (the tag is kept in the buffer until startTag has been called)
+	std::string::size_type tagStart = std::string::npos;
+
+	std::vector<AttribPos> attribs;
+	StringList decodedValues;
+	AttribViewList attribViews;
 	std::string value;
 
 	CallBack* cb;
 	std::string encoding;
+	bool utf8Input = true;
 
 	ParseState state = STATE_START;
 
 	StringList elements;
 
 	void append(std::string& str, size_t maxLen, int c) const;
-	void append(std::string& str, size_t maxLen, std::string::const_iterator begin, std::string::const_iterator end) const;
+	void append(std::string& str, size_t maxLen, const char* begin, const char* end) const;
 
 	bool needChars(size_t n) const;
 	int charAt(size_t n) const;
 	bool skipSpace(bool store = false);
 	void advancePos(size_t n = 1);
 	std::string::size_type bufSize() const;
+	const char* bufPtr() const { return input.data() + bufPos; }
+	void setBuffer();
 
 	bool literal(const char* lit, size_t len, bool withSpace, ParseState newState);
 	bool character(int c, ParseState newState);
@@ -201,6 +246,7 @@ private:
 	bool elementAttr();
 	bool elementAttrName();
 	bool elementAttrValue();
+	void startTag(bool simple);
 
 	bool comment();
 
@@ -216,6 +262,7 @@ private:
 	bool error(const char* message) const;
 
 	void decodeString(string& str_) const;
+	bool needsDecoding(std::string_view str) const noexcept;
 
 	const int flags;
 };
@@ -514,6 +514,7 @@ enum Strings { // @DontAdd
 	GiB, // "GiB"
 	HASHDB_MAINTENANCE_FAILED, // "Failed to complete the hash database maintenance"
 	HASHDB_MAINTENANCE_NO_UNUSED, // "Hash database maintenance finished, no unused entries were found"
+	HASHDB_MAINTENANCE_PROGRESS, // "Hash database maintenance: %1% scanned (%2% entries in %3%, %4% entries/s), %5% entries removed"
 	HASHDB_MAINTENANCE_STARTED, // "Hash database maintenance started..."
 	HASHDB_MAINTENANCE_UNUSED, // "Hash database maintenance completed: %1% unused file entries and %2% unused tree entries have been removed"
 	HASHER_X, // "Hasher #%1%"
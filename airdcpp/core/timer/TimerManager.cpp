@@ -21,6 +21,8 @@
 
 #include <boost/date_time/posix_time/ptime.hpp>
 
+#include <chrono>
+
 #ifndef _WIN32
 #include <sys/time.h>
 #endif
@@ -36,7 +38,7 @@ TimerManager::TimerManager() {
 }
 
 TimerManager::~TimerManager() {
-	dcassert(listeners.size() == 0);
+	dcassert(!hasListeners());
 }
 
 void TimerManager::shutdown() {
@@ -78,8 +80,9 @@ int TimerManager::run() {
 }
 
 uint64_t TimerManager::getTick() {
-	static ptime start = microsec_clock::universal_time();
-	return (microsec_clock::universal_time() - start).total_milliseconds();
+	// Monotonic and cheap to read (no conversions to calendar time)
+	static const auto start = std::chrono::steady_clock::now();
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
 }
 
 time_t TimerManager::getTime() {
@@ -0,0 +1,260 @@
+/*
+ * Copyright (C) 2011-2024 AirDC++ Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "stdinc.h"
+#include <airdcpp/core/timer/Tracer.h>
+
+#include <airdcpp/core/io/File.h>
+#include <airdcpp/core/thread/CriticalSection.h>
+
+#include <chrono>
+
+namespace dcpp {
+
+atomic<bool> Tracer::enabled { false };
+
+namespace {
+	struct TraceEvent {
+		const char* name;
+		uint64_t start;
+		uint64_t duration;
+		Tracer::Subsystem subsystem;
+	};
+
+	// Written only by the owning thread, the lock is needed for exporting
+	struct ThreadRing {
+		explicit ThreadRing(uint32_t aThreadId) : threadId(aThreadId) { }
+
+		CriticalSection cs;
+		const uint32_t threadId;
+		vector<TraceEvent> events;
+
+		// Position of the oldest event after the ring is full
+		size_t next = 0;
+	};
+
+	using MetricKey = pair<Tracer::Subsystem, string>;
+
+	struct Registry {
+		CriticalSection cs;
+
+		vector<shared_ptr<ThreadRing>> rings;
+		uint32_t nextThreadId = 1;
+
+		map<MetricKey, unique_ptr<Tracer::Counter>> counters;
+		map<MetricKey, unique_ptr<Tracer::Histogram>> histograms;
+	};
+
+	Registry& getRegistry() noexcept {
+		static Registry registry;
+		return registry;
+	}
+
+	ThreadRing& getThreadRing() noexcept {
+		thread_local shared_ptr<ThreadRing> ring;
+		if (!ring) {
+			auto& registry = getRegistry();
+
+			Lock l(registry.cs);
+			ring = make_shared<ThreadRing>(registry.nextThreadId++);
+			registry.rings.push_back(ring);
+		}
+
+		return *ring;
+	}
+
+	string escapeJson(const char* aText) noexcept {
+		string ret;
+		for (auto p = aText; *p; ++p) {
+			if (*p == '"' || *p == '\\') {
+				ret += '\\';
+			}
+
+			ret += *p;
+		}
+
+		return ret;
+	}
+
+	template<typename T>
+	T& getMetric(map<MetricKey, unique_ptr<T>>& aMetrics, Tracer::Subsystem aSubsystem, const char* aName) noexcept {
+		Lock l(getRegistry().cs);
+		auto& metric = aMetrics[{ aSubsystem, aName }];
+		if (!metric) {
+			metric = make_unique<T>();
+		}
+
+		return *metric;
+	}
+}
+
+const char* Tracer::getSubsystemName(Subsystem aSubsystem) noexcept {
+	switch (aSubsystem) {
+		case HASHING: return "hashing";
+		case REFRESH: return "refresh";
+		case SEARCH: return "search";
+		case SOCKET: return "socket";
+		case QUEUE: return "queue";
+		case XML: return "xml";
+		default: return "unknown";
+	}
+}
+
+uint64_t Tracer::now() noexcept {
+	// Zero is the start time of spans that aren't recorded
+	static const auto start = chrono::steady_clock::now() - chrono::microseconds(1);
+	return static_cast<uint64_t>(chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count());
+}
+
+void Tracer::Histogram::add(uint64_t aValue) noexcept {
+	auto bucket = min(static_cast<size_t>(bit_width(aValue)), BUCKETS - 1);
+	buckets[bucket].fetch_add(1, memory_order_relaxed);
+	count.fetch_add(1, memory_order_relaxed);
+	sum.fetch_add(aValue, memory_order_relaxed);
+}
+
+Tracer::Span::~Span() {
+	if (start == 0 && !histogram) {
+		return;
+	}
+
+	auto duration = now() - start;
+	if (histogram) {
+		histogram->add(duration);
+	}
+
+	if (isEnabled()) {
+		record(subsystem, name, start, duration);
+	}
+}
+
+Tracer::Counter& Tracer::getCounter(Subsystem aSubsystem, const char* aName) noexcept {
+	return getMetric(getRegistry().counters, aSubsystem, aName);
+}
+
+Tracer::Histogram& Tracer::getHistogram(Subsystem aSubsystem, const char* aName) noexcept {
+	return getMetric(getRegistry().histograms, aSubsystem, aName);
+}
+
+void Tracer::setEnabled(bool aEnabled) noexcept {
+	enabled.store(aEnabled, memory_order_relaxed);
+}
+
+void Tracer::record(Subsystem aSubsystem, const char* aName, uint64_t aStart, uint64_t aDuration) noexcept {
+	auto& ring = getThreadRing();
+
+	Lock l(ring.cs);
+	if (ring.events.size() < RING_SIZE) {
+		ring.events.push_back({ aName, aStart, aDuration, aSubsystem });
+	} else {
+		ring.events[ring.next] = { aName, aStart, aDuration, aSubsystem };
+		ring.next = (ring.next + 1) % RING_SIZE;
+	}
+}
+
+void Tracer::clear() noexcept {
+	auto& registry = getRegistry();
+
+	Lock l(registry.cs);
+
+	// Rings of the exited threads are owned only by the registry
+	std::erase_if(registry.rings, [](const auto& aRing) { return aRing.use_count() == 1; });
+
+	for (const auto& ring: registry.rings) {
+		Lock rl(ring->cs);
+		ring->events.clear();
+		ring->next = 0;
+	}
+}
+
+string Tracer::toChromeTrace() noexcept {
+	auto& registry = getRegistry();
+	auto timestamp = now();
+
+	string ret = "{\"traceEvents\":[";
+	bool first = true;
+	auto addEvent = [&](const string& aEvent) {
+		if (!first) {
+			ret += ",\n";
+		}
+
+		first = false;
+		ret += aEvent;
+	};
+
+	Lock l(registry.cs);
+	for (const auto& ring: registry.rings) {
+		vector<TraceEvent> events;
+		{
+			Lock rl(ring->cs);
+			events = ring->events;
+		}
+
+		for (const auto& e: events) {
+			addEvent(
+				"{\"name\":\"" + escapeJson(e.name) + "\",\"cat\":\"" + getSubsystemName(e.subsystem) +
+				"\",\"ph\":\"X\",\"ts\":" + std::to_string(e.start) + ",\"dur\":" + std::to_string(e.duration) +
+				",\"pid\":1,\"tid\":" + std::to_string(ring->threadId) + "}"
+			);
+		}
+	}
+
+	// Counters of each subsystem are shown as a single track
+	for (int s = 0; s < SUBSYSTEM_LAST; ++s) {
+		string args;
+		for (const auto& [key, counter]: registry.counters) {
+			if (key.first == s) {
+				args += (args.empty() ? "\"" : ",\"") + escapeJson(key.second.c_str()) + "\":" + std::to_string(counter->get());
+			}
+		}
+
+		if (!args.empty()) {
+			addEvent(
+				"{\"name\":\"" + string(getSubsystemName(static_cast<Subsystem>(s))) + "\",\"ph\":\"C\",\"ts\":" + std::to_string(timestamp) +
+				",\"pid\":1,\"args\":{" + args + "}}"
+			);
+		}
+	}
+
+	ret += "],\n\"displayTimeUnit\":\"ms\",\n\"histograms\":{";
+
+	first = true;
+	for (const auto& [key, histogram]: registry.histograms) {
+		string buckets;
+		for (size_t i = 0; i < Histogram::BUCKETS; ++i) {
+			buckets += (i == 0 ? "" : ",") + std::to_string(histogram->getBucket(i));
+		}
+
+		addEvent(
+			"\"" + string(getSubsystemName(key.first)) + "." + escapeJson(key.second.c_str()) + "\":{\"count\":" + std::to_string(histogram->getCount()) +
+			",\"sum\":" + std::to_string(histogram->getSum()) + ",\"buckets\":[" + buckets + "]}"
+		);
+	}
+
+	ret += "}}\n";
+	return ret;
+}
+
+void Tracer::exportChromeTrace(const string& aPath) {
+	auto data = toChromeTrace();
+
+	File f(aPath, File::WRITE, File::CREATE | File::TRUNCATE);
+	f.write(data);
+}
+
+} // namespace dcpp
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2011-2024 AirDC++ Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef DCPLUSPLUS_DCPP_TRACER_H
+#define DCPLUSPLUS_DCPP_TRACER_H
+
+#include <airdcpp/core/header/typedefs.h>
+
+namespace dcpp {
+
+// Low-overhead tracing and metrics for hot paths
+//
+// Spans are stored in per-thread ring buffers while tracing is enabled and they can be exported
+// in the Chrome trace event format (chrome://tracing, Perfetto UI). Counters and histograms are always
+// collected and they are included in the export.
+class Tracer {
+public:
+	enum Subsystem : uint8_t {
+		HASHING,
+		REFRESH,
+		SEARCH,
+		SOCKET,
+		QUEUE,
+		XML,
+		SUBSYSTEM_LAST
+	};
+
+	static const char* getSubsystemName(Subsystem aSubsystem) noexcept;
+
+	// Microseconds from a monotonic clock (never zero)
+	static uint64_t now() noexcept;
+
+	class Counter {
+	public:
+		void add(int64_t aValue = 1) noexcept {
+			value.fetch_add(aValue, memory_order_relaxed);
+		}
+
+		int64_t get() const noexcept {
+			return value.load(memory_order_relaxed);
+		}
+	private:
+		atomic<int64_t> value { 0 };
+	};
+
+	class Histogram {
+	public:
+		// Bucket N contains values below 2^N (the last bucket contains everything larger than that)
+		static const size_t BUCKETS = 32;
+
+		void add(uint64_t aValue) noexcept;
+
+		uint64_t getCount() const noexcept {
+			return count.load(memory_order_relaxed);
+		}
+
+		uint64_t getSum() const noexcept {
+			return sum.load(memory_order_relaxed);
+		}
+
+		uint64_t getBucket(size_t aIndex) const noexcept {
+			return buckets[aIndex].load(memory_order_relaxed);
+		}
+	private:
+		array<atomic<uint64_t>, BUCKETS> buckets {};
+		atomic<uint64_t> count { 0 };
+		atomic<uint64_t> sum { 0 };
+	};
+
+	// Records the duration of the current scope
+	// The name must have a static lifetime
+	class Span {
+	public:
+		// The optional histogram will receive the duration in microseconds even if tracing is disabled
+		Span(Subsystem aSubsystem, const char* aName, Histogram* aHistogram = nullptr) noexcept :
+			name(aName), subsystem(aSubsystem), histogram(aHistogram), start(aHistogram || isEnabled() ? now() : 0) { }
+		~Span();
+
+		Span(const Span&) = delete;
+		Span& operator=(const Span&) = delete;
+	private:
+		const char* name;
+		const Subsystem subsystem;
+		Histogram* const histogram;
+		const uint64_t start;
+	};
+
+	// The returned references remain valid until the process exits
+	// The name must have a static lifetime
+	static Counter& getCounter(Subsystem aSubsystem, const char* aName) noexcept;
+	static Histogram& getHistogram(Subsystem aSubsystem, const char* aName) noexcept;
+
+	static bool isEnabled() noexcept {
+		return enabled.load(memory_order_relaxed);
+	}
+
+	static void setEnabled(bool aEnabled) noexcept;
+
+	// Removes all recorded spans (counters and histograms are kept)
+	static void clear() noexcept;
+
+	// Returns the recorded spans, counters and histograms as Chrome trace JSON
+	static string toChromeTrace() noexcept;
+
+	// Throws FileException
+	static void exportChromeTrace(const string& aPath);
+
+	// Number of latest spans to keep for each thread
+	static const size_t RING_SIZE = 16384;
+private:
+	static void record(Subsystem aSubsystem, const char* aName, uint64_t aStart, uint64_t aDuration) noexcept;
+
+	static atomic<bool> enabled;
+};
+
+} // namespace dcpp
+
+#endif // !defined(DCPLUSPLUS_DCPP_TRACER_H)
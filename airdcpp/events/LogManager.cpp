@@ -28,7 +28,10 @@
 
 namespace dcpp {
 
-LogManager::LogManager() : cache(SettingsManager::LOG_MESSAGE_CACHE), tasks(true, Thread::IDLE) {
+LogManager::LogManager() : cache(SettingsManager::LOG_MESSAGE_CACHE), writer([this](const string& aPath, const string& aError) {
+	// Just don't try to write the error into a file...
+	message(STRING_F(WRITE_FAILED_X, aPath % aError), LogMessage::SEV_NOTIFY, STRING(APPLICATION));
+}) {
 
 	options[UPLOAD][FILE] = SettingsManager::LOG_FILE_UPLOAD;
 	options[UPLOAD][FORMAT] = SettingsManager::LOG_FORMAT_POST_UPLOAD;
@@ -45,6 +48,11 @@ LogManager::LogManager() : cache(SettingsManager::LOG_MESSAGE_CACHE), tasks(true
 }
 
 LogManager::~LogManager() {
+	writer.stop();
+}
+
+void LogManager::flush() noexcept {
+	writer.flush();
 }
 
 void LogManager::log(Area area, ParamMap& params) noexcept {
@@ -161,6 +169,21 @@ string LogManager::readFromEnd(const string& aPath, int aMaxLines, int64_t aBuff
 		return Util::emptyString;
 	}
 
+	if (auto lm = getInstance(); lm) {
+		// Recently written files are available from memory
+		auto lines = lm->writer.readTail(aPath, aMaxLines, aBufferSize);
+		if (lines) {
+			return *lines;
+		}
+
+		// Queued lines must be on disk before reading the file
+		lm->writer.flush();
+	}
+
+	return readFileFromEnd(aPath, aMaxLines, aBufferSize);
+}
+
+string LogManager::readFileFromEnd(const string& aPath, int aMaxLines, int64_t aBufferSize) noexcept {
 	string ret;
 	try {
 		File f(aPath, File::READ, File::OPEN);
@@ -188,18 +211,7 @@ string LogManager::readFromEnd(const string& aPath, int aMaxLines, int64_t aBuff
 }
 
 void LogManager::log(const string& area, const string& msg) noexcept {
-	tasks.addTask([msg, area, this] {
-		auto aArea = PathUtil::validatePath(area);
-		try {
-			File::ensureDirectory(aArea);
-			File f(aArea, File::WRITE, File::OPEN | File::CREATE);
-			f.setEndPos(0);
-			f.write(msg + "\r\n");
-		} catch (const FileException& e) {
-			// Just don't try to write the error into a file...
-			message(STRING_F(WRITE_FAILED_X, aArea % e.what()), LogMessage::SEV_NOTIFY, STRING(APPLICATION));
-		}
-	});
+	writer.write(PathUtil::validatePath(area), msg);
 }
 
 } // namespace dcpp
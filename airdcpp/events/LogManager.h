@@ -25,8 +25,8 @@
 #include <airdcpp/core/header/typedefs.h>
 
 #include <airdcpp/user/CID.h>
-#include <airdcpp/core/queue/DispatcherQueue.h>
 #include <airdcpp/events/LogManagerListener.h>
+#include <airdcpp/events/LogWriter.h>
 #include <airdcpp/message/Message.h>
 #include <airdcpp/message/MessageCache.h>
 #include <airdcpp/core/Singleton.h>
@@ -61,8 +61,14 @@ public:
 	void clearCache() noexcept;
 	void setRead() noexcept;
 
+	// Returns the latest lines from a log file (queued lines are included)
 	static string readFromEnd(const string& aPath, int aMaxLines, int64_t aBufferSize) noexcept;
+
+	// Writes all queued log lines to disk
+	void flush() noexcept;
 private:
+	static string readFileFromEnd(const string& aPath, int aMaxLines, int64_t aBufferSize) noexcept;
+
 	MessageCache cache;
 
 	void log(const string& area, const string& msg) noexcept;
@@ -77,7 +83,7 @@ private:
 	unordered_map<CID, string> pmPaths;
 	static void ensureParam(const string& aParam, string& aFile) noexcept;
 
-	DispatcherQueue tasks;
+	LogWriter writer;
 };
 
 #define LOG(area, msg) LogManager::getInstance()->log(area, msg)
@@ -0,0 +1,260 @@
+/*
+ * Copyright (C) 2011-2024 AirDC++ Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "stdinc.h"
+#include <airdcpp/events/LogWriter.h>
+
+#include <airdcpp/core/classes/Exception.h>
+#include <airdcpp/core/io/File.h>
+#include <airdcpp/core/timer/TimerManager.h>
+#include <airdcpp/util/text/StringTokenizer.h>
+
+namespace dcpp {
+
+LogWriter::LogWriter(ErrorF&& aErrorF) : errorF(std::move(aErrorF)) {
+	started = true;
+	start();
+}
+
+LogWriter::~LogWriter() {
+	stop();
+}
+
+void LogWriter::stop() noexcept {
+	if (!stopping.exchange(true) && started) {
+		s.signal();
+		join();
+	}
+
+	flush();
+}
+
+int LogWriter::run() {
+	setCurrentThreadPriority(Thread::IDLE);
+	while (!stopping) {
+		s.wait(FLUSH_INTERVAL_MS);
+		flush();
+	}
+
+	return 0;
+}
+
+StringList LogWriter::splitLines(const string& aText) noexcept {
+	return StringTokenizer<string>(aText, "\r\n", true).getTokens();
+}
+
+void LogWriter::Tail::addLines(const StringList& aLines) noexcept {
+	for (const auto& line: aLines) {
+		lines.push_back(line);
+	}
+
+	while (lines.size() > MAX_TAIL_LINES) {
+		lines.pop_front();
+		complete = false;
+	}
+}
+
+void LogWriter::write(const string& aPath, const string& aLine) noexcept {
+	auto lines = splitLines(aLine);
+
+	bool flushNow = false, wakeWriter = false;
+
+	{
+		Lock l(cs);
+		if (auto tail = tails.find(aPath); tail != tails.end()) {
+			tail->second.addLines(lines);
+		}
+
+		pendingBytes += aLine.size() + 2;
+
+		auto p = ranges::find_if(pending, [&aPath](const auto& aPending) { return aPending.first == aPath; });
+		if (p == pending.end()) {
+			pending.emplace_back(aPath, std::move(lines));
+		} else {
+			std::move(lines.begin(), lines.end(), back_inserter(p->second));
+		}
+
+		flushNow = pendingBytes >= MAX_PENDING_BYTES || stopping;
+		wakeWriter = pendingBytes >= FLUSH_THRESHOLD_BYTES;
+	}
+
+	if (flushNow) {
+		// The writer isn't keeping up, write the queue from this thread
+		flush();
+	} else if (wakeWriter) {
+		s.signal();
+	}
+}
+
+void LogWriter::flush() noexcept {
+	Lock l(flushCS);
+	flushPending();
+	closeIdleFiles();
+}
+
+void LogWriter::flushPending() noexcept {
+	PendingList toWrite;
+
+	{
+		Lock l(cs);
+		toWrite.swap(pending);
+		pendingBytes = 0;
+	}
+
+	for (const auto& [path, lines]: toWrite) {
+		string data;
+		for (const auto& line: lines) {
+			data += line;
+			data += "\r\n";
+		}
+
+		try {
+			auto& f = getFile(path, lines);
+			f.write(data);
+		} catch (const FileException& e) {
+			closeFile(path);
+			errorF(path, e.getError());
+		}
+	}
+}
+
+File& LogWriter::getFile(const string& aPath, const StringList& aNewLines) {
+	auto i = openFileIndex.find(aPath);
+	if (i != openFileIndex.end()) {
+		// Move to front
+		openFiles.splice(openFiles.begin(), openFiles, i->second);
+		i->second->lastUsed = GET_TICK();
+		return *i->second->file;
+	}
+
+	File::ensureDirectory(aPath);
+	auto f = make_unique<File>(aPath, File::RW, File::OPEN | File::CREATE);
+
+	// Read the existing tail
+	Tail tail;
+	{
+		auto size = f->getSize();
+		auto buf = f->readFromEnd(TAIL_SEED_BYTES);
+
+		StringList lines;
+		if (Util::strnicmp(buf.c_str(), "\xef\xbb\xbf", 3) == 0) {
+			// Remove UTF-8 BOM
+			lines = splitLines(buf.substr(3));
+		} else {
+			lines = splitLines(buf);
+		}
+
+		if (!lines.empty() && lines.back().empty()) {
+			// Separator after the last line
+			lines.pop_back();
+		}
+
+		tail.complete = size <= static_cast<int64_t>(TAIL_SEED_BYTES);
+		if (!tail.complete && !lines.empty()) {
+			// Partial line
+			lines.erase(lines.begin());
+		}
+
+		tail.addLines(lines);
+	}
+
+	f->setEndPos(0);
+
+	{
+		Lock l(cs);
+
+		// Lines that are being written
+		tail.addLines(aNewLines);
+
+		// Lines that have been queued after the flush was started
+		if (auto p = ranges::find_if(pending, [&aPath](const auto& aPending) { return aPending.first == aPath; }); p != pending.end()) {
+			tail.addLines(p->second);
+		}
+
+		tails[aPath] = std::move(tail);
+	}
+
+	openFiles.push_front({ aPath, std::move(f), GET_TICK() });
+	openFileIndex[aPath] = openFiles.begin();
+
+	if (openFiles.size() > MAX_OPEN_FILES) {
+		closeFile(openFiles.back().path);
+	}
+
+	return *openFiles.front().file;
+}
+
+void LogWriter::closeFile(const string& aPath) noexcept {
+	{
+		Lock l(cs);
+		tails.erase(aPath);
+	}
+
+	auto i = openFileIndex.find(aPath);
+	if (i == openFileIndex.end()) {
+		return;
+	}
+
+	openFiles.erase(i->second);
+	openFileIndex.erase(i);
+}
+
+void LogWriter::closeIdleFiles() noexcept {
+	auto tick = GET_TICK();
+	while (!openFiles.empty() && openFiles.back().lastUsed + IDLE_CLOSE_MS < tick) {
+		closeFile(openFiles.back().path);
+	}
+}
+
+optional<string> LogWriter::readTail(const string& aPath, int aMaxLines, int64_t aMaxBytes) const noexcept {
+	Lock l(cs);
+	auto i = tails.find(aPath);
+	if (i == tails.end()) {
+		return nullopt;
+	}
+
+	const auto& tail = i->second;
+	if (!tail.complete && static_cast<int>(tail.lines.size()) < aMaxLines) {
+		return nullopt;
+	}
+
+	// Pick the lines from the end while they fit in the byte limit
+	auto begin = tail.lines.end();
+	int64_t bytes = 0;
+	for (int count = 0; begin != tail.lines.begin() && count < aMaxLines; ++count) {
+		auto lineBytes = static_cast<int64_t>(prev(begin)->size()) + 2;
+		if (bytes + lineBytes > aMaxBytes) {
+			break;
+		}
+
+		bytes += lineBytes;
+		--begin;
+	}
+
+	string ret;
+	ret.reserve(static_cast<size_t>(bytes) + 2);
+	for (auto j = begin; j != tail.lines.end(); ++j) {
+		ret += *j + "\r\n";
+	}
+
+	// The trailing empty line, similar to the file tokenizer in LogManager::readFromEnd
+	ret += "\r\n";
+	return ret;
+}
+
+} // namespace dcpp
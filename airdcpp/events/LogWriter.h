@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2011-2024 AirDC++ Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef DCPLUSPLUS_DCPP_LOG_WRITER_H
+#define DCPLUSPLUS_DCPP_LOG_WRITER_H
+
+#include <airdcpp/core/header/typedefs.h>
+
+#include <airdcpp/core/thread/CriticalSection.h>
+#include <airdcpp/core/thread/Semaphore.h>
+#include <airdcpp/core/thread/Thread.h>
+
+namespace dcpp {
+
+class File;
+
+// Asynchronous appender for log files
+//
+// Queued lines are collected per file and written in batches at most FLUSH_INTERVAL_MS after queuing.
+// The most recently used files are kept open and a tail of the latest lines is kept in memory for each of them.
+class LogWriter : private Thread {
+public:
+	// Called from the writer thread when writing of a file fails
+	using ErrorF = std::function<void (const string& aPath, const string& aError)>;
+
+	static const size_t MAX_OPEN_FILES = 16;
+	static const uint32_t FLUSH_INTERVAL_MS = 1000;
+
+	// The writer thread is woken up immediately after this much data has been queued
+	static const size_t FLUSH_THRESHOLD_BYTES = 64 * 1024;
+
+	// Producers will write the queue synchronously after this limit has been reached
+	static const size_t MAX_PENDING_BYTES = 1024 * 1024;
+
+	// Number of latest lines to keep in memory for each open file
+	static const size_t MAX_TAIL_LINES = 500;
+
+	explicit LogWriter(ErrorF&& aErrorF);
+	~LogWriter() override;
+
+	void write(const string& aPath, const string& aLine) noexcept;
+
+	// Writes all queued lines to disk (blocking)
+	void flush() noexcept;
+
+	// Writes all queued lines and stops the writer thread
+	void stop() noexcept;
+
+	// Returns the latest lines for a file from memory (the format is similar to LogManager::readFromEnd)
+	// Returns nullopt if the lines aren't available from memory
+	optional<string> readTail(const string& aPath, int aMaxLines, int64_t aMaxBytes) const noexcept;
+
+	LogWriter(const LogWriter&) = delete;
+	LogWriter& operator=(const LogWriter&) = delete;
+private:
+	int run() override;
+
+	struct Tail {
+		std::deque<string> lines;
+
+		// Whether the tail contains all lines from the file
+		bool complete = false;
+
+		void addLines(const StringList& aLines) noexcept;
+	};
+
+	// Lines waiting to be written
+	// The vector is used to preserve the write order of different files
+	using PendingList = vector<pair<string, StringList>>;
+
+	struct OpenFile {
+		string path;
+		unique_ptr<File> file;
+		uint64_t lastUsed;
+	};
+
+	using OpenFileList = std::list<OpenFile>;
+
+	// Amount of data to read from the end of the file when creating a new tail
+	static const size_t TAIL_SEED_BYTES = 64 * 1024;
+
+	// Files that haven't been written during this period will be closed
+	static const uint64_t IDLE_CLOSE_MS = 5 * 60 * 1000;
+
+	// Writes the queued lines (must be called with flushCS held)
+	void flushPending() noexcept;
+	void closeIdleFiles() noexcept;
+
+	File& getFile(const string& aPath, const StringList& aNewLines);
+	void closeFile(const string& aPath) noexcept;
+
+	static StringList splitLines(const string& aText) noexcept;
+
+	const ErrorF errorF;
+
+	// Protects the pending queue and tails
+	mutable CriticalSection cs;
+	PendingList pending;
+	size_t pendingBytes = 0;
+	unordered_map<string, Tail> tails;
+
+	// Protects the open files (only a single flush may be running at once)
+	CriticalSection flushCS;
+
+	// Least recently used files are at the end
+	OpenFileList openFiles;
+	unordered_map<string, OpenFileList::iterator> openFileIndex;
+
+	Semaphore s;
+	atomic<bool> stopping = false;
+	bool started = false;
+};
+
+} // namespace dcpp
+
+#endif // !defined(DCPLUSPLUS_DCPP_LOG_WRITER_H)
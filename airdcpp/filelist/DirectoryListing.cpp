@@ -241,6 +241,16 @@ void DirectoryListing::loadFile() {
 		dcpp::File ff(fileName, dcpp::File::READ, dcpp::File::OPEN, dcpp::File::BUFFER_AUTO);
 		root->setLastUpdateDate(ff.getLastModified());
 		if(Util::stricmp(ext, ".bz2") == 0) {
+			if (ff.getSize() >= PARALLEL_LOAD_MIN_SIZE && ff.getSize() <= static_cast<int64_t>(PARALLEL_LOAD_MAX_XML_SIZE)) {
+				// Decompress and parse large lists in parallel
+				if (auto xml = BZUtil::decodeBZ2Parallel(ff.read(), PARALLEL_LOAD_MAX_XML_SIZE); xml) {
+					loadFullXml(*xml, ff.getLastModified());
+					return;
+				}
+
+				ff.setPos(0);
+			}
+
 			FilteredInputStream<UnBZFilter, false> f(&ff);
 			loadXML(f, false, ADC_ROOT_STR, ff.getLastModified());
 		} else if(Util::stricmp(ext, ".xml") == 0) {
@@ -250,8 +260,26 @@ void DirectoryListing::loadFile() {
 }
 
 int DirectoryListing::loadPartialXml(const string& aXml, const string& aBase) {
-	MemoryInputStream mis(aXml);
-	return loadXML(mis, true, aBase, GET_TIME());
+	// The list is in memory already, parse it without copying
+	ListLoader ll(this, aBase, true, GET_TIME());
+	try {
+		dcpp::SimpleXMLReader(&ll).parseDocument(aXml);
+	} catch (SimpleXMLException& e) {
+		throw AbortException(e.getError());
+	}
+
+	return ll.getLoadedDirs();
+}
+
+void DirectoryListing::loadFullXml(string_view aXml, time_t aListDate) {
+	try {
+		if (!ListLoader::loadParallel(this, aXml, aListDate)) {
+			ListLoader ll(this, ADC_ROOT_STR, false, aListDate);
+			dcpp::SimpleXMLReader(&ll).parseDocument(aXml);
+		}
+	} catch (SimpleXMLException& e) {
+		throw AbortException(e.getError());
+	}
 }
 
 int DirectoryListing::loadXML(InputStream& is, bool aUpdating, const string& aBase, time_t aListDate) {
@@ -187,6 +187,17 @@ private:
 	// Throws AbortException
 	int loadXML(InputStream& aXml, bool aUpdating, const string& aBase, time_t aListDate);
 
+	// Loads a complete list from memory
+	// Throws AbortException
+	void loadFullXml(string_view aXml, time_t aListDate);
+
+	// Compressed lists larger than this are decompressed and parsed in parallel
+	static const int64_t PARALLEL_LOAD_MIN_SIZE = 1024 * 1024;
+
+	// Parallel loading keeps the whole XML in memory, larger lists are loaded as a stream
+	// (checked against the compressed size first, the decompressed size is estimated by the decoder before the actual decompression)
+	static const size_t PARALLEL_LOAD_MAX_XML_SIZE = 512 * 1024 * 1024;
+
 	// Create and insert a base directory with the given path (or return an existing one)
 	DirectoryPtr createBaseDirectory(const string& aPath, time_t aDownloadDate);
 
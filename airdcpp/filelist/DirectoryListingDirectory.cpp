@@ -46,8 +46,8 @@ bool DirectoryListing::File::Sort::operator()(const Ptr& a, const Ptr& b) const
 	return compare(a->getName(), b->getName()) < 0;
 }
 
-DirectoryListing::File::File(Directory* aDir, const string& aName, int64_t aSize, const TTHValue& aTTH, time_t aRemoteDate) noexcept :
-	name(aName), size(aSize), parent(aDir), tthRoot(aTTH), remoteDate(aRemoteDate), token(itemIdCounter++) {
+DirectoryListing::File::File(Directory* aDir, string_view aName, const SharedStringPoolPtr& aNamePool, int64_t aSize, const TTHValue& aTTH, time_t aRemoteDate) noexcept :
+	size(aSize), parent(aDir), tthRoot(aTTH), name(aName.data()), namePool(aNamePool), token(itemIdCounter++), nameLength(static_cast<uint32_t>(aName.size())), remoteDate(toRemoteDate(aRemoteDate)) {
 
 	if (size > 0) {
 		dupe = DupeUtil::checkFileDupe(tthRoot);
@@ -57,22 +57,22 @@ DirectoryListing::File::File(Directory* aDir, const string& aName, int64_t aSize
 }
 
 string DirectoryListing::File::getAdcPathUnsafe() const noexcept {
-	return parent->getAdcPathUnsafe() + name;
+	return parent->getAdcPathUnsafe() + string(getName());
 }
 
 DirectoryListing::File::File(const File& rhs, File::Owner aOwner) noexcept : 
-	name(rhs.name), size(rhs.size), parent(rhs.parent), tthRoot(rhs.tthRoot), 
-	dupe(rhs.dupe), remoteDate(rhs.remoteDate), owner(aOwner), token(itemIdCounter++)
+	size(rhs.size), parent(rhs.parent), tthRoot(rhs.tthRoot), name(rhs.name), namePool(rhs.namePool), owner(aOwner),
+	token(itemIdCounter++), nameLength(rhs.nameLength), remoteDate(rhs.remoteDate), dupe(rhs.dupe)
 {
-	dcdebug("DirectoryListing::File (copy) %s was created\n", rhs.getName().c_str());
+	dcdebug("DirectoryListing::File (copy) %s was created\n", rhs.name);
 }
 
-DirectoryListing::Directory::Ptr DirectoryListing::Directory::create(Directory* aParent, const string& aName, DirType aType, time_t aUpdateDate, const DirectoryContentInfo& aContentInfo, const string& aSize, time_t aRemoteDate) {
+DirectoryListing::Directory::Ptr DirectoryListing::Directory::create(Directory* aParent, string aName, DirType aType, time_t aUpdateDate, const DirectoryContentInfo& aContentInfo, const string& aSize, time_t aRemoteDate) {
 	dcassert(aType != TYPE_VIRTUAL);
-	auto dir = Ptr(new Directory(aParent, aName, aType, aUpdateDate, aContentInfo, aSize, aRemoteDate));
+	auto dir = Ptr(new Directory(aParent, std::move(aName), aType, aUpdateDate, aContentInfo, aSize, aRemoteDate));
 	if (aParent) {
 		dcassert(!aParent->directories.contains(&dir->getName()));
-		auto [dp, inserted] = aParent->directories.try_emplace(&dir->getName(), dir);
+		auto [dp, inserted] = aParent->directories.emplace_sorted(&dir->getName(), dir);
 		if (!inserted) {
 			throw AbortException("The directory " + dir->getAdcPathUnsafe() + " contains items with duplicate names (" + dir->getName() + ", " + *(*dp).first + ")");
 		}
@@ -101,19 +101,19 @@ DirectoryListing::VirtualDirectory::Ptr DirectoryListing::VirtualDirectory::crea
 
 	if (aAddToParent) {
 		dcassert(!aParent->directories.contains(&dir->getName()));
-		aParent->directories.try_emplace(&dir->getName(), dir);
+		aParent->directories.emplace_sorted(&dir->getName(), dir);
 	}
 
 	return dir;
 }
 
 DirectoryListing::VirtualDirectory::VirtualDirectory(const string& aFullAdcPath, DirectoryListing::Directory* aParent, const string& aName) :
-	Directory(aParent, aName, Directory::TYPE_VIRTUAL, GET_TIME(), DirectoryContentInfo::uninitialized(), Util::emptyString, 0), fullAdcPath(aFullAdcPath) {
+	Directory(aParent, string(aName), Directory::TYPE_VIRTUAL, GET_TIME(), DirectoryContentInfo::uninitialized(), Util::emptyString, 0), fullAdcPath(aFullAdcPath) {
 
 }
 
-DirectoryListing::Directory::Directory(Directory* aParent, const string& aName, Directory::DirType aType, time_t aUpdateDate, const DirectoryContentInfo& aContentInfo, const string& aSize, time_t aRemoteDate /*0*/)
-	: parent(aParent), type(aType), remoteDate(aRemoteDate), lastUpdateDate(aUpdateDate), contentInfo(aContentInfo), name(aName), token(itemIdCounter++) {
+DirectoryListing::Directory::Directory(Directory* aParent, string&& aName, Directory::DirType aType, time_t aUpdateDate, const DirectoryContentInfo& aContentInfo, const string& aSize, time_t aRemoteDate /*0*/)
+	: parent(aParent), type(aType), remoteDate(aRemoteDate), lastUpdateDate(aUpdateDate), contentInfo(aContentInfo), name(std::move(aName)), token(itemIdCounter++) {
 
 	if (!aSize.empty()) {
 		partialSize = Util::toInt64(aSize);
@@ -181,7 +181,7 @@ void DirectoryListing::Directory::toBundleInfoList(const string& aTarget, Bundle
 
 	// Then add the files
 	for (const auto& f: files) {
-		aFiles.emplace_back(aTarget + f->getName(), f->getTTH(), f->getSize(), Priority::DEFAULT, f->getRemoteDate());
+		aFiles.emplace_back(aTarget + string(f->getName()), f->getTTH(), f->getSize(), Priority::DEFAULT, f->getRemoteDate());
 	}
 }
 
@@ -246,7 +246,7 @@ void DirectoryListing::File::getLocalPathsUnsafe(StringList& ret, const Optional
 			path = parent->getAdcPathUnsafe();
 		}
 
-		ShareManager::getInstance()->getRealPaths(path + name, ret, aShareProfileToken);
+		ShareManager::getInstance()->getRealPaths(path + string(getName()), ret, aShareProfileToken);
 	} else {
 		ret = DupeUtil::getFileDupePaths(dupe, tthRoot);
 	}
@@ -28,6 +28,8 @@
 #include <airdcpp/core/types/GetSet.h>
 #include <airdcpp/util/Util.h>
 #include <airdcpp/queue/QueueAddInfo.h>
+#include <airdcpp/core/classes/SortedVector.h>
+#include <airdcpp/core/classes/StringPool.h>
 
 namespace dcpp {
 
@@ -43,20 +45,27 @@ public:
 
 	using List = std::vector<Ptr>;
 	using Iter = List::const_iterator;
-		
-	File(Directory* aDir, const string& aName, int64_t aSize, const TTHValue& aTTH, time_t aRemoteDate) noexcept;
+
+	// The name must be stored in the pool (the file keeps a reference to it)
+	File(Directory* aDir, string_view aName, const SharedStringPoolPtr& aNamePool, int64_t aSize, const TTHValue& aTTH, time_t aRemoteDate) noexcept;
 	File(const File& rhs, Owner aOwner) noexcept;
 
 	~File() = default;
 
 	string getAdcPathUnsafe() const noexcept;
 
-	GETSET(string, name, Name);
+	// The name is null-terminated and stays valid for the lifetime of the file
+	string_view getName() const noexcept { return { name, nameLength }; }
+
 	GETSET(int64_t, size, Size);
 	GETSET(Directory*, parent, Parent);
 	GETSET(TTHValue, tthRoot, TTH);
-	IGETSET(DupeType, dupe, Dupe, DUPE_NONE);
-	IGETSET(time_t, remoteDate, RemoteDate, 0);
+
+	DupeType getDupe() const noexcept { return dupe; }
+	void setDupe(DupeType aDupe) noexcept { dupe = aDupe; }
+
+	time_t getRemoteDate() const noexcept { return remoteDate; }
+	void setRemoteDate(time_t aDate) noexcept { remoteDate = toRemoteDate(aDate); }
 
 	bool isInQueue() const noexcept;
 
@@ -68,8 +77,20 @@ public:
 	}
 	void getLocalPathsUnsafe(StringList& ret, const OptionalProfileToken& aShareProfileToken) const;
 private:
+	// Large lists contain millions of files, keep the fields packed
+	const char* const name;
+
+	// Loaded files share the pool of their loader, so that the names of a reloaded list (or directory)
+	// are freed when the old files are gone
+	const SharedStringPoolPtr namePool;
 	Owner owner = nullptr;
 	const DirectoryListingItemToken token;
+	const uint32_t nameLength;
+
+	// Remote dates are validated to be non-negative (dates after year 2106 are clamped)
+	uint32_t remoteDate;
+	static uint32_t toRemoteDate(time_t aDate) noexcept { return static_cast<uint32_t>(std::clamp<time_t>(aDate, 0, UINT32_MAX)); }
+	DupeType dupe = DUPE_NONE;
 };
 
 enum class DirectoryListing::DirectoryLoadType {
@@ -94,12 +115,23 @@ public:
 
 	using List = std::vector<Ptr>;
 	using TTHSet = unordered_set<TTHValue>;
-	using Map = map<const string *, Ptr, noCaseStringLess>;
+
+	struct NameCompare {
+		int operator()(const string* a, const string* b) const noexcept { return Util::stricmp(*a, *b); }
+	};
+
+	struct NamePtr {
+		const string* operator()(const pair<const string*, Ptr>& a) const noexcept { return a.first; }
+	};
+
+	// A sorted vector takes considerably less memory than a node-based map with large lists
+	// Inserting items that are sorted already is cheap, full lists are loaded unsorted and sorted once per directory
+	using Map = SortedVector<pair<const string*, Ptr>, std::vector, const string*, NameCompare, NamePtr>;
 		
 	Map directories;
 	File::List files;
 
-	static Ptr create(Directory* aParent, const string& aName, DirType aType, time_t aUpdateDate, 
+	static Ptr create(Directory* aParent, string aName, DirType aType, time_t aUpdateDate, 
 		const DirectoryContentInfo& aContentInfo = DirectoryContentInfo::uninitialized(),
 		const string& aSize = Util::emptyString, time_t aRemoteDate = 0);
 
@@ -161,7 +193,7 @@ public:
 protected:
 	void toBundleInfoList(const string& aTarget, BundleFileAddData::List& aFiles) const noexcept;
 
-	Directory(Directory* aParent, const string& aName, DirType aType, time_t aUpdateDate, const DirectoryContentInfo& aContentInfo, const string& aSize, time_t aRemoteDate);
+	Directory(Directory* aParent, string&& aName, DirType aType, time_t aUpdateDate, const DirectoryContentInfo& aContentInfo, const string& aSize, time_t aRemoteDate);
 
 	void getContentInfo(size_t& directories_, size_t& files_, bool aCountVirtual) const noexcept;
 
@@ -180,7 +212,7 @@ private:
 };
 
 inline bool operator==(const DirectoryListing::Directory::Ptr& a, const string& b) { return Util::stricmp(a->getName(), b) == 0; }
-inline bool operator==(const DirectoryListing::File::Ptr& a, const string& b) { return Util::stricmp(a->getName(), b) == 0; }
+inline bool operator==(const DirectoryListing::File::Ptr& a, const string& b) { return Util::stricmp(a->getName().data(), b.c_str()) == 0; }
 
 } // namespace dcpp
 
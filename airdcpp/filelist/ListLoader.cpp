@@ -24,6 +24,7 @@
 #include <airdcpp/util/PathUtil.h>
 #include <airdcpp/core/localization/ResourceManager.h>
 #include <airdcpp/core/io/xml/SimpleXML.h>
+#include <airdcpp/core/thread/concurrency.h>
 
 
 namespace dcpp {
@@ -37,6 +38,20 @@ ListLoader::ListLoader(DirectoryListing* aList, const string& aBase,
 	partialList(aList->getPartialList()), listDownloadDate(aListDownloadDate) {
 }
 
+ListLoader::ListLoader(DirectoryListing* aList, DirectoryListing::Directory* aDetachedParent, time_t aListDownloadDate) :
+	list(aList), cur(aDetachedParent), inListing(true), base(ADC_ROOT_STR), updating(false),
+	partialList(aList->getPartialList()), listDownloadDate(aListDownloadDate) {
+}
+
+ListLoader::~ListLoader() {
+	if (!updating) {
+		// Directories that weren't finished aren't sorted if the loading was aborted
+		for (auto d = cur; d; d = d->getParent()) {
+			d->directories.sort_unique();
+		}
+	}
+}
+
 void ListLoader::validateName(const string_view& aName) {
 	if (aName.empty()) {
 		throw SimpleXMLException("Name attribute missing");
@@ -65,24 +80,27 @@ static const string sSize = "Size";
 static const string sTTH = "TTH";
 static const string sDate = "Date";
 
-void ListLoader::loadFile(StringPairList& attribs, bool) {
-	const string& n = getAttrib(attribs, sName, 0);
+void ListLoader::loadFile(const SimpleXMLReader::AttribViewList& attribs, bool) {
+	auto n = getAttrib(attribs, sName, 0);
 	validateName(n);
 
-	const string& s = getAttrib(attribs, sSize, 1);
+	auto s = getAttrib(attribs, sSize, 1);
 	if (s.empty())
 		return;
 
-	auto size = Util::toInt64(s);
+	auto size = toInt64(s);
 
-	const string& h = getAttrib(attribs, sTTH, 2);
+	auto h = getAttrib(attribs, sTTH, 2);
 	if (h.empty())
 		return;
 
-	TTHValue tth(h); /// @todo verify validity?
+	TTHValue tth{ string(h) }; /// @todo verify validity?
+
+	cur->files.push_back(make_shared<DirectoryListing::File>(cur, names->add(n), names, size, tth, parseDate(getAttrib(attribs, sDate, 3))));
+}
 
-	auto f = make_shared<DirectoryListing::File>(cur, n, size, tth, Util::parseRemoteFileItemDate(getAttrib(attribs, sDate, 3)));
-	cur->files.push_back(f);
+time_t ListLoader::parseDate(string_view aDate) noexcept {
+	return Util::validateRemoteFileItemDate(toTimeT(aDate));
 }
 
 DirectoryListing::Directory::DirType ListLoader::parseDirectoryType(bool aIncomplete, const DirectoryContentInfo& aContentInfo) noexcept {
@@ -96,21 +114,23 @@ DirectoryListing::Directory::DirType ListLoader::parseDirectoryType(bool aIncomp
 	return DirectoryListing::Directory::TYPE_INCOMPLETE_NOCHILD;
 }
 
-void ListLoader::loadDirectory(StringPairList& attribs, bool) {
-	const string& name = getAttrib(attribs, sName, 0);
-	validateName(name);
+void ListLoader::loadDirectory(const SimpleXMLReader::AttribViewList& attribs, bool) {
+	auto nameView = getAttrib(attribs, sName, 0);
+	validateName(nameView);
+
+	string name(nameView);
 
 	bool incomplete = getAttrib(attribs, sIncomplete, 1) == "1";
-	auto& directoriesStr = getAttrib(attribs, sDirectories, 2);
-	auto& filesStr = getAttrib(attribs, sFiles, 3);
+	auto directoriesStr = getAttrib(attribs, sDirectories, 2);
+	auto filesStr = getAttrib(attribs, sFiles, 3);
 
 	auto contentInfo(DirectoryContentInfo::empty());
 	if (!incomplete || !filesStr.empty() || !directoriesStr.empty()) {
-		contentInfo = DirectoryContentInfo(Util::toInt(directoriesStr), Util::toInt(filesStr));
+		contentInfo = DirectoryContentInfo(toInt(directoriesStr), toInt(filesStr));
 	}
 
-	const string& size = getAttrib(attribs, sSize, 2);
-	const string& date = getAttrib(attribs, sDate, 3);
+	const string size(getAttrib(attribs, sSize, 2));
+	auto date = parseDate(getAttrib(attribs, sDate, 3));
 
 	DirectoryListing::DirectoryPtr d = nullptr;
 	if (updating) {
@@ -124,19 +144,27 @@ void ListLoader::loadDirectory(StringPairList& attribs, bool) {
 
 	if (!d) {
 		auto type = parseDirectoryType(incomplete, contentInfo);
-		d = DirectoryListing::Directory::create(cur, name, type, listDownloadDate, contentInfo, size, Util::parseRemoteFileItemDate(date));
+		if (updating) {
+			// Existing directories are being looked up
+			d = DirectoryListing::Directory::create(cur, std::move(name), type, listDownloadDate, contentInfo, size, date);
+		} else {
+			// Directories are sorted when the parent is finished (lists generated by other clients aren't necessarily sorted)
+			d = DirectoryListing::Directory::create(nullptr, std::move(name), type, listDownloadDate, contentInfo, size, date);
+			d->setParent(cur);
+			cur->directories.emplace_unsorted(&d->getName(), d);
+		}
 	} else {
 		if (!incomplete) {
 			d->setComplete();
 		}
-		d->setRemoteDate(Util::parseRemoteFileItemDate(date));
+		d->setRemoteDate(date);
 	}
 	cur = d.get();
 }
 
-void ListLoader::loadListing(StringPairList& attribs, bool) {
+void ListLoader::loadListing(const SimpleXMLReader::AttribViewList& attribs, bool) {
 	if (updating) {
-		const string& b = getAttrib(attribs, sBase, 2);
+		const string b(getAttrib(attribs, sBase, 2));
 		dcassert(PathUtil::isAdcDirectoryPath(base));
 
 		// Validate the parsed base path
@@ -150,8 +178,7 @@ void ListLoader::loadListing(StringPairList& attribs, bool) {
 
 		dcassert(list->findDirectoryUnsafe(base));
 
-		const string& baseDate = getAttrib(attribs, sBaseDate, 3);
-		cur->setRemoteDate(Util::parseRemoteFileItemDate(baseDate));
+		cur->setRemoteDate(parseDate(getAttrib(attribs, sBaseDate, 3)));
 	}
 
 	// Set the root complete only after we have finished loading 
@@ -160,7 +187,7 @@ void ListLoader::loadListing(StringPairList& attribs, bool) {
 	inListing = true;
 }
 
-void ListLoader::startTag(const string& aName, StringPairList& attribs, bool aSimple) {
+void ListLoader::startTagView(const string& aName, const SimpleXMLReader::AttribViewList& attribs, bool aSimple) {
 	if(list->getClosing()) {
 		throw AbortException();
 	}
@@ -189,23 +216,235 @@ void ListLoader::startTag(const string& aName, StringPairList& attribs, bool aSi
 void ListLoader::endTag(const string& aName) {
 	if(inListing) {
 		if(aName == sDirectory) {
+			if (!updating) {
+				sortDirectories(*cur);
+			}
+
 			cur = cur->getParent();
 		} else if (aName == sFileListing) {
-			// Cur should be the loaded base path now
+			if (!updating) {
+				sortDirectories(*cur);
+			}
+
+			completeListing();
+		}
+	}
+}
+
+void ListLoader::sortDirectories(DirectoryListing::Directory& aDir) {
+	auto dupe = aDir.directories.sort_unique();
+	if (dupe != aDir.directories.end()) {
+		throw AbortException("The directory " + aDir.getAdcPathUnsafe() + " contains items with duplicate names (" + *(*dupe).first + ")");
+	}
+}
+
+void ListLoader::completeListing() noexcept {
+	// Cur should be the loaded base path now
+
+	cur->setComplete();
+
+	if (list->loadHooks && list->loadHooks->hasSubscribers()) {
+		list->updateStatus(STRING(RUNNING_HOOKS));
+		runHooksRecursive(list->getRoot());
+	}
+
+	// Content info is not loaded for the base path
+	cur->setContentInfo(cur->getContentInfoRecursive(false));
+
+	inListing = false;
+}
+
+namespace {
+
+using XmlRange = pair<size_t, size_t>;
+
+// Returns the position after the end of a tag starting from aPos (or string::npos)
+size_t findTagEnd(string_view aXml, size_t aPos) noexcept {
+	for (auto i = aPos; i < aXml.size(); ++i) {
+		if (aXml[i] == '>') {
+			return i + 1;
+		}
+
+		if (aXml[i] == '"' || aXml[i] == '\'') {
+			i = aXml.find(aXml[i], i + 1);
+			if (i == string_view::npos) {
+				break;
+			}
+		}
+	}
+
+	return string_view::npos;
+}
+
+bool isTag(string_view aXml, size_t aPos, string_view aName) noexcept {
+	if (aXml.compare(aPos, aName.size(), aName) != 0 || aPos + aName.size() >= aXml.size()) {
+		return false;
+	}
+
+	auto next = aXml[aPos + aName.size()];
+	return next == ' ' || next == '\t' || next == '\r' || next == '\n' || next == '/' || next == '>';
+}
+
+// Returns the ranges of the top-level items in a file list
+// Documents with any content that the splitter doesn't recognize are rejected
+optional<vector<XmlRange>> splitListing(string_view aXml) noexcept {
+	size_t pos = 0;
+	if (aXml.starts_with("\xef\xbb\xbf")) {
+		pos = 3;
+	}
+
+	// The encoding isn't passed to the subtree parsers
+	if (aXml.compare(pos, 5, "<?xml") == 0) {
+		auto declEnd = aXml.find("?>", pos);
+		if (declEnd == string_view::npos) {
+			return nullopt;
+		}
+
+		auto decl = aXml.substr(pos, declEnd - pos);
+		auto encoding = decl.find("encoding");
+		if (encoding != string_view::npos) {
+			auto valueStart = decl.find_first_of("\"'", encoding);
+			if (valueStart == string_view::npos || Util::strnicmp(decl.data() + valueStart + 1, "utf-8", 5) != 0) {
+				return nullopt;
+			}
+		}
+
+		pos = declEnd + 2;
+	}
 
-			cur->setComplete();
+	pos = aXml.find('<', pos);
+	if (pos == string_view::npos || !isTag(aXml, pos, "<FileListing")) {
+		return nullopt;
+	}
+
+	pos = findTagEnd(aXml, pos);
+	if (pos == string_view::npos || aXml[pos - 2] == '/') {
+		return nullopt;
+	}
 
-			if (list->loadHooks && list->loadHooks->hasSubscribers()) {
-				list->updateStatus(STRING(RUNNING_HOOKS));
-				runHooksRecursive(list->getRoot());
+	vector<XmlRange> ret;
+	size_t depth = 0;
+	size_t itemStart = 0;
+	while ((pos = aXml.find('<', pos)) != string_view::npos) {
+		const auto tagStart = pos;
+		if (aXml.compare(pos, 12, "</Directory>") == 0) {
+			if (depth == 0) {
+				return nullopt;
+			}
+
+			pos += 12;
+			if (--depth == 0) {
+				ret.emplace_back(itemStart, pos);
+			}
+		} else if (isTag(aXml, pos, "<Directory") || isTag(aXml, pos, "<File")) {
+			pos = findTagEnd(aXml, pos);
+			if (pos == string_view::npos) {
+				return nullopt;
 			}
 
-			// Content info is not loaded for the base path
-			cur->setContentInfo(cur->getContentInfoRecursive(false));
+			const auto simple = aXml[pos - 2] == '/';
+			if (depth == 0) {
+				if (simple) {
+					ret.emplace_back(tagStart, pos);
+				} else {
+					itemStart = tagStart;
+				}
+			}
+
+			if (!simple) {
+				if (aXml[tagStart + 1] != 'D') {
+					// Only directories may have content
+					return nullopt;
+				}
+
+				depth++;
+			}
+		} else if (depth == 0 && aXml.compare(pos, 14, "</FileListing>") == 0) {
+			return ret;
+		} else {
+			// Comments, CDATA, unknown elements...
+			return nullopt;
+		}
+	}
+
+	return nullopt;
+}
+
+}
+
+void ListLoader::attachItems(DirectoryListing::Directory& aDetachedParent, DirectoryListing::Directory& aRoot) {
+	for (const auto& [name, d]: aDetachedParent.directories) {
+		d->setParent(&aRoot);
+		aRoot.directories.emplace_unsorted(name, d);
+	}
+
+	for (const auto& f: aDetachedParent.files) {
+		f->setParent(&aRoot);
+		aRoot.files.push_back(f);
+	}
+
+	aDetachedParent.directories.clear();
+	aDetachedParent.files.clear();
+}
+
+bool ListLoader::loadParallel(DirectoryListing* aList, string_view aXml, time_t aListDownloadDate) {
+	dcassert(!aList->getPartialList());
 
-			inListing = false;
+	auto items = splitListing(aXml);
+	if (!items || items->empty()) {
+		return false;
+	}
+
+	// Combine small items
+	struct Unit {
+		XmlRange range;
+		DirectoryListing::DirectoryPtr parent;
+	};
+
+	vector<Unit> units;
+	for (const auto& [start, end]: *items) {
+		if (!units.empty() && units.back().range.second - units.back().range.first < PARALLEL_UNIT_SIZE) {
+			units.back().range.second = end;
+		} else {
+			units.push_back({ { start, end }, nullptr });
 		}
 	}
+
+	// Parse
+	atomic<bool> failed = false;
+	parallel_for_each(units.begin(), units.end(), [&](Unit& aUnit) {
+		if (failed) {
+			return;
+		}
+
+		aUnit.parent = DirectoryListing::Directory::create(nullptr, ADC_ROOT_STR, DirectoryListing::Directory::TYPE_NORMAL, aListDownloadDate);
+
+		try {
+			ListLoader loader(aList, aUnit.parent.get(), aListDownloadDate);
+			SimpleXMLReader(&loader).parseDocument(aXml.substr(aUnit.range.first, aUnit.range.second - aUnit.range.first));
+			if (loader.cur != aUnit.parent.get()) {
+				failed = true;
+			}
+		} catch (const SimpleXMLException& e) {
+			dcdebug("ListLoader::loadParallel: failed to parse a top-level item (%s)\n", e.getError().c_str());
+			failed = true;
+		}
+	});
+
+	if (failed) {
+		return false;
+	}
+
+	// Attach the items in document order
+	auto root = aList->getRoot();
+	for (const auto& u: units) {
+		attachItems(*u.parent, *root);
+	}
+
+	sortDirectories(*root);
+
+	ListLoader(aList, root.get(), aListDownloadDate).completeListing();
+	return true;
 }
 
 void ListLoader::runHooksRecursive(const DirectoryListing::DirectoryPtr& aDir) noexcept {
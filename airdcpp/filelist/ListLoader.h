@@ -31,25 +31,50 @@ public:
 	ListLoader(DirectoryListing* aList, const string& aBase,
 		bool aUpdating, time_t aListDownloadDate);
 
-	~ListLoader() override = default;
+	~ListLoader() override;
 
-	void startTag(const string& name, StringPairList& attribs, bool simple) override;
+	// Loads a complete (non-partial) list from memory, top-level items are parsed concurrently
+	// Returns false if the list couldn't be split (the list should be loaded normally in that case)
+	// Throws AbortException
+	static bool loadParallel(DirectoryListing* aList, string_view aXml, time_t aListDownloadDate);
+
+	// Minimum amount of XML data to parse in a single task
+	static const size_t PARALLEL_UNIT_SIZE = 1024 * 1024;
+
+	void startTagView(const string& name, const SimpleXMLReader::AttribViewList& attribs, bool simple) override;
 	void endTag(const string& name) override;
 
-	void loadFile(StringPairList& attribs, bool simple);
-	void loadDirectory(StringPairList& attribs, bool simple);
-	void loadListing(StringPairList& attribs, bool simple);
+	void loadFile(const SimpleXMLReader::AttribViewList& attribs, bool simple);
+	void loadDirectory(const SimpleXMLReader::AttribViewList& attribs, bool simple);
+	void loadListing(const SimpleXMLReader::AttribViewList& attribs, bool simple);
 
 	int getLoadedDirs() const noexcept { return dirsLoaded; }
 private:
+	// Loader for top-level items that are added in a detached parent directory
+	ListLoader(DirectoryListing* aList, DirectoryListing::Directory* aDetachedParent, time_t aListDownloadDate);
+
+	// Moves the loaded items from a detached parent directory to the root directory
+	static void attachItems(DirectoryListing::Directory& aDetachedParent, DirectoryListing::Directory& aRoot);
+
+	// Sorts the child directories that were added without keeping the order
+	// Throws AbortException if there are duplicate names
+	static void sortDirectories(DirectoryListing::Directory& aDir);
+
+	// Called after the whole listing has been loaded
+	void completeListing() noexcept;
+
 	void runHooksRecursive(const DirectoryListing::DirectoryPtr& aDir) noexcept;
 
 	static DirectoryListing::Directory::DirType parseDirectoryType(bool aIncomplete, const DirectoryContentInfo& aContentInfo) noexcept;
 	static void validateName(const string_view& aName);
+	static time_t parseDate(string_view aDate) noexcept;
 
 	DirectoryListing* list;
 	DirectoryListing::Directory* cur;
 
+	// Names of the loaded files (a new pool is used for each load so that reloading won't keep the old names)
+	const SharedStringPoolPtr names = new SharedStringPool();
+
 	bool inListing = false;
 	int dirsLoaded = 0;
 
@@ -66,6 +66,14 @@ void HashManager::onFileFailed(const string& aPath, const string& aErrorId, cons
 	fire(HashManagerListener::FileFailed(), aPath, aErrorId, aMessage, aHasherId);
 }
 
+void HashManager::commitHashedFiles(int aHasherId) noexcept {
+	try {
+		store->commitPending();
+	} catch (const Exception& e) {
+		logHasher(STRING_F(HASHING_FAILED_X, e.getError()), aHasherId, LogMessage::SEV_ERROR, true);
+	}
+}
+
 void HashManager::onDirectoryHashed(const string& aPath, const HasherStats& aStats, int aHasherId) noexcept {
 	fire(HashManagerListener::DirectoryHashed(), aPath, aStats, aHasherId);
 }
@@ -79,6 +87,10 @@ void HashManager::removeHasher(int aHasherId) noexcept {
 	std::erase_if(hashers, [aHasherId](const Hasher* aHasher) { return aHasher->hasherID == aHasherId; });
 }
 
+void HashManager::onFileDequeued(const string& aPathLower, int) noexcept {
+	queuedPaths.erase(aPathLower);
+}
+
 void HashManager::logHasher(const string& aMessage, int aHasherID, LogMessage::Severity aSeverity, bool aLock) const noexcept {
 	ConditionalRLock l(Hasher::hcs, aLock);
 	log((hashers.size() > 1 ? "[" + STRING_F(HASHER_X, aHasherID) + "] " + ": " : Util::emptyString) + aMessage, aSeverity);
@@ -135,6 +147,39 @@ void HashManager::getFileInfo(const string& aFileLower, const string& aFileName,
 		throw HashException();
 	}
 }
+
+void HashManager::checkTTHs(HashedFileQueryList& aFiles) noexcept {
+	store->checkTTHs(aFiles);
+
+	vector<const HashedFileQuery*> toHash;
+	for (const auto& query: aFiles) {
+		dcassert(Text::isLower(query.pathLower));
+		if (!query.found) {
+			toHash.push_back(&query);
+		}
+	}
+
+	hashFiles(toHash);
+}
+
+void HashManager::getFileInfos(HashedFileQueryList& aFiles) noexcept {
+	store->getFileInfos(aFiles);
+
+	vector<const HashedFileQuery*> toHash;
+	for (auto& query: aFiles) {
+		dcassert(Text::isLower(query.pathLower));
+		if (!query.found) {
+			auto size = File::getSize(query.path);
+			if (size >= 0) {
+				query.file.setSize(size);
+				toHash.push_back(&query);
+			}
+		}
+	}
+
+	hashFiles(toHash);
+}
+
 void HashManager::renameFileThrow(const string& aOldPath, const string& aNewPath) {
 	return store->renameFileThrow(aOldPath, aNewPath);
 }
@@ -152,9 +197,9 @@ int64_t HashManager::getMinBlockSize() noexcept {
 }
 
 bool HashManager::isPathQueued(const string& aPathLower) const noexcept {
-	auto p = find_if(hashers, [&aPathLower](const Hasher* aHasher) { return aHasher->hasFile(aPathLower); });
-	if (p != hashers.end()) {
-		dcdebug("Hash: ignoring file %s (queued already for hasher %d)\n", aPathLower.c_str(), (*p)->hasherID);
+	auto p = queuedPaths.find(aPathLower);
+	if (p != queuedPaths.end()) {
+		dcdebug("Hash: ignoring file %s (queued already for hasher %d)\n", aPathLower.c_str(), p->second->hasherID);
 		return true;
 	}
 
@@ -214,13 +259,45 @@ bool HashManager::hashFile(const string& aPath, const string& aPathLower, int64_
 		return false;
 	}
 
+	auto deviceId = File::getDeviceId(aPath);
+
+	WLock l(Hasher::hcs);
+	return hashFileUnsafe(aPath, aPathLower, aSize, deviceId);
+}
+
+void HashManager::hashFiles(const vector<const HashedFileQuery*>& aFiles) noexcept {
+	if (isShutdown || aFiles.empty()) {
+		return;
+	}
+
+	// Resolve the devices before locking
+	vector<int64_t> deviceIds;
+	deviceIds.reserve(aFiles.size());
+
+	string lastDir;
+	int64_t lastDeviceId = -1;
+	for (const auto& query: aFiles) {
+		auto dir = PathUtil::getFilePath(query->path);
+		if (dir != lastDir) {
+			lastDeviceId = File::getDeviceId(dir);
+			lastDir = std::move(dir);
+		}
+
+		deviceIds.push_back(lastDeviceId);
+	}
+
 	WLock l(Hasher::hcs);
+	for (size_t i = 0; i < aFiles.size(); ++i) {
+		const auto& query = *aFiles[i];
+		hashFileUnsafe(query.path, query.pathLower, query.file.getSize(), deviceIds[i]);
+	}
+}
+
+bool HashManager::hashFileUnsafe(const string& aPath, const string& aPathLower, int64_t aSize, int64_t deviceId) noexcept {
 	if (isPathQueued(aPathLower)) {
 		return false;
 	}
 
-	auto deviceId = File::getDeviceId(aPath);
-
 	Hasher* h = nullptr;
 	if (hashers.size() == 1 && !hashers.front()->hasDevices()) {
 		// Always use the main hasher if it's idle
@@ -236,7 +313,12 @@ bool HashManager::hashFile(const string& aPath, const string& aPathLower, int64_
 
 	// Queue the file for hashing
 	dcdebug("Hash: choosing hasher #%d for file %s\n", h->hasherID, aPath.c_str());
-	return h->hashFile(aPath, aPathLower, aSize, deviceId);
+	if (!h->hashFile(aPath, aPathLower, aSize, deviceId)) {
+		return false;
+	}
+
+	queuedPaths.emplace(aPathLower, h);
+	return true;
 }
 
 void HashManager::getFileTTH(const string& aFile, int64_t aSize, bool aAddStore, TTHValue& tth_, int64_t& sizeLeft_, const bool& aCancel, std::function<void(int64_t, const string&)> updateF/*nullptr*/) {
@@ -307,9 +389,19 @@ bool HashManager::addFile(const string& aPath, const HashedFile& fi_) {
 	return true;
 }
 void HashManager::stopHashing(const string& aBaseDir) noexcept {
+	auto baseDirLower = Text::toLower(aBaseDir);
+
 	WLock l(Hasher::hcs);
-	for (auto h: hashers)
-		h->stopHashing(aBaseDir);
+
+	// All subpaths share the same prefix
+	for (auto i = queuedPaths.lower_bound(baseDirLower); i != queuedPaths.end() && i->first.starts_with(baseDirLower);) {
+		auto cur = i++;
+		if (PathUtil::isParentOrExactLower(baseDirLower, cur->first, PATH_SEPARATOR)) {
+			// Removes the entry from the index
+			auto pathLower = cur->first;
+			cur->second->removeFile(pathLower);
+		}
+	}
 }
 
 void HashManager::setPriority(Thread::Priority p) noexcept {
@@ -360,7 +452,9 @@ int HashManager::Optimizer::run() {
 	auto hm = getInstance();
 
 	hm->fire(HashManagerListener::MaintananceStarted());
-	hm->store->optimize(verify);
+	hm->store->optimize(verify, [hm](float aProgress) {
+		hm->fire(HashManagerListener::MaintananceProgress(), aProgress);
+	});
 	hm->fire(HashManagerListener::MaintananceFinished());
 
 	running = false;
@@ -38,6 +38,8 @@ class Hasher;
 class HashStore;
 class HasherStats;
 class HashedFile;
+struct HashedFileQuery;
+using HashedFileQueryList = std::vector<HashedFileQuery>;
 
 class HashManager : public Singleton<HashManager>, public Speaker<HashManagerListener>, public HasherManager {
 
@@ -58,6 +60,11 @@ public:
 	// Throws HashException
 	void getFileInfo(const string& aFileLower, const string& aFileName, HashedFile& aFileInfo);
 
+	// Batch versions of checkTTH and getFileInfo (the database is queried with a single lookup)
+	// Files that weren't found will be queued for hashing
+	void checkTTHs(HashedFileQueryList& aFiles) noexcept;
+	void getFileInfos(HashedFileQueryList& aFiles) noexcept;
+
 	bool getTree(const TTHValue& root, TigerTree& tt) noexcept;
 
 	/** Return block size of the tree associated with root, or 0 if no such tree is in the store */
@@ -141,7 +148,9 @@ private:
 	void onDirectoryHashed(const string& aPath, const HasherStats&, int aHasherId) noexcept override;
 	void onHasherFinished(int aDirectoriesHashed, const HasherStats&, int aHasherId) noexcept override;
 	void removeHasher(int aHasherId) noexcept override;
+	void onFileDequeued(const string& aPathLower, int aHasherId) noexcept override;
 	void logHasher(const string& aMessage, int aHasherID, LogMessage::Severity aSeverity, bool aLock) const noexcept override;
+	void commitHashedFiles(int aHasherId) noexcept override;
 
 	static void log(const string& aMsg, LogMessage::Severity aSeverity) noexcept;
 
@@ -150,11 +159,21 @@ private:
 	bool isPathQueued(const string& aPathLower) const noexcept;
 
 	bool hashFile(const string& filePath, const string& pathLower, int64_t size);
+
+	// Queues the files with a single lock (the device IDs are resolved once per directory)
+	void hashFiles(const vector<const HashedFileQuery*>& aFiles) noexcept;
+
+	// Must be called with Hasher::hcs held
+	bool hashFileUnsafe(const string& aPath, const string& aPathLower, int64_t aSize, int64_t aDeviceId) noexcept;
 	bool isShutdown = false;
 
 	using HasherList = vector<Hasher *>;
 	HasherList hashers;
 
+	// Queued files of all hashers by lowercase path (protected by Hasher::hcs)
+	// The ordering allows removing directories without going through the whole queue
+	map<string, Hasher*> queuedPaths;
+
 	unique_ptr<HashStore> store;
 
 	/** Single node tree where node = root, no storage in HashData.dat */
@@ -36,11 +36,13 @@ public:
 	typedef X<3> MaintananceStarted;
 	typedef X<4> DirectoryHashed;
 	typedef X<5> HasherFinished;
+	typedef X<6> MaintananceProgress;
 
 	virtual void on(FileHashed, const string& /* aPath */, HashedFile& /* aFileInfo */, int /*aHasherId*/) noexcept { }
 	virtual void on(FileFailed, const string& /* aPath */, const string& /*aErrorId*/, const string& /*aMessage*/, int /*aHasherId*/) noexcept { }
 	virtual void on(MaintananceStarted) noexcept { }
 	virtual void on(MaintananceFinished) noexcept { }
+	virtual void on(MaintananceProgress, float /*aProgress*/) noexcept { }
 	virtual void on(DirectoryHashed, const string& /*aPath*/, const HasherStats&, int /*aHasherId*/) noexcept { }
 	virtual void on(HasherFinished, int /*aDirectoriesHashed*/, const HasherStats&, int /*aHasherId*/) noexcept { }
 };
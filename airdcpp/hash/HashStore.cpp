@@ -28,9 +28,14 @@
 #include <airdcpp/queue/QueueManager.h>
 #include <airdcpp/share/ShareManager.h>
 #include <airdcpp/core/localization/ResourceManager.h>
+#include <airdcpp/core/timer/TimerManager.h>
 #include <airdcpp/util/Util.h>
 #include <airdcpp/core/version.h>
 
+#include <airdcpp/core/thread/concurrency.h>
+
+#include <thread>
+
 
 #define FILEINDEX_VERSION 1
 #define HASHDATA_VERSION 1
@@ -81,6 +86,14 @@ void HashStore::openDb(StartupLoader& aLoader) {
 }
 
 void HashStore::closeDb() noexcept {
+	if (hashDb && fileDb) {
+		try {
+			commitPending();
+		} catch (const HashException& e) {
+			log(e.getError(), LogMessage::SEV_ERROR);
+		}
+	}
+
 	hashDb.reset(nullptr);
 	fileDb.reset(nullptr);
 }
@@ -90,11 +103,126 @@ void HashStore::log(const string& aMsg, LogMessage::Severity aSeverity) noexcept
 }
 
 void HashStore::addHashedFile(const string& aFileLower, const TigerTree& tt, const HashedFile& fi_) {
-	addTree(tt);
-	addFile(aFileLower, fi_);
+	bool commit = false;
+
+	{
+		WLock l(pendingCS);
+		if (pendingFiles.empty()) {
+			firstPendingTick = GET_TICK();
+		}
+
+		pendingTrees.insert_or_assign(tt.getRoot(), tt);
+		pendingFiles.insert_or_assign(aFileLower, fi_);
+
+		commit = pendingFiles.size() >= MAX_PENDING_FILES || firstPendingTick + MAX_PENDING_MS <= GET_TICK();
+	}
+
+	if (commit) {
+		commitPending();
+	}
+}
+
+void HashStore::commitPending() {
+	Lock commitLock(commitCS);
+
+	{
+		// Writing may take a while, keep the lookups and new hashed files going meanwhile
+		WLock l(pendingCS);
+		if (pendingFiles.empty() && pendingTrees.empty()) {
+			return;
+		}
+
+		dcassert(committingTrees.empty() && committingFiles.empty());
+		committingTrees.swap(pendingTrees);
+		committingFiles.swap(pendingFiles);
+	}
+
+	auto onCommitted = [this](bool aSuccess) {
+		WLock l(pendingCS);
+		if (!aSuccess) {
+			// Keep them pending (newer entries take precedence)
+			if (pendingFiles.empty() && !committingFiles.empty()) {
+				firstPendingTick = GET_TICK();
+			}
+
+			pendingTrees.merge(committingTrees);
+			pendingFiles.merge(committingFiles);
+		}
+
+		committingTrees.clear();
+		committingFiles.clear();
+	};
+
+	auto treeBatch = hashDb->createWriteBatch();
+	for (const auto& [root, tree]: committingTrees) {
+		auto sz = getTreeSize(tree);
+		void* buf = malloc(sz);
+		saveTree(buf, tree);
+		treeBatch->put((void*)root.data, sizeof(TTHValue), buf, sz);
+		free(buf);
+	}
+
+	auto fileBatch = fileDb->createWriteBatch();
+	for (const auto& [path, fi]: committingFiles) {
+		auto sz = getFileInfoSize(fi);
+		void* buf = malloc(sz);
+		saveFileInfo(buf, fi);
+		fileBatch->put((void*)path.c_str(), path.length(), buf, sz);
+		free(buf);
+	}
+
+	// Write the trees first so that there won't be file entries without trees
+	try {
+		hashDb->write(*treeBatch);
+	} catch (const DbException& e) {
+		onCommitted(false);
+		throw HashException(STRING_F(WRITE_FAILED_X, hashDb->getNameLower() % e.getError()));
+	}
+
+	try {
+		fileDb->write(*fileBatch);
+	} catch (const DbException& e) {
+		onCommitted(false);
+		throw HashException(STRING_F(WRITE_FAILED_X, fileDb->getNameLower() % e.getError()));
+	}
+
+	onCommitted(true);
+}
+
+const TigerTree* HashStore::findPendingTree(const TTHValue& aRoot) const noexcept {
+	if (auto i = pendingTrees.find(aRoot); i != pendingTrees.end()) {
+		return &i->second;
+	}
+
+	if (auto i = committingTrees.find(aRoot); i != committingTrees.end()) {
+		return &i->second;
+	}
+
+	return nullptr;
+}
+
+const HashedFile* HashStore::findPendingFile(const string& aFilePathLower) const noexcept {
+	if (auto i = pendingFiles.find(aFilePathLower); i != pendingFiles.end()) {
+		return &i->second;
+	}
+
+	if (auto i = committingFiles.find(aFilePathLower); i != committingFiles.end()) {
+		return &i->second;
+	}
+
+	return nullptr;
+}
+
+void HashStore::removePendingFile(const string& aFilePathLower) noexcept {
+	WLock l(pendingCS);
+	pendingFiles.erase(aFilePathLower);
 }
 
 void HashStore::addFile(const string& aFileLower, const HashedFile& fi_) {
+	// Don't let a batch that is being written overwrite the entry
+	Lock l(commitCS);
+	removePendingFile(aFileLower);
+
 	auto sz = getFileInfoSize(fi_);
 	void* buf = malloc(sz);
 	saveFileInfo(buf, fi_);
@@ -109,6 +237,9 @@ void HashStore::addFile(const string& aFileLower, const HashedFile& fi_) {
 }
 
 void HashStore::removeFile(const string& aFilePathLower) {
+	Lock l(commitCS);
+	removePendingFile(aFilePathLower);
+
 	try {
 		fileDb->remove((void*)aFilePathLower.c_str(), aFilePathLower.length());
 	} catch (const DbException& e) {
@@ -146,16 +277,16 @@ void HashStore::renameFileThrow(const string& aOldPath, const string& aNewPath)
 	addFile(newPathLower, hashedFile);
 }
 
-void HashStore::addTree(const TigerTree& tt) {
+size_t HashStore::getTreeSize(const TigerTree& tt) {
 	size_t treelen = tt.getLeaves().size() == 1 ? 0 : tt.getLeaves().size() * TTHValue::BYTES;
-	auto sz = sizeof(uint8_t) + sizeof(int64_t) + sizeof(int64_t) + treelen;
-
-	//allocate the memory
-	void* buf = malloc(sz);
+	return sizeof(uint8_t) + sizeof(int64_t) + sizeof(int64_t) + treelen;
+}
 
+void HashStore::saveTree(void* dest, const TigerTree& tt) {
+	size_t treelen = tt.getLeaves().size() == 1 ? 0 : tt.getLeaves().size() * TTHValue::BYTES;
 
 	//set the data
-	char* p = (char*)buf;
+	char* p = (char*)dest;
 
 	uint8_t version = HASHDATA_VERSION;
 	memcpy(p, &version, sizeof(uint8_t));
@@ -171,6 +302,14 @@ void HashStore::addTree(const TigerTree& tt) {
 
 	if (treelen > 0)
 		memcpy(p, tt.getLeaves()[0].data, treelen);
+}
+
+void HashStore::addTree(const TigerTree& tt) {
+	auto sz = getTreeSize(tt);
+
+	//allocate the memory
+	void* buf = malloc(sz);
+	saveTree(buf, tt);
 
 	//throw HashException(STRING_F(WRITE_FAILED_X, hashDb->getNameLower() % "TEST"));
 	try {
@@ -184,6 +323,14 @@ void HashStore::addTree(const TigerTree& tt) {
 }
 
 bool HashStore::getTree(const TTHValue& aRoot, TigerTree& tt_) {
+	{
+		RLock l(pendingCS);
+		if (auto tree = findPendingTree(aRoot); tree) {
+			tt_ = *tree;
+			return true;
+		}
+	}
+
 	try {
 		return hashDb->get((void*)aRoot.data, sizeof(TTHValue), 100 * 1024, [&](void* aValue, size_t valueLen) {
 			return loadTree(aValue, valueLen, aRoot, tt_, true);
@@ -196,6 +343,13 @@ bool HashStore::getTree(const TTHValue& aRoot, TigerTree& tt_) {
 }
 
 bool HashStore::hasTree(const TTHValue& aRoot) {
+	{
+		RLock l(pendingCS);
+		if (findPendingTree(aRoot)) {
+			return true;
+		}
+	}
+
 	bool ret = false;
 	try {
 		ret = hashDb->hasKey((void*)aRoot.data, sizeof(TTHValue));
@@ -301,6 +455,13 @@ uint32_t HashStore::getFileInfoSize(const HashedFile& /*aTree*/) {
 }
 
 int64_t HashStore::getRootInfo(const TTHValue& root, InfoType aType) noexcept {
+	{
+		RLock l(pendingCS);
+		if (auto tree = findPendingTree(root); tree) {
+			return aType == TYPE_FILESIZE ? tree->getFileSize() : tree->getBlockSize();
+		}
+	}
+
 	int64_t ret = 0;
 	try {
 		hashDb->get((void*)root.data, sizeof(TTHValue), 100 * 1024, [&](void* aValue, size_t /*valueLen*/) {
@@ -338,7 +499,67 @@ bool HashStore::checkTTH(const string& aFileLower, HashedFile& fi_) noexcept {
 	return false;
 }
 
+void HashStore::checkTTHs(HashedFileQueryList& aFiles) noexcept {
+	vector<HashedFile> diskInfos;
+	diskInfos.reserve(aFiles.size());
+	for (const auto& query: aFiles) {
+		diskInfos.push_back(query.file);
+	}
+
+	getFileInfos(aFiles);
+
+	for (size_t i = 0; i < aFiles.size(); ++i) {
+		auto& query = aFiles[i];
+		const auto& diskInfo = diskInfos[i];
+		if (query.found && (query.file.getTimeStamp() != diskInfo.getTimeStamp() || query.file.getSize() != diskInfo.getSize())) {
+			// Outdated
+			query.found = false;
+			query.file = diskInfo;
+		}
+	}
+}
+
+void HashStore::getFileInfos(HashedFileQueryList& aFiles) noexcept {
+	DbKeyList keys;
+	vector<size_t> keyFiles;
+
+	{
+		RLock l(pendingCS);
+		for (size_t i = 0; i < aFiles.size(); ++i) {
+			auto& query = aFiles[i];
+			if (auto file = findPendingFile(query.pathLower); file) {
+				query.file = *file;
+				query.found = true;
+			} else {
+				keys.emplace_back((void*)query.pathLower.c_str(), query.pathLower.length());
+				keyFiles.push_back(i);
+			}
+		}
+	}
+
+	if (keys.empty()) {
+		return;
+	}
+
+	try {
+		fileDb->multiGet(keys, [&](size_t aKeyIndex, void* aValue, size_t aValueLen) {
+			auto& query = aFiles[keyFiles[aKeyIndex]];
+			query.found = loadFileInfo(aValue, aValueLen, query.file);
+		});
+	} catch (const DbException& e) {
+		log(STRING_F(READ_FAILED_X, fileDb->getNameLower() % e.getError()), LogMessage::SEV_ERROR);
+	}
+}
+
 bool HashStore::getFileInfo(const string& aFileLower, HashedFile& fi_) noexcept {
+	{
+		RLock l(pendingCS);
+		if (auto file = findPendingFile(aFileLower); file) {
+			fi_ = *file;
+			return true;
+		}
+	}
+
 	try {
 		return fileDb->get((void*)aFileLower.c_str(), aFileLower.length(), sizeof(HashedFile), [&](void* aValue, size_t valueLen) {
 			return loadFileInfo(aValue, valueLen, fi_);
@@ -350,19 +571,113 @@ bool HashStore::getFileInfo(const string& aFileLower, HashedFile& fi_) noexcept
 	return false;
 }
 
-void HashStore::optimize(bool doVerify) noexcept {
+namespace {
+
+struct DbScanStats {
+	atomic<int64_t> scanned = 0;
+	atomic<int64_t> removed = 0;
+	uint64_t duration = 0;
+};
+
+using RangeRemoveF = std::function<bool(size_t aRangeIndex, void* aKey, size_t keyLen, void* aValue, size_t valueLen)>;
+
+// Number of removed entries to collect before writing them to the database
+const size_t MAINTENANCE_REMOVE_BATCH = 10000;
+
+// Scan the given key ranges of a database in parallel and remove entries for which the function returns true
+// The function must be thread-safe (the range index can be used for range-specific data)
+// Throws DbException
+void parallelRemoveIf(DbHandler& aDb, DbSnapshot* aSnapshot, const DbKeyRangeList& aRanges, const RangeRemoveF& aRemoveF, DbScanStats& stats_, const ProgressFunction& aProgressF) {
+	auto start = GET_TICK();
+
+	vector<size_t> rangeIndexes(aRanges.size());
+	iota(rangeIndexes.begin(), rangeIndexes.end(), 0);
+
+	atomic<size_t> rangesCompleted = 0;
+	atomic<bool> failed = false;
 
-	int unusedTrees = 0;
-	int failedTrees = 0;
-	int unusedFiles = 0;
-	int validFiles = 0;
-	int validTrees = 0;
+	CriticalSection errorCS;
+	string error;
+
+	parallel_for_each(rangeIndexes.begin(), rangeIndexes.end(), [&](size_t aRangeIndex) {
+		try {
+			auto batch = aDb.createWriteBatch();
+			auto writeBatch = [&] {
+				auto removed = batch->size();
+				aDb.write(*batch);
+				stats_.removed += removed;
+				batch = aDb.createWriteBatch();
+			};
+
+			aDb.forEach(aRanges[aRangeIndex], [&](void* aKey, size_t keyLen, void* aValue, size_t valueLen) {
+				stats_.scanned++;
+				if (aRemoveF(aRangeIndex, aKey, keyLen, aValue, valueLen)) {
+					batch->remove(aKey, keyLen);
+					if (batch->size() >= MAINTENANCE_REMOVE_BATCH) {
+						writeBatch();
+					}
+				}
+
+				return !failed;
+			}, aSnapshot);
+
+			writeBatch();
+		} catch (const DbException& e) {
+			Lock l(errorCS);
+			error = e.getError();
+			failed = true;
+		}
+
+		if (aProgressF) {
+			aProgressF(static_cast<float>(++rangesCompleted) / static_cast<float>(aRanges.size()));
+		}
+	});
+
+	stats_.duration = GET_TICK() - start;
+	if (failed) {
+		throw DbException(error);
+	}
+}
+
+void logScanStats(const DbHandler& aDb, const DbScanStats& aStats) noexcept {
+	auto speed = aStats.duration > 0 ? aStats.scanned * 1000 / static_cast<int64_t>(aStats.duration) : static_cast<int64_t>(aStats.scanned);
+	HashStore::log(STRING_F(HASHDB_MAINTENANCE_PROGRESS, aDb.getNameLower() % aStats.scanned.load() % Util::formatDuration(aStats.duration / 1000, true) % speed % aStats.removed.load()), LogMessage::SEV_VERBOSE);
+}
+
+}
+
+void HashStore::optimize(bool doVerify, const ProgressFunction& aProgressF) noexcept {
+	atomic<int> unusedTrees = 0;
+	atomic<int> failedTrees = 0;
+	atomic<int> unusedFiles = 0;
+	atomic<int> validFiles = 0;
+	atomic<int> validTrees = 0;
 	int missingTrees = 0;
-	int removedFiles = 0;
-	int64_t failedSize = 0;
+	atomic<int> removedFiles = 0;
+	atomic<int64_t> failedSize = 0;
 
 	log(STRING(HASHDB_MAINTENANCE_STARTED), LogMessage::SEV_INFO);
 
+	try {
+		// Include the recently hashed files
+		commitPending();
+	} catch (const HashException& e) {
+		log(e.getError(), LogMessage::SEV_ERROR);
+	}
+
+	// Progress of each step in the total progress
+	auto getStepProgressF = [&aProgressF](float aStart, float aEnd) -> ProgressFunction {
+		if (!aProgressF) {
+			return nullptr;
+		}
+
+		return [=](float aProgress) {
+			aProgressF(aStart + (aEnd - aStart) * aProgress);
+		};
+	};
+
+	const auto maxRanges = static_cast<size_t>(max(std::thread::hardware_concurrency(), 1U)) * MAINTENANCE_RANGES_PER_THREAD;
+
 	{
 		unordered_set<TTHValue> usedRoots;
 
@@ -370,49 +685,62 @@ void HashStore::optimize(bool doVerify) noexcept {
 		unique_ptr<DbSnapshot> fileSnapshot(fileDb->getSnapshot());
 		unique_ptr<DbSnapshot> hashSnapshot(hashDb->getSnapshot());
 
-		HashedFile fi;
-		string path;
+		auto fileRanges = fileDb->getKeyRanges(maxRanges);
+		auto hashRanges = hashDb->getKeyRanges(maxRanges);
 
 		// lookup each item in file index from the share
 		try {
-			fileDb->remove_if([&](void* aKey, size_t key_len, void* aValue, size_t valueLen) {
-				path = string((const char*)aKey, key_len);
+			vector<vector<TTHValue>> rangeRoots(fileRanges.size());
+
+			DbScanStats stats;
+			parallelRemoveIf(*fileDb, fileSnapshot.get(), fileRanges, [&](size_t aRangeIndex, void* aKey, size_t key_len, void* aValue, size_t valueLen) {
+				string path((const char*)aKey, key_len);
 				if (ShareManager::getInstance()->isRealPathShared(path)) {
+					HashedFile fi;
 					if (!loadFileInfo(aValue, valueLen, fi))
 						return true;
 
-					usedRoots.emplace(fi.getRoot());
+					rangeRoots[aRangeIndex].push_back(fi.getRoot());
 					validFiles++;
 					return false;
-				}
-				else {
+				} else {
 					unusedFiles++;
 					return true;
 				}
-				}, fileSnapshot.get());
+			}, stats, getStepProgressF(0, 0.4f));
+
+			logScanStats(*fileDb, stats);
+
+			for (const auto& roots: rangeRoots) {
+				usedRoots.insert(roots.begin(), roots.end());
+			}
 		} catch (const DbException& e) {
 			log(STRING_F(READ_FAILED_X, fileDb->getNameLower() % e.getError()), LogMessage::SEV_ERROR);
 			log(STRING(HASHDB_MAINTENANCE_FAILED), LogMessage::SEV_ERROR);
 			return;
 		}
 
-		//remove trees that aren't shared or queued and optionally check whether each tree can be loaded
-		TigerTree tt;
-		TTHValue curRoot;
+		//remove trees that aren't shared or queued and optionally check whether each tree can be loaded (verification is run in parallel)
 		try {
-			hashDb->remove_if([&](void* aKey, size_t key_len, void* aValue, size_t valueLen) {
-				memcpy(&curRoot, aKey, key_len);
-				auto i = usedRoots.find(curRoot);
-				if (i == usedRoots.end() && !QueueManager::getInstance()->isFileQueued(curRoot)) {
+			vector<vector<TTHValue>> rangeValidRoots(hashRanges.size());
+
+			DbScanStats stats;
+			parallelRemoveIf(*hashDb, hashSnapshot.get(), hashRanges, [&](size_t aRangeIndex, void* aKey, size_t key_len, void* aValue, size_t valueLen) {
+				TTHValue curRoot;
+				memcpy(&curRoot, aKey, min(key_len, sizeof(TTHValue)));
+
+				auto used = usedRoots.contains(curRoot);
+				if (!used && !QueueManager::getInstance()->isFileQueued(curRoot)) {
 					//not needed
 					unusedTrees++;
 					return true;
 				}
 
+				TigerTree tt;
 				if (!doVerify || loadTree(aValue, valueLen, curRoot, tt, false)) {
 					//valid tree
-					if (i != usedRoots.end())
-						usedRoots.erase(i);
+					if (used)
+						rangeValidRoots[aRangeIndex].push_back(curRoot);
 					validTrees++;
 					return false;
 				}
@@ -420,7 +748,15 @@ void HashStore::optimize(bool doVerify) noexcept {
 				//failed to load it
 				failedTrees++;
 				return true;
-			}, hashSnapshot.get());
+			}, stats, getStepProgressF(0.4f, 0.9f));
+
+			logScanStats(*hashDb, stats);
+
+			for (const auto& roots: rangeValidRoots) {
+				for (const auto& root: roots) {
+					usedRoots.erase(root);
+				}
+			}
 		} catch (const DbException& e) {
 			log(STRING_F(READ_FAILED_X, hashDb->getNameLower() % e.getError()), LogMessage::SEV_ERROR);
 			log(STRING(HASHDB_MAINTENANCE_FAILED), LogMessage::SEV_ERROR);
@@ -431,7 +767,9 @@ void HashStore::optimize(bool doVerify) noexcept {
 		missingTrees = static_cast<int>(usedRoots.size()) - failedTrees;
 		if (!usedRoots.empty()) {
 			try {
-				fileDb->remove_if([&](void* /*aKey*/, size_t /*key_len*/, void* aValue, size_t valueLen) {
+				DbScanStats stats;
+				parallelRemoveIf(*fileDb, fileSnapshot.get(), fileRanges, [&](size_t /*aRangeIndex*/, void* /*aKey*/, size_t /*key_len*/, void* aValue, size_t valueLen) {
+					HashedFile fi;
 					loadFileInfo(aValue, valueLen, fi);
 					if (usedRoots.contains(fi.getRoot())) {
 						failedSize += fi.getSize();
@@ -441,7 +779,9 @@ void HashStore::optimize(bool doVerify) noexcept {
 					}
 
 					return false;
-				}, fileSnapshot.get());
+				}, stats, getStepProgressF(0.9f, 1));
+
+				logScanStats(*fileDb, stats);
 			} catch (const DbException& e) {
 				log(STRING_F(READ_FAILED_X, fileDb->getNameLower() % e.getError()), LogMessage::SEV_ERROR);
 				log(STRING(HASHDB_MAINTENANCE_FAILED), LogMessage::SEV_ERROR);
@@ -450,6 +790,10 @@ void HashStore::optimize(bool doVerify) noexcept {
 		}
 	}
 
+	if (aProgressF) {
+		aProgressF(1);
+	}
+
 	SettingsManager::getInstance()->set(SettingsManager::CUR_REMOVED_FILES, SETTING(CUR_REMOVED_FILES) + unusedFiles + missingTrees);
 	if (validFiles == 0 || (static_cast<double>(SETTING(CUR_REMOVED_FILES)) / static_cast<double>(validFiles)) > 0.05) {
 		log(STRING_F(COMPACTING_X, fileDb->getNameLower()), LogMessage::SEV_INFO);
@@ -480,7 +824,7 @@ void HashStore::optimize(bool doVerify) noexcept {
 			msg = STRING_F(REBUILD_FAILED_ENTRIES_OPTIMIZE, missingTrees);
 		}
 
-		msg += ". " + STRING_F(REBUILD_REFRESH_PROMPT, Util::formatBytes(failedSize));
+		msg += ". " + STRING_F(REBUILD_REFRESH_PROMPT, Util::formatBytes(failedSize.load()));
 		log(msg, LogMessage::SEV_ERROR);
 	}
 }
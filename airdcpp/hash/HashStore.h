@@ -23,19 +23,27 @@
 #include <airdcpp/core/header/typedefs.h>
 
 #include <airdcpp/core/io/db/DbHandler.h>
+#include <airdcpp/core/thread/CriticalSection.h>
+#include <airdcpp/hash/HashedFile.h>
 #include <airdcpp/hash/value/MerkleTree.h>
 #include <airdcpp/message/Message.h>
 
 namespace dcpp {
 
-class HashedFile;
-
 class HashStore {
 public:
 	HashStore();
 	~HashStore();
 
+	// Hashed files are committed to the database in batches (pending files are available for lookups)
+	// Throws HashException if the batch was committed and it failed
 	void addHashedFile(const string& aFilePathLower, const TigerTree& tt, const HashedFile& fi_);
+
+	// Write pending hashed files into the database
+	// The files are kept available for lookups during the write and they remain pending if the write fails
+	// Throws HashException
+	void commitPending();
+
 	void addFile(const string& aFilePathLower, const HashedFile& fi_);
 	void removeFile(const string& aFilePathLower);
 
@@ -45,10 +53,15 @@ public:
 
 	void load(StartupLoader& aLoader);
 
-	void optimize(bool doVerify) noexcept;
+	// Scans the databases in parallel key ranges and removes unused and invalid entries
+	void optimize(bool doVerify, const ProgressFunction& aProgressF = nullptr) noexcept;
 
 	bool checkTTH(const string& aFileNameLower, HashedFile& fi_) noexcept;
 
+	// Batch versions of checkTTH and getFileInfo
+	void checkTTHs(HashedFileQueryList& aFiles) noexcept;
+	void getFileInfos(HashedFileQueryList& aFiles) noexcept;
+
 	void addTree(const TigerTree& tt);
 	bool getFileInfo(const string& aFileLower, HashedFile& aFile) noexcept;
 	bool getTree(const TTHValue& root, TigerTree& tth);
@@ -76,11 +89,44 @@ private:
 	std::unique_ptr<DbHandler> fileDb;
 	std::unique_ptr<DbHandler> hashDb;
 
+	// Maximum number of hashed files to keep in memory before committing them
+	static const size_t MAX_PENDING_FILES = 200;
+
+	// Maximum age of the oldest pending hashed file when adding new ones
+	static const uint64_t MAX_PENDING_MS = 5000;
+
+	using PendingTreeMap = unordered_map<TTHValue, TigerTree>;
+	using PendingFileMap = unordered_map<string, HashedFile>;
+
+	mutable SharedMutex pendingCS;
+	PendingTreeMap pendingTrees;
+	PendingFileMap pendingFiles;
+	uint64_t firstPendingTick = 0;
+
+	// Entries that are being written by commitPending (the database isn't locked during the write)
+	PendingTreeMap committingTrees;
+	PendingFileMap committingFiles;
+
+	// Serializes the batch writes with direct file entry modifications
+	CriticalSection commitCS;
+
+	// Must be called with pendingCS held
+	const TigerTree* findPendingTree(const TTHValue& aRoot) const noexcept;
+	const HashedFile* findPendingFile(const string& aFilePathLower) const noexcept;
+
+	void removePendingFile(const string& aFilePathLower) noexcept;
+
+	// Number of key ranges per CPU thread to scan in parallel during maintenance (the data isn't evenly distributed)
+	static const size_t MAINTENANCE_RANGES_PER_THREAD = 4;
+
 	static bool loadTree(const void* src, size_t len, const TTHValue& aRoot, TigerTree& aTree, bool aReportCorruption);
 
 	static bool loadFileInfo(const void* src, size_t len, HashedFile& aFile);
 	static void saveFileInfo(void* dest, const HashedFile& aTree);
 	static uint32_t getFileInfoSize(const HashedFile& aTree);
+
+	static void saveTree(void* dest, const TigerTree& aTree);
+	static size_t getTreeSize(const TigerTree& aTree);
 };
 
 } // namespace dcpp
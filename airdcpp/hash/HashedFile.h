@@ -40,6 +40,20 @@ public:
 
 using RenameList = std::vector<pair<std::string, HashedFile>>;
 
+// Lookup of a file on disk for batched hash database operations
+struct HashedFileQuery {
+	HashedFileQuery(const std::string& aPath, const std::string& aPathLower, const HashedFile& aFile) : path(aPath), pathLower(aPathLower), file(aFile) { }
+
+	const std::string path;
+	const std::string pathLower;
+
+	// Information of the file on disk (replaced with the stored information when found)
+	HashedFile file;
+	bool found = false;
+};
+
+using HashedFileQueryList = std::vector<HashedFileQuery>;
+
 }
 
 #endif // !defined(DCPLUSPLUS_DCPP_HASHEDFILEINFO_H)
\ No newline at end of file
@@ -31,6 +31,7 @@
 #include <airdcpp/settings/SettingsManager.h>
 #include <airdcpp/core/io/SFVReader.h>
 #include <airdcpp/core/timer/TimerManager.h>
+#include <airdcpp/core/timer/Tracer.h>
 #include <airdcpp/core/io/compress/ZUtils.h>
 
 namespace dcpp {
@@ -133,9 +134,9 @@ void Hasher::logFailedFile(const string& aPath, const string& aError) const noex
 
 bool Hasher::hashFile(const string& fileName, const string& filePathLower, int64_t size, devid aDeviceId) noexcept {
 	// always locked
-	auto [wi, added] = w.emplace_sorted(filePathLower, fileName, size, aDeviceId);
+	auto [wi, added] = w.try_emplace(filePathLower, fileName, size, aDeviceId);
 	if (added) {
-		devices[wi->deviceId]++;
+		devices[aDeviceId]++;
 		totalBytesLeft += size;
 		totalBytesAdded += size;
 		totalFilesAdded++;
@@ -146,18 +147,20 @@ bool Hasher::hashFile(const string& fileName, const string& filePathLower, int64
 	return false;
 }
 
-void Hasher::stopHashing(const string& aBaseDir) noexcept {
-	for (auto i = w.begin(); i != w.end();) {
-		if (PathUtil::isParentOrExact(aBaseDir, i->filePath, PATH_SEPARATOR)) {
-			totalBytesLeft -= i->fileSize;
-			removeDevice(i->deviceId);
-			i = w.erase(i);
-		} else {
-			++i;
-		}
+void Hasher::removeFile(const string& aPathLower) noexcept {
+	auto i = w.find(aPathLower);
+	if (i != w.end()) {
+		totalBytesLeft -= i->second.fileSize;
+		removeDevice(i->second.deviceId);
+		eraseWorkItem(i);
 	}
 }
 
+void Hasher::eraseWorkItem(WorkQueue::iterator aItem) noexcept {
+	manager->onFileDequeued(aItem->first, hasherID);
+	w.erase(aItem);
+}
+
 void Hasher::stop() noexcept {
 	clear();
 	stopping = true;
@@ -178,10 +181,6 @@ int64_t Hasher::getTimeLeft() const noexcept {
 	return lastSpeed > 0 ? (totalBytesLeft / lastSpeed) : 0;
 }
 
-bool Hasher::hasFile(const string& aPath) const noexcept {
-	return w.find(aPath) != w.end();
-}
-
 bool Hasher::hasDevice(int64_t aDeviceId) const noexcept {
 	return devices.contains(aDeviceId);
 }
@@ -191,7 +190,10 @@ bool Hasher::hasDevices() const noexcept {
 }
 
 void Hasher::clear() noexcept {
-	w.clear();
+	while (!w.empty()) {
+		eraseWorkItem(w.begin());
+	}
+
 	devices.clear();
 
 	clearStats();
@@ -226,6 +228,9 @@ void Hasher::instantPause() {
 }
 
 optional<HashedFile> Hasher::hashFile(const WorkItem& aItem, HasherStats& stats_, const DirSFVReader& aSFV) noexcept {
+	static auto& hashDuration = Tracer::getHistogram(Tracer::HASHING, "hashFile");
+	Tracer::Span span(Tracer::HASHING, "hashFile", &hashDuration);
+
 	auto start = GET_TICK();
 	auto sizeLeft = aItem.fileSize;
 	try {
@@ -335,8 +340,8 @@ void Hasher::processQueue() noexcept {
 		{
 			WLock l(hcs);
 			if (!w.empty()) {
-				wi = std::move(w.front());
-				w.pop_front();
+				wi = std::move(w.begin()->second);
+				eraseWorkItem(w.begin());
 			} else {
 				break;
 			}
@@ -356,7 +361,10 @@ void Hasher::processQueue() noexcept {
 
 		auto fi = hashFile(wi, dirStats, sfv);
 
+		// The database is written after releasing the lock
+		auto commit = false;
 		auto onDirHashed = [&]() {
+			commit = true;
 			manager->onDirectoryHashed(initialDir, dirStats, hasherID);
 			logHashedDirectory(initialDir, wi.filePath, dirStats);
 
@@ -395,13 +403,18 @@ void Hasher::processQueue() noexcept {
 				}
 
 				clearStats();
+				commit = true;
 				manager->onHasherFinished(totalDirsHashed, totalStats, hasherID);
-			} else if (!PathUtil::isParentOrExactLocal(initialDir, w.front().filePath)) {
+			} else if (!PathUtil::isParentOrExactLocal(initialDir, w.begin()->second.filePath)) {
 				onDirHashed();
 			}
 
 			currentFile.clear();
 		}
+
+		if (commit) {
+			manager->commitHashedFiles(hasherID);
+		}
 	}
 }
 
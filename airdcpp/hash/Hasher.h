@@ -25,7 +25,6 @@
 #include <airdcpp/hash/HasherManager.h>
 #include <airdcpp/util/PathUtil.h>
 #include <airdcpp/core/thread/Semaphore.h>
-#include <airdcpp/core/classes/SortedVector.h>
 #include <airdcpp/core/thread/Thread.h>
 #include <airdcpp/util/Util.h>
 
@@ -51,12 +50,12 @@ namespace dcpp {
 		void clear() noexcept;
 		void stop() noexcept;
 
-		void stopHashing(const string& baseDir) noexcept;
+		// Removes a queued file (the path must be in the queue)
+		void removeFile(const string& aPathLower) noexcept;
 		int run() override;
 		void getStats(string& curFile_, int64_t& bytesLeft_, size_t& filesLeft_, int64_t& speed_, size_t& filesAdded_, int64_t& bytesAdded_) const noexcept;
 		void shutdown();
 
-		bool hasFile(const string& aPath) const noexcept;
 		bool hasDevice(int64_t aDeviceId) const noexcept;
 		bool hasDevices() const noexcept;
 		int64_t getTimeLeft() const noexcept;
@@ -72,8 +71,8 @@ namespace dcpp {
 
 		class WorkItem {
 		public:
-			WorkItem(const string& aFilePathLower, const string& aFilePath, int64_t aSize, devid aDeviceId) noexcept
-				: filePath(aFilePath), fileSize(aSize), deviceId(aDeviceId), filePathLower(aFilePathLower) { 
+			WorkItem(const string& aFilePath, int64_t aSize, devid aDeviceId) noexcept
+				: filePath(aFilePath), fileSize(aSize), deviceId(aDeviceId) { 
 
 				dcassert(aDeviceId >= 0);
 			}
@@ -88,17 +87,16 @@ namespace dcpp {
 			string filePath;
 			int64_t fileSize = 0;
 			devid deviceId = -1;
-			string filePathLower;
-
-			struct NameLower {
-				const string& operator()(const WorkItem& a) const { return a.filePathLower; }
-			};
 		};
 
 		void processQueue() noexcept;
 		optional<HashedFile> hashFile(const WorkItem& aItem, HasherStats& stats_, const DirSFVReader& aSFV) noexcept;
 
-		SortedVector<WorkItem, std::deque, string, PathUtil::PathSortOrderInt, WorkItem::NameLower> w;
+		// Files are hashed in path order so that the directories get finished one by one
+		using WorkQueue = map<string, WorkItem, PathUtil::PathSortOrderBool>;
+		WorkQueue w;
+
+		void eraseWorkItem(WorkQueue::iterator aItem) noexcept;
 
 		Semaphore s;
 		void removeDevice(devid aDevice) noexcept;
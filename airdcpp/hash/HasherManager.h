@@ -33,6 +33,12 @@ namespace dcpp {
 		virtual void onHasherFinished(int aDirectoriesHashed, const HasherStats&, int aHasherId) noexcept = 0;
 		virtual void logHasher(const string& aMessage, int aHasherID, LogMessage::Severity aSeverity, bool aLock) const noexcept = 0;
 		virtual void removeHasher(int aHasherId) noexcept = 0;
+
+		// Write the hashed files into the database (called without Hasher::hcs held as it waits for the disk)
+		virtual void commitHashedFiles(int aHasherId) noexcept = 0;
+
+		// Called when a file is removed from the hasher's queue (with Hasher::hcs held)
+		virtual void onFileDequeued(const string& aPathLower, int aHasherId) noexcept = 0;
 	};
 } // namespace dcpp
 
@@ -43,7 +43,7 @@ uint64_t HashBloom::get_m(size_t n, size_t k) {
 
 void HashBloom::add(const TTHValue& tth) {
 	for(size_t i = 0; i < k; ++i) {
-		bloom[pos(tth, i)] = true;
+		setBit(pos(tth, i), true);
 	}
 }
 
@@ -52,7 +52,8 @@ bool HashBloom::match(const TTHValue& tth) const {
 		return false;
 	}
 	for(size_t i = 0; i < k; ++i) {
-		if(!bloom[pos(tth, i)]) {
+		auto p = pos(tth, i);
+		if(!(bloom[p / 8] & (1 << (p % 8)))) {
 			return false;
 		}
 	}
@@ -60,15 +61,36 @@ bool HashBloom::match(const TTHValue& tth) const {
 }
 
 void HashBloom::push_back(bool v) {
-	bloom.push_back(v);
+	if (m % 8 == 0) {
+		bloom.push_back(0);
+	}
+
+	m++;
+	setBit(m - 1, v);
 }
 
-void HashBloom::reset(size_t k_, size_t m, size_t h_) {
-	bloom.resize(m);
+void HashBloom::reset(size_t k_, size_t m_, size_t h_) {
+	bloom.assign((m_ + 7) / 8, 0);
 	k = k_;
+	m = m_;
 	h = h_;
 }
 
+void HashBloom::setBit(size_t aPos, bool aValue) noexcept {
+	if (aValue) {
+		bloom[aPos / 8] |= static_cast<uint8_t>(1 << (aPos % 8));
+	} else {
+		bloom[aPos / 8] &= static_cast<uint8_t>(~(1 << (aPos % 8)));
+	}
+}
+
+void HashBloom::merge(const HashBloom& aOther) {
+	dcassert(hasSameParams(aOther));
+	for (size_t i = 0; i < bloom.size(); ++i) {
+		bloom[i] |= aOther.bloom[i];
+	}
+}
+
 size_t HashBloom::pos(const TTHValue& tth, size_t n) const {
 	if((n+1)*h > TTHValue::BITS) {
 		return 0;
@@ -86,13 +108,42 @@ size_t HashBloom::pos(const TTHValue& tth, size_t n) const {
 			x |= (1LL << i);
 		}
 	}
-	return x % bloom.size();
+	return x % m;
 }
 
 void HashBloom::copy_to(ByteVector& v) const {
-	v.resize(bloom.size() / 8);
-	for(size_t i = 0; i < bloom.size(); ++i) {
-		v[i/8] |= bloom[i] << (i % 8);
+	v = bloom;
+}
+
+void CountingHashBloom::reset(size_t k_, size_t m_, size_t h_) {
+	HashBloom::reset(k_, m_, h_);
+	counters.assign(m_, 0);
+}
+
+void CountingHashBloom::add(const TTHValue& tth) {
+	for (size_t i = 0; i < getK(); ++i) {
+		auto p = pos(tth, i);
+		if (counters[p] == UINT8_MAX) {
+			continue;
+		}
+
+		if (counters[p]++ == 0) {
+			setBit(p, true);
+		}
+	}
+}
+
+void CountingHashBloom::remove(const TTHValue& tth) {
+	for (size_t i = 0; i < getK(); ++i) {
+		auto p = pos(tth, i);
+		if (counters[p] == UINT8_MAX) {
+			continue;
+		}
+
+		dcassert(counters[p] > 0);
+		if (counters[p] > 0 && --counters[p] == 0) {
+			setBit(p, false);
+		}
 	}
 }
 
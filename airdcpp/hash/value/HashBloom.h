@@ -34,7 +34,7 @@ namespace dcpp {
  */
 class HashBloom {
 public:
-	HashBloom() : k(0), h(0) { }
+	HashBloom() : k(0), m(0), h(0) { }
 
 	/** Return a suitable value for k based on n */
 	static size_t get_k(size_t n, size_t h);
@@ -45,17 +45,41 @@ public:
 	bool match(const TTHValue& tth) const;
 	void reset(size_t k, size_t m, size_t h);
 	void push_back(bool v);
+
+	/** Set all bits that are set in the other bloom (the parameters must be equal) */
+	void merge(const HashBloom& aOther);
+	bool hasSameParams(const HashBloom& aOther) const noexcept { return k == aOther.k && m == aOther.m && h == aOther.h; }
+
+	size_t getK() const noexcept { return k; }
+	size_t getM() const noexcept { return m; }
+	size_t getH() const noexcept { return h; }
 	
 	void copy_to(ByteVector& v) const;
-private:	
-	
+protected:
 	size_t pos(const TTHValue& tth, size_t n) const;
-	
-	std::vector<bool> bloom;
+
+	void setBit(size_t aPos, bool aValue) noexcept;
+private:
+	// Stored in the same format that is sent to the hub
+	ByteVector bloom;
 	size_t k;
+	size_t m;
 	size_t h;
 };
 
+/**
+ * Bloom with a counter for each bit so that the items can also be removed
+ * Counters that have reached the maximum value will stay set permanently (the bit can't be cleared anymore)
+ */
+class CountingHashBloom : public HashBloom {
+public:
+	void add(const TTHValue& tth);
+	void remove(const TTHValue& tth);
+	void reset(size_t k, size_t m, size_t h);
+private:
+	vector<uint8_t> counters;
+};
+
 }
 
 #endif /*HASHBLOOM_H_*/
@@ -0,0 +1,387 @@
+/*
+ * Copyright (C) 2011-2024 AirDC++ Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef DCPLUSPLUS_DCPP_TTH_INDEX_H
+#define DCPLUSPLUS_DCPP_TTH_INDEX_H
+
+#include <airdcpp/core/header/typedefs.h>
+#include <airdcpp/hash/value/MerkleTree.h>
+
+#include <iterator>
+#include <ranges>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
+
+namespace dcpp {
+
+/**
+ * Flat TTH -> value index using open addressing (linear probing)
+ *
+ * Each distinct TTH takes one slot in the table. Additional values with the same TTH are chained
+ * in a separate node array, which avoids long probe sequences when the same file exists in many places.
+ * The keys point to the TTH stored inside the value (similar to the old multimap-based indexes)
+ * so they must stay valid for as long as the value is in the index.
+ *
+ * The index isn't synchronized.
+ */
+template<class ValueT>
+class TTHIndex {
+public:
+	using Entry = pair<TTHValue*, ValueT>;
+private:
+	static constexpr uint32_t NO_NODE = UINT32_MAX;
+	static constexpr size_t MIN_SLOTS = 16;
+
+	struct Node {
+		Entry entry = { nullptr, ValueT() };
+		uint32_t next = NO_NODE;
+
+		bool isFree() const noexcept { return !entry.first; }
+	};
+
+	struct Slot : public Node {
+		size_t hash = 0;
+	};
+public:
+	// Iterates through all entries
+	class const_iterator {
+	public:
+		using iterator_concept = std::forward_iterator_tag;
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = Entry;
+		using difference_type = ptrdiff_t;
+		using pointer = const Entry*;
+		using reference = const Entry&;
+
+		const_iterator() = default;
+
+		reference operator*() const noexcept { return getNode().entry; }
+		pointer operator->() const noexcept { return &getNode().entry; }
+
+		const_iterator& operator++() noexcept {
+			++pos;
+			skipFree();
+			return *this;
+		}
+
+		const_iterator operator++(int) noexcept {
+			auto tmp = *this;
+			++*this;
+			return tmp;
+		}
+
+		bool operator==(const const_iterator& aOther) const noexcept { return pos == aOther.pos; }
+	private:
+		friend class TTHIndex;
+		const_iterator(const TTHIndex* aIndex, size_t aPos) noexcept : index(aIndex), pos(aPos) {
+			skipFree();
+		}
+
+		// Slots are iterated first, followed by the chained nodes
+		const Node& getNode() const noexcept {
+			return pos < index->slots.size() ? static_cast<const Node&>(index->slots[pos]) : index->nodes[pos - index->slots.size()];
+		}
+
+		void skipFree() noexcept {
+			while (pos < index->slots.size() + index->nodes.size() && getNode().isFree()) {
+				++pos;
+			}
+		}
+
+		const TTHIndex* index = nullptr;
+		size_t pos = 0;
+	};
+
+	// Iterates through the values of a single TTH
+	class value_iterator {
+	public:
+		using iterator_concept = std::forward_iterator_tag;
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = ValueT;
+		using difference_type = ptrdiff_t;
+		using pointer = const ValueT*;
+		using reference = const ValueT&;
+
+		value_iterator() = default;
+
+		reference operator*() const noexcept { return node->entry.second; }
+		pointer operator->() const noexcept { return &node->entry.second; }
+
+		value_iterator& operator++() noexcept {
+			node = node->next == NO_NODE ? nullptr : &index->nodes[node->next];
+			return *this;
+		}
+
+		value_iterator operator++(int) noexcept {
+			auto tmp = *this;
+			++*this;
+			return tmp;
+		}
+
+		bool operator==(const value_iterator& aOther) const noexcept { return node == aOther.node; }
+	private:
+		friend class TTHIndex;
+		value_iterator(const TTHIndex* aIndex, const Node* aNode) noexcept : index(aIndex), node(aNode) {}
+
+		const TTHIndex* index = nullptr;
+		const Node* node = nullptr;
+	};
+
+	using ValueRange = std::ranges::subrange<value_iterator>;
+
+	const_iterator begin() const noexcept { return const_iterator(this, 0); }
+	const_iterator end() const noexcept { return const_iterator(this, slots.size() + nodes.size()); }
+
+	// Number of values
+	size_t size() const noexcept { return valueCount; }
+	bool empty() const noexcept { return valueCount == 0; }
+
+	// Number of distinct TTHs
+	size_t keyCount() const noexcept { return usedSlots; }
+
+	void emplace(TTHValue* aTTH, const ValueT& aValue) noexcept {
+		reserve(usedSlots + 1);
+
+		const auto hash = getHash(*aTTH);
+		const auto mask = slots.size() - 1;
+		for (auto i = hash & mask; ; i = (i + 1) & mask) {
+			auto& slot = slots[i];
+			if (slot.isFree()) {
+				slot.entry = Entry(aTTH, aValue);
+				slot.next = NO_NODE;
+				slot.hash = hash;
+				usedSlots++;
+				break;
+			}
+
+			if (slot.hash == hash && *slot.entry.first == *aTTH) {
+				// Chain after the first value
+				auto n = allocateNode();
+				nodes[n].entry = Entry(aTTH, aValue);
+				nodes[n].next = slots[i].next;
+				slots[i].next = n;
+				break;
+			}
+		}
+
+		valueCount++;
+	}
+
+	// Returns false if the value wasn't found
+	bool erase(const TTHValue& aTTH, const ValueT& aValue) noexcept {
+		auto i = findSlot(aTTH, getHash(aTTH));
+		if (i == string::npos) {
+			return false;
+		}
+
+		auto& slot = slots[i];
+		if (slot.entry.second == aValue) {
+			if (slot.next != NO_NODE) {
+				// Move the next value to the slot
+				auto n = slot.next;
+				slot.entry = std::move(nodes[n].entry);
+				slot.next = nodes[n].next;
+				freeNode(n);
+			} else {
+				eraseSlot(i);
+			}
+
+			valueCount--;
+			return true;
+		}
+
+		for (auto prev = &slot.next; *prev != NO_NODE; prev = &nodes[*prev].next) {
+			auto n = *prev;
+			if (nodes[n].entry.second == aValue) {
+				*prev = nodes[n].next;
+				freeNode(n);
+				valueCount--;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	ValueRange findAll(const TTHValue& aTTH) const noexcept {
+		auto i = findSlot(aTTH, getHash(aTTH));
+		if (i == string::npos) {
+			return ValueRange(value_iterator(), value_iterator());
+		}
+
+		return ValueRange(value_iterator(this, &slots[i]), value_iterator());
+	}
+
+	// Returns the first value or nullptr if the TTH wasn't found
+	const ValueT* find(const TTHValue& aTTH) const noexcept {
+		auto i = findSlot(aTTH, getHash(aTTH));
+		return i == string::npos ? nullptr : &slots[i].entry.second;
+	}
+
+	bool contains(const TTHValue& aTTH) const noexcept {
+		return findSlot(aTTH, getHash(aTTH)) != string::npos;
+	}
+
+	// Look up multiple TTHs
+	// The slots of the upcoming TTHs are prefetched while the earlier ones are being matched
+	// aGetTTH(index) must return the TTH for the item, aHandler(index, value) is called for each match
+	template<class GetTTHF, class HandlerF>
+	void findBatch(size_t aCount, const GetTTHF& aGetTTH, const HandlerF& aHandler) const noexcept {
+		if (slots.empty()) {
+			return;
+		}
+
+		const auto mask = slots.size() - 1;
+		const auto prefetchCount = min(aCount, PREFETCH_DISTANCE);
+		for (size_t i = 0; i < prefetchCount; ++i) {
+			prefetch(&slots[getHash(aGetTTH(i)) & mask]);
+		}
+
+		for (size_t i = 0; i < aCount; ++i) {
+			if (i + PREFETCH_DISTANCE < aCount) {
+				prefetch(&slots[getHash(aGetTTH(i + PREFETCH_DISTANCE)) & mask]);
+			}
+
+			for (const auto& value: findAll(aGetTTH(i))) {
+				aHandler(i, value);
+			}
+		}
+	}
+
+	// Make room for the wanted number of distinct TTHs
+	void reserve(size_t aKeys) noexcept {
+		if (aKeys * 4 <= slots.size() * 3) {
+			return;
+		}
+
+		auto newSize = max(slots.size() * 2, MIN_SLOTS);
+		while (aKeys * 4 > newSize * 3) {
+			newSize *= 2;
+		}
+
+		rehash(newSize);
+	}
+
+	// Releases the memory as well
+	void clear() noexcept {
+		vector<Slot>().swap(slots);
+		vector<Node>().swap(nodes);
+		vector<uint32_t>().swap(freeNodes);
+		valueCount = 0;
+		usedSlots = 0;
+	}
+private:
+	static constexpr size_t PREFETCH_DISTANCE = 8;
+
+	static size_t getHash(const TTHValue& aTTH) noexcept {
+		return std::hash<TTHValue>()(aTTH);
+	}
+
+	static void prefetch(const void* aAddress) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+		__builtin_prefetch(aAddress);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+		_mm_prefetch(static_cast<const char*>(aAddress), _MM_HINT_T0);
+#endif
+	}
+
+	size_t findSlot(const TTHValue& aTTH, size_t aHash) const noexcept {
+		if (slots.empty()) {
+			return string::npos;
+		}
+
+		const auto mask = slots.size() - 1;
+		for (auto i = aHash & mask; !slots[i].isFree(); i = (i + 1) & mask) {
+			if (slots[i].hash == aHash && *slots[i].entry.first == aTTH) {
+				return i;
+			}
+		}
+
+		return string::npos;
+	}
+
+	// Backward shift deletion (no tombstones are needed with linear probing)
+	void eraseSlot(size_t aPos) noexcept {
+		const auto mask = slots.size() - 1;
+
+		auto i = aPos;
+		slots[i] = Slot();
+		for (auto j = (i + 1) & mask; !slots[j].isFree(); j = (j + 1) & mask) {
+			// Move the slot unless its home position is between the free slot and the current position
+			auto home = slots[j].hash & mask;
+			auto canMove = j > i ? (home <= i || home > j) : (home <= i && home > j);
+			if (canMove) {
+				slots[i] = std::move(slots[j]);
+				slots[j] = Slot();
+				i = j;
+			}
+		}
+
+		usedSlots--;
+	}
+
+	void rehash(size_t aSize) noexcept {
+		auto oldSlots = std::move(slots);
+		slots = vector<Slot>(aSize);
+
+		const auto mask = aSize - 1;
+		for (auto& oldSlot : oldSlots) {
+			if (oldSlot.isFree()) {
+				continue;
+			}
+
+			auto i = oldSlot.hash & mask;
+			while (!slots[i].isFree()) {
+				i = (i + 1) & mask;
+			}
+
+			slots[i] = std::move(oldSlot);
+		}
+	}
+
+	uint32_t allocateNode() noexcept {
+		if (!freeNodes.empty()) {
+			auto n = freeNodes.back();
+			freeNodes.pop_back();
+			return n;
+		}
+
+		nodes.emplace_back();
+		return static_cast<uint32_t>(nodes.size() - 1);
+	}
+
+	void freeNode(uint32_t aNode) noexcept {
+		nodes[aNode] = Node();
+		freeNodes.push_back(aNode);
+	}
+
+	vector<Slot> slots;
+
+	// Additional values for TTHs that exist in the slots
+	vector<Node> nodes;
+	vector<uint32_t> freeNodes;
+
+	size_t valueCount = 0;
+	size_t usedSlots = 0;
+};
+
+} // namespace dcpp
+
+#endif // !defined(DCPLUSPLUS_DCPP_TTH_INDEX_H)
@@ -272,6 +272,8 @@ void ClientManager::putOnline(const OnlineUserPtr& ou) noexcept {
 		WLock l(cs);
 		onlineUsers.emplace(const_cast<CID*>(&ou->getUser()->getCID()), ou);
 	}
+
+	onlineUserIndex.addUser(ou);
 	
 	if (!ou->getUser()->isOnline()) {
 		// User came online
@@ -316,6 +318,8 @@ void ClientManager::putOffline(const OnlineUserPtr& ou, bool aDisconnectTransfer
 		}
 	}
 
+	onlineUserIndex.removeUser(ou);
+
 	if (diff == 1) { //last user
 		UserPtr& u = ou->getUser();
 		u->unsetFlag(User::ONLINE);
@@ -562,28 +566,28 @@ OnlineUserList ClientManager::searchNicks(const string& aPattern, size_t aMaxRes
 		return aIgnorePrefix ? stripNick(aUser->getIdentity().getNick()) : aUser->getIdentity().getNick();
 	});
 
-	{
-		RLock l(cs);
-		for (const auto& c: clients | views::values) {
-			if (find(aHubUrls.begin(), aHubUrls.end(), c->getHubUrl()) == aHubUrls.end()) {
-				continue;
-			}
+	// Stripping the prefix doesn't add new trigrams so the candidates can be picked based on the full nick
+	auto patterns = search.getQuery().include.toStringList();
 
-			OnlineUserList hubUsers;
-			c->getUserList(hubUsers, false);
-			for (const auto& ou : hubUsers) {
-				if (ou->getUser() == me) {
-					continue;
-				}
+	for (const auto& ou: onlineUserIndex.getNickCandidates(patterns)) {
+		if (ou->getUser() == me || ou->isHidden()) {
+			continue;
+		}
 
-				search.match(ou);
-			}
+		if (find(aHubUrls.begin(), aHubUrls.end(), ou->getHubUrl()) == aHubUrls.end()) {
+			continue;
 		}
+
+		search.match(ou);
 	}
 
 	return search.getResults(aMaxResults);
 }
 
+OnlineUserList ClientManager::findOnlineUsersByIp(const string& aIp) const noexcept {
+	return onlineUserIndex.findByIp(aIp);
+}
+
 
 
 // CONNECT
@@ -1221,11 +1225,13 @@ void ClientManager::on(ClientListener::Connected, const Client* aClient) noexcep
 }
 
 void ClientManager::on(ClientListener::UserUpdated, const Client*, const OnlineUserPtr& user) noexcept {
+	onlineUserIndex.updateUser(user);
 	fire(ClientManagerListener::UserUpdated(), *user);
 }
 
 void ClientManager::on(ClientListener::UsersUpdated, const Client*, const OnlineUserList& l) noexcept {
 	for (const auto& ou: l) {
+		onlineUserIndex.updateUser(ou);
 		fire(ClientManagerListener::UserUpdated(), *ou); 
 	}
 }
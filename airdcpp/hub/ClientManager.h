@@ -23,6 +23,7 @@
 
 #include "ClientManagerListener.h"
 #include "Client.h"
+#include "OnlineUserIndex.h"
 #include "UserConnectResult.h"
 
 #include <airdcpp/core/timer/TimerManagerListener.h>
@@ -157,6 +158,9 @@ public:
 	// Get users with nick matching the pattern. Uses relevancies for priorizing the results.
 	OnlineUserList searchNicks(const string& aPattern, size_t aMaxResults, bool aIgnorePrefix, const StringList& aHubUrls) const noexcept;
 
+	// Get all online instances of users that are using the IP address (IPv4 or IPv6)
+	OnlineUserList findOnlineUsersByIp(const string& aIp) const noexcept;
+
 	// Fire UserUpdated via each connected hub
 	void userUpdated(const UserPtr& aUser) const noexcept;
 
@@ -294,6 +298,9 @@ private:
 	UserMap users;
 	OnlineMap onlineUsers;
 
+	// Nick and IP lookups for online users (synchronized separately, not protected by cs)
+	OnlineUserIndex onlineUserIndex;
+
 	OfflineUserMap offlineUsers;
 
 	UserPtr me;
@@ -122,11 +122,13 @@ void NmdcHub::refreshLocalIp() noexcept {
 
 void NmdcHub::refreshUserList(bool refreshOnly) noexcept {
 	if(refreshOnly) {
-		RLock l(cs);
-
 		OnlineUserList v;
-		for(auto n: users | views::values)
-			v.push_back(n);
+
+		{
+			RLock l(cs);
+			for(auto n: users | views::values)
+				v.push_back(n);
+		}
 
 		fire(ClientListener::UsersUpdated(), this, v);
 	} else {
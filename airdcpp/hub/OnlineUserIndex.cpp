@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2011-2024 AirDC++ Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "stdinc.h"
+#include <airdcpp/hub/OnlineUserIndex.h>
+
+#include <airdcpp/user/OnlineUser.h>
+#include <airdcpp/util/text/Text.h>
+
+namespace dcpp {
+
+OnlineUserIndex::Entry OnlineUserIndex::createEntry(const OnlineUserPtr& aUser) noexcept {
+	const auto& identity = aUser->getIdentity();
+	auto nick = identity.getNick();
+	auto nickLower = Text::toLower(nick);
+	return { aUser, std::move(nick), std::move(nickLower), identity.getIp4(), identity.getIp6() };
+}
+
+bool OnlineUserIndex::isIndexed(const Entry& aEntry, const string& aNick, const string& aIp4, const string& aIp6) noexcept {
+	return aEntry.nick == aNick && aEntry.ip4 == aIp4 && aEntry.ip6 == aIp6;
+}
+
+void OnlineUserIndex::getTrigrams(const string& aLowerStr, vector<Trigram>& trigrams_) noexcept {
+	for (size_t i = 0; i + 3 <= aLowerStr.size(); ++i) {
+		auto trigram = static_cast<Trigram>(static_cast<uint8_t>(aLowerStr[i])) << 16 |
+			static_cast<Trigram>(static_cast<uint8_t>(aLowerStr[i + 1])) << 8 |
+			static_cast<Trigram>(static_cast<uint8_t>(aLowerStr[i + 2]));
+		trigrams_.push_back(trigram);
+	}
+}
+
+void OnlineUserIndex::addUser(const OnlineUserPtr& aUser) noexcept {
+	auto entry = createEntry(aUser);
+
+	WLock l(cs);
+	if (auto i = entries.find(aUser.get()); i != entries.end()) {
+		unindexEntry(i->second);
+	}
+
+	indexEntry(entry);
+	entries.insert_or_assign(aUser.get(), std::move(entry));
+}
+
+void OnlineUserIndex::removeUser(const OnlineUserPtr& aUser) noexcept {
+	WLock l(cs);
+	auto i = entries.find(aUser.get());
+	if (i == entries.end()) {
+		return;
+	}
+
+	unindexEntry(i->second);
+	entries.erase(i);
+}
+
+void OnlineUserIndex::updateUser(const OnlineUserPtr& aUser) noexcept {
+	const auto& identity = aUser->getIdentity();
+	const auto nick = identity.getNick();
+	const auto ip4 = identity.getIp4();
+	const auto ip6 = identity.getIp6();
+
+	{
+		// Most updates don't change the indexed fields
+		RLock l(cs);
+		auto i = entries.find(aUser.get());
+		if (i == entries.end() || isIndexed(i->second, nick, ip4, ip6)) {
+			return;
+		}
+	}
+
+	auto entry = createEntry(aUser);
+
+	WLock l(cs);
+	auto i = entries.find(aUser.get());
+	if (i == entries.end()) {
+		return;
+	}
+
+	unindexEntry(i->second);
+	indexEntry(entry);
+	i->second = std::move(entry);
+}
+
+size_t OnlineUserIndex::size() const noexcept {
+	RLock l(cs);
+	return entries.size();
+}
+
+void OnlineUserIndex::indexEntry(const Entry& aEntry) noexcept {
+	auto user = aEntry.user.get();
+
+	vector<Trigram> nickTrigrams;
+	getTrigrams(aEntry.nickLower, nickTrigrams);
+	for (auto t: nickTrigrams) {
+		trigrams[t].insert(user);
+	}
+
+	addIp(aEntry.ip4, user);
+	addIp(aEntry.ip6, user);
+}
+
+void OnlineUserIndex::unindexEntry(const Entry& aEntry) noexcept {
+	auto user = aEntry.user.get();
+
+	vector<Trigram> nickTrigrams;
+	getTrigrams(aEntry.nickLower, nickTrigrams);
+	for (auto t: nickTrigrams) {
+		auto i = trigrams.find(t);
+		if (i == trigrams.end()) {
+			continue;
+		}
+
+		i->second.erase(user);
+		if (i->second.empty()) {
+			trigrams.erase(i);
+		}
+	}
+
+	removeIp(aEntry.ip4, user);
+	removeIp(aEntry.ip6, user);
+}
+
+void OnlineUserIndex::addIp(const string& aIp, const OnlineUser* aUser) noexcept {
+	if (!aIp.empty()) {
+		ips[aIp].insert(aUser);
+	}
+}
+
+void OnlineUserIndex::removeIp(const string& aIp, const OnlineUser* aUser) noexcept {
+	if (aIp.empty()) {
+		return;
+	}
+
+	auto i = ips.find(aIp);
+	if (i == ips.end()) {
+		return;
+	}
+
+	i->second.erase(aUser);
+	if (i->second.empty()) {
+		ips.erase(i);
+	}
+}
+
+OnlineUserList OnlineUserIndex::getNickCandidates(const StringList& aLowerPatterns) const noexcept {
+	OnlineUserList ret;
+
+	vector<Trigram> patternTrigrams;
+	for (const auto& p: aLowerPatterns) {
+		getTrigrams(p, patternTrigrams);
+	}
+
+	RLock l(cs);
+	if (patternTrigrams.empty()) {
+		// Patterns are too short for the index
+		for (const auto& entry: entries | views::values) {
+			ret.push_back(entry.user);
+		}
+
+		return ret;
+	}
+
+	// Each matching nick must contain all the trigrams, walk through the smallest set
+	const UserSet* candidates = nullptr;
+	for (auto t: patternTrigrams) {
+		auto i = trigrams.find(t);
+		if (i == trigrams.end()) {
+			return ret;
+		}
+
+		if (!candidates || i->second.size() < candidates->size()) {
+			candidates = &i->second;
+		}
+	}
+
+	for (auto user: *candidates) {
+		ret.push_back(entries.at(user).user);
+	}
+
+	return ret;
+}
+
+OnlineUserList OnlineUserIndex::findByIp(const string& aIp) const noexcept {
+	OnlineUserList ret;
+
+	RLock l(cs);
+	auto i = ips.find(aIp);
+	if (i != ips.end()) {
+		for (auto user: i->second) {
+			ret.push_back(entries.at(user).user);
+		}
+	}
+
+	return ret;
+}
+
+} // namespace dcpp
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2011-2024 AirDC++ Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef DCPLUSPLUS_DCPP_ONLINE_USER_INDEX_H
+#define DCPLUSPLUS_DCPP_ONLINE_USER_INDEX_H
+
+#include <airdcpp/core/header/typedefs.h>
+#include <airdcpp/core/thread/CriticalSection.h>
+#include <airdcpp/forward.h>
+
+namespace dcpp {
+
+// Nick (trigram) and IP address index of the online users
+// The index has its own lock that is never held while calling other components (clients must be able to update it while holding their own locks)
+class OnlineUserIndex {
+public:
+	void addUser(const OnlineUserPtr& aUser) noexcept;
+	void removeUser(const OnlineUserPtr& aUser) noexcept;
+
+	// Re-index the user if the nick or the IP addresses have changed
+	// Users that haven't been added are ignored
+	void updateUser(const OnlineUserPtr& aUser) noexcept;
+
+	// Returns the users whose nick may contain all the patterns (the patterns must be in lower case)
+	// The candidates must still be validated by the caller
+	OnlineUserList getNickCandidates(const StringList& aLowerPatterns) const noexcept;
+	OnlineUserList findByIp(const string& aIp) const noexcept;
+
+	size_t size() const noexcept;
+private:
+	using Trigram = uint32_t;
+	using UserSet = unordered_set<const OnlineUser*>;
+
+	struct Entry {
+		OnlineUserPtr user;
+		string nick;
+		string nickLower;
+		string ip4;
+		string ip6;
+	};
+
+	static Entry createEntry(const OnlineUserPtr& aUser) noexcept;
+	static bool isIndexed(const Entry& aEntry, const string& aNick, const string& aIp4, const string& aIp6) noexcept;
+	static void getTrigrams(const string& aLowerStr, vector<Trigram>& trigrams_) noexcept;
+
+	void indexEntry(const Entry& aEntry) noexcept;
+	void unindexEntry(const Entry& aEntry) noexcept;
+
+	void addIp(const string& aIp, const OnlineUser* aUser) noexcept;
+	void removeIp(const string& aIp, const OnlineUser* aUser) noexcept;
+
+	mutable SharedMutex cs;
+
+	unordered_map<const OnlineUser*, Entry> entries;
+	unordered_map<Trigram, UserSet> trigrams;
+	unordered_map<string, UserSet> ips;
+};
+
+} // namespace dcpp
+
+#endif // !defined(DCPLUSPLUS_DCPP_ONLINE_USER_INDEX_H)
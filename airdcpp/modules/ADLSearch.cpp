@@ -23,12 +23,14 @@
 
 #include "stdinc.h"
 #include "ADLSearch.h"
+#include "ADLSearchMatcher.h"
 
 #include <airdcpp/core/io/File.h>
 #include <airdcpp/events/LogManager.h>
 #include <airdcpp/util/PathUtil.h>
 #include <airdcpp/queue/QueueManager.h>
 #include <airdcpp/core/classes/ScopedFunctor.h>
+#include <airdcpp/core/thread/concurrency.h>
 #include <airdcpp/core/io/xml/SimpleXML.h>
 
 #define CONFIG_NAME "ADLSearch.xml"
@@ -191,7 +193,7 @@ bool ADLSearch::matchesDirectory(const string& d) {
 }
 
 // Constructor/destructor
-ADLSearchManager::ADLSearchManager() {
+ADLSearchManager::ADLSearchManager() : matcher(make_unique<ADLSearchMatcher>()) {
 
 }
 
@@ -331,6 +333,17 @@ void ADLSearchManager::load() noexcept {
 	for(auto& s: collection) {
 		s.prepare();
 	}
+
+	matcherDirty = true;
+}
+
+void ADLSearchManager::updateMatcher() noexcept {
+	// The collection can't be modified while the searches are running
+	Lock l(matcherCS);
+	if (matcherDirty) {
+		matcher->build(collection);
+		matcherDirty = false;
+	}
 }
 
 bool ADLSearchManager::addCollection(ADLSearch& search, int index) noexcept {
@@ -346,6 +359,7 @@ bool ADLSearchManager::addCollection(ADLSearch& search, int index) noexcept {
 	search.prepare();
 	collection.insert(collection.begin() + index, search);
 	dirty = true;
+	matcherDirty = true;
 	return true;
 }
 
@@ -361,6 +375,7 @@ bool ADLSearchManager::removeCollection(int index) noexcept {
 
 	collection.erase(collection.begin() + index);
 	dirty = true;
+	matcherDirty = true;
 	return true;
 }
 
@@ -372,6 +387,7 @@ bool ADLSearchManager::changeState(int index, bool aIsActive) noexcept {
 
 	collection[index].isActive = aIsActive;
 	dirty = true;
+	matcherDirty = true;
 	return true;
 }
 
@@ -384,6 +400,7 @@ bool ADLSearchManager::updateCollection(ADLSearch& search, int index) noexcept {
 	collection[index] = search;
 	search.prepare();
 	dirty = true;
+	matcherDirty = true;
 	return true;
 }
 
@@ -446,23 +463,37 @@ void ADLSearchManager::MatchesFile(DestDirList& destDirVector, const DirectoryLi
 		return;
 	}
 
+	const string fileName(currentFile->getName());
+
 	dcassert(PathUtil::isAdcDirectoryPath(aAdcPath));
 
 	// Use NMDC path for matching due to compatibility reasons
-	const auto nmdcPath = PathUtil::toNmdcFile(aAdcPath + currentFile->getName());
+	string nmdcPath;
+	auto candidates = matcher->getCandidates(ADLSearch::OnlyFile, fileName);
+	if (matcher->hasRules(ADLSearch::FullPath)) {
+		nmdcPath = PathUtil::toNmdcFile(aAdcPath + fileName);
+
+		auto pathCandidates = matcher->getCandidates(ADLSearch::FullPath, nmdcPath);
+		if (!pathCandidates.empty()) {
+			ADLSearchMatcher::RuleList merged;
+			ranges::merge(candidates, pathCandidates, back_inserter(merged));
+			candidates.swap(merged);
+		}
+	}
 
 	// Match searches
-	for(auto& is: collection) {
+	for (auto rule: candidates) {
+		auto& is = collection[rule];
 		if(destDirVector[is.ddIndex].fileAdded) {
 			continue;
 		}
-		if(is.matchesFile(currentFile->getName(), nmdcPath, currentFile->getSize())) {
+		if(is.matchesFile(fileName, nmdcPath, currentFile->getSize())) {
 			auto copyFile = make_shared<DirectoryListing::File>(*currentFile, this);
 			destDirVector[is.ddIndex].dir->files.push_back(copyFile);
 			destDirVector[is.ddIndex].fileAdded = true;
 
 			if (is.isAutoQueue){
-				auto fileInfo = BundleFileAddData(currentFile->getName(), currentFile->getTTH(), currentFile->getSize(), Priority::DEFAULT, currentFile->getRemoteDate());
+				auto fileInfo = BundleFileAddData(fileName, currentFile->getTTH(), currentFile->getSize(), Priority::DEFAULT, currentFile->getRemoteDate());
 				try {
 					auto options = BundleAddOptions(SETTING(DOWNLOAD_DIRECTORY), getUser(), this);
 					QueueManager::getInstance()->createFileBundleHooked(options, fileInfo);
@@ -493,7 +524,8 @@ void ADLSearchManager::MatchesDirectory(DestDirList& destDirVector, const Direct
 		return;
 	}
 
-	for (auto& is: collection) {
+	for (auto rule: matcher->getCandidates(ADLSearch::OnlyDirectory, currentDir->getName())) {
+		auto& is = collection[rule];
 		if(destDirVector[is.ddIndex].subdir) {
 			continue;
 		}
@@ -520,7 +552,7 @@ void ADLSearchManager::stepUpDirectory(DestDirList& destDirVector) noexcept {
 	}
 }
 
-void ADLSearchManager::addRootDirectory(const string& aName, DestDirList& destDirs_, DirectoryListing::Directory::Ptr& root) noexcept {
+void ADLSearchManager::addRootDirectory(const string& aName, DestDirList& destDirs_, const DirectoryListing::Directory::Ptr& root) noexcept {
 	DestDir newDir = { 
 		aName,
 
@@ -579,7 +611,7 @@ void ADLSearchManager::FinalizeDestinationDirectories(DestDirList& destDirs, Dir
 			continue;
 		}
 
-		root->directories.try_emplace(&i.dir->getName(), i.dir);
+		root->directories.emplace_sorted(&i.dir->getName(), i.dir);
 	}
 }
 
@@ -593,16 +625,86 @@ void ADLSearchManager::matchListing(DirectoryListing& aDirList) {
 	DestDirList destDirs;
 	PrepareDestinationDirectories(destDirs, root);
 	setBreakOnFirst(SETTING(ADLS_BREAK_ON_FIRST));
+	updateMatcher();
 
-	string path(aDirList.getRoot()->getName());
-	matchRecurse(destDirs, aDirList.getRoot(), path, aDirList);
-	//for (const auto& d: aDirList.getRoot()->directories | views::values /*| views::filter(DirectoryListing::Directory::NotVirtual)*/) {
-	//	matchRecurse(destDirs, d, d->getAdcPath(), aDirList);
-	//}
+	matchDirectories(destDirs, root, aDirList);
 
 	FinalizeDestinationDirectories(destDirs, root);
 }
 
+void ADLSearchManager::matchDirectories(DestDirList& aDestList, const DirectoryListing::Directory::Ptr& aRoot, DirectoryListing& aDirList) {
+	const auto& rootPath = aRoot->getName();
+
+	vector<DirectoryListing::Directory::Ptr> topDirs;
+	for (const auto& dir: aRoot->directories | views::values) {
+		topDirs.push_back(dir);
+	}
+
+	// Each top-level directory gets its own set of destination directories
+	vector<DestDirList> topDestLists(topDirs.size());
+	for (auto& destList: topDestLists) {
+		for (const auto& destDir: aDestList) {
+			addRootDirectory(destDir.name, destList, aRoot);
+		}
+	}
+
+	vector<size_t> indexes(topDirs.size());
+	iota(indexes.begin(), indexes.end(), 0);
+
+	parallel_for_each(indexes.begin(), indexes.end(), [&](size_t aIndex) {
+		const auto& dir = topDirs[aIndex];
+		auto& destList = topDestLists[aIndex];
+
+		auto subAdcPath = PathUtil::joinAdcDirectory(rootPath, dir->getName());
+		MatchesDirectory(destList, dir, subAdcPath);
+		matchRecurse(destList, dir, subAdcPath, aDirList);
+	});
+
+	// Merge in the listing order (the result is identical to matching the directories sequentially)
+	for (const auto& destList: topDestLists) {
+		for (size_t i = 0; i < aDestList.size(); ++i) {
+			mergeDestinationDirectory(destList[i].dir, aDestList[i].dir);
+		}
+	}
+
+	for (const auto& file: aRoot->files) {
+		MatchesFile(aDestList, file, rootPath);
+	}
+}
+
+void ADLSearchManager::mergeDestinationDirectory(const DirectoryListing::Directory::Ptr& aSource, const DirectoryListing::Directory::Ptr& aTarget) noexcept {
+	ranges::move(aSource->files, back_inserter(aTarget->files));
+	aSource->files.clear();
+
+	// Use the creation order so that the duplicate names will be numbered in the same way as when matching sequentially
+	vector<DirectoryListing::VirtualDirectory::Ptr> dirs;
+	for (const auto& dir: aSource->directories | views::values) {
+		dirs.push_back(static_pointer_cast<DirectoryListing::VirtualDirectory>(dir));
+	}
+
+	aSource->directories.clear();
+	ranges::sort(dirs, [](const auto& a, const auto& b) { return a->getToken() < b->getToken(); });
+
+	for (const auto& dir: dirs) {
+		const auto originalName = PathUtil::getAdcLastDir(dir->getFullAdcPath());
+		if (dir->getName() == originalName && !aTarget->directories.contains(&dir->getName())) {
+			dir->setParent(aTarget.get());
+			aTarget->directories.emplace_sorted(&dir->getName(), dir);
+			continue;
+		}
+
+		// Names can't be changed, move the content to a new directory
+		auto newDir = DirectoryListing::VirtualDirectory::create(dir->getFullAdcPath(), aTarget.get(), originalName);
+		newDir->files = std::move(dir->files);
+		for (const auto& [name, child]: dir->directories) {
+			child->setParent(newDir.get());
+			newDir->directories.emplace_sorted(name, child);
+		}
+
+		dir->directories.clear();
+	}
+}
+
 void ADLSearchManager::matchRecurse(DestDirList &aDestList, const DirectoryListing::Directory::Ptr& aDir, const string& aAdcPath, DirectoryListing& aDirList) {
 	dcassert(aDir->getType() != DirectoryListing::Directory::TYPE_VIRTUAL);
 	if (aDirList.getClosing()) {
@@ -27,11 +27,13 @@
 #include <airdcpp/filelist/DirectoryListingDirectory.h>
 #include <airdcpp/message/Message.h>
 #include <airdcpp/core/Singleton.h>
+#include <airdcpp/core/thread/CriticalSection.h>
 #include <airdcpp/util/text/StringMatch.h>
 
 namespace dcpp {
 
 class AdlSearchManager;
+class ADLSearchMatcher;
 
 ///	Class that represent an ADL search
 class ADLSearch
@@ -100,6 +102,7 @@ private:
 	string name;
 
 	friend class ADLSearchManager;
+	friend class ADLSearchMatcher;
 
 	StringMatch match;
 
@@ -162,6 +165,19 @@ private:
 	ADLSearch::SourceType StringToSourceType(const string& s);
 	bool dirty = false;
 
+	// Compiled rules of the current collection
+	unique_ptr<ADLSearchMatcher> matcher;
+	bool matcherDirty = true;
+	CriticalSection matcherCS;
+	void updateMatcher() noexcept;
+
+	// Matches the top-level directories of the list in parallel and merges the results in the original order
+	// Throws AbortException
+	void matchDirectories(DestDirList& aDestList, const DirectoryListing::Directory::Ptr& aRoot, DirectoryListing& aDirList);
+
+	// Moves the matches of a top-level directory to the final destination directory
+	static void mergeDestinationDirectory(const DirectoryListing::Directory::Ptr& aSource, const DirectoryListing::Directory::Ptr& aTarget) noexcept;
+
 	// @internal
 	// Throws AbortException
 	void matchRecurse(DestDirList& /*aDestList*/, const DirectoryListing::Directory::Ptr& /*aDir*/, const string& aAdcPath, DirectoryListing& /*aDirList*/);
@@ -174,7 +190,7 @@ private:
 
 	// Prepare destination directory indexing
 	void PrepareDestinationDirectories(DestDirList& destDirVector, DirectoryListing::Directory::Ptr& root) noexcept;
-	static void addRootDirectory(const string& aName, DestDirList& destDirs_, DirectoryListing::Directory::Ptr& root) noexcept;
+	static void addRootDirectory(const string& aName, DestDirList& destDirs_, const DirectoryListing::Directory::Ptr& root) noexcept;
 	// Finalize destination directories
 	void FinalizeDestinationDirectories(DestDirList& destDirVector, DirectoryListing::Directory::Ptr& root) noexcept;
 
@@ -0,0 +1,120 @@
+/*
+* Copyright (C) 2011-2024 AirDC++ Project
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#include "stdinc.h"
+
+#include "ADLSearchMatcher.h"
+#include "AutoSearchMatcher.h"
+
+#include <airdcpp/util/text/Text.h>
+
+namespace dcpp {
+
+void ADLSearchMatcher::build(const ADLSearchManager::SearchCollection& aCollection) noexcept {
+	for (auto& group: groups) {
+		group.clear();
+	}
+
+	for (uint32_t rule = 0; rule < aCollection.size(); ++rule) {
+		const auto& search = aCollection[rule];
+		if (!search.isActive) {
+			continue;
+		}
+
+		auto method = search.isRegEx() ? StringMatch::REGEX : StringMatch::PARTIAL;
+		groups[search.sourceType].addRule(rule, AutoSearchMatcher::getRequiredLiterals(search.match.pattern, method));
+	}
+
+	for (auto& group: groups) {
+		group.automaton.build();
+	}
+
+	dcdebug("ADLSearchMatcher: compiled %d rules\n", static_cast<int>(aCollection.size()));
+}
+
+ADLSearchMatcher::RuleList ADLSearchMatcher::getCandidates(ADLSearch::SourceType aType, const string& aText) const noexcept {
+	return groups[aType].match(aText);
+}
+
+void ADLSearchMatcher::Group::clear() noexcept {
+	automaton.clear();
+	entries.clear();
+	patternEntries.clear();
+	unfilteredEntries.clear();
+}
+
+void ADLSearchMatcher::Group::addRule(uint32_t aRule, const StringList& aLiterals) noexcept {
+	auto index = static_cast<EntryIndex>(entries.size());
+	auto& entry = entries.emplace_back();
+	entry.rule = aRule;
+
+	if (aLiterals.empty()) {
+		unfilteredEntries.push_back(index);
+		return;
+	}
+
+	for (const auto& literal: aLiterals) {
+		auto pattern = automaton.addPattern(literal);
+		if (pattern >= patternEntries.size()) {
+			patternEntries.resize(pattern + 1);
+		}
+
+		// The same literal may be required multiple times
+		auto& patternItems = patternEntries[pattern];
+		if (patternItems.empty() || patternItems.back() != index) {
+			patternItems.push_back(index);
+			entry.requiredPatterns++;
+		}
+	}
+}
+
+ADLSearchMatcher::RuleList ADLSearchMatcher::Group::match(const string& aText) const noexcept {
+	RuleList ret;
+	for (auto index: unfilteredEntries) {
+		ret.push_back(entries[index].rule);
+	}
+
+	if (!automaton.empty()) {
+		// Most of the texts won't contain any of the patterns, avoid allocations until something is found
+		vector<AhoCorasick::PatternId> foundPatterns;
+		automaton.match(Text::toLower(aText), [&](AhoCorasick::PatternId aPattern, size_t) {
+			foundPatterns.push_back(aPattern);
+			return true;
+		});
+
+		if (!foundPatterns.empty()) {
+			ranges::sort(foundPatterns);
+			foundPatterns.erase(ranges::unique(foundPatterns).begin(), foundPatterns.end());
+
+			unordered_map<EntryIndex, uint32_t> foundCounts;
+			for (auto pattern: foundPatterns) {
+				for (auto index: patternEntries[pattern]) {
+					if (++foundCounts[index] == entries[index].requiredPatterns) {
+						ret.push_back(entries[index].rule);
+					}
+				}
+			}
+		}
+	}
+
+	// Keep the collection order
+	ranges::sort(ret);
+	return ret;
+}
+
+}
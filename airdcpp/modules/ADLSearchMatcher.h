@@ -0,0 +1,75 @@
+/*
+* Copyright (C) 2011-2024 AirDC++ Project
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#ifndef DCPLUSPLUS_DCPP_ADLSEARCH_MATCHER_H
+#define DCPLUSPLUS_DCPP_ADLSEARCH_MATCHER_H
+
+#include <airdcpp/forward.h>
+
+#include "ADLSearch.h"
+
+#include <airdcpp/util/text/AhoCorasick.h>
+
+namespace dcpp {
+
+// Compiled form of the ADL search collection
+//
+// The literals required by the rules (partial match words and literal runs of regular expressions) are compiled
+// into a single automaton per source type so that the rules that may match a name or path are found with one pass.
+// Rules without usable literals (mostly regular expressions) are grouped separately and are always returned.
+// The candidates must still be matched normally.
+class ADLSearchMatcher {
+public:
+	// Rule indexes in the search collection, in ascending order
+	using RuleList = vector<uint32_t>;
+
+	// The collection must not be modified while the matcher is being used
+	void build(const ADLSearchManager::SearchCollection& aCollection) noexcept;
+
+	RuleList getCandidates(ADLSearch::SourceType aType, const string& aText) const noexcept;
+	bool hasRules(ADLSearch::SourceType aType) const noexcept { return !groups[aType].empty(); }
+private:
+	using EntryIndex = uint32_t;
+
+	struct Entry {
+		uint32_t rule;
+		uint32_t requiredPatterns = 0;
+	};
+
+	struct Group {
+		AhoCorasick automaton;
+		vector<Entry> entries;
+
+		// Entries requiring each pattern of the automaton
+		vector<vector<EntryIndex>> patternEntries;
+
+		// Entries that can't be filtered by their literals
+		vector<EntryIndex> unfilteredEntries;
+
+		bool empty() const noexcept { return entries.empty(); }
+		void clear() noexcept;
+		void addRule(uint32_t aRule, const StringList& aLiterals) noexcept;
+		RuleList match(const string& aText) const noexcept;
+	};
+
+	array<Group, ADLSearch::TypeLast> groups;
+};
+
+}
+
+#endif
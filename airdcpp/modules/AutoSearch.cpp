@@ -41,6 +41,8 @@ namespace dcpp {
 using namespace boost::posix_time;
 using namespace boost::gregorian;
 
+atomic<uint32_t> AutoSearch::patternRevision { 0 };
+
 AutoSearch::AutoSearch() noexcept : token(ValueGenerator::randInt(10)) {
 
 }
@@ -216,6 +218,7 @@ void AutoSearch::updatePattern() noexcept {
 		pattern = matcherString;
 	}
 	prepare();
+	patternRevision++;
 }
 
 string AutoSearch::getDisplayType() const noexcept {
@@ -167,6 +167,9 @@ public:
 	bool allowNewItems() const noexcept;
 	bool allowAutoSearch() const noexcept;
 	void updatePattern() noexcept;
+
+	// Incremented whenever the matching pattern of any item is updated
+	static uint32_t getPatternRevision() noexcept { return patternRevision; }
 	void changeNumber(bool increase) noexcept;
 	bool updateSearchTime() noexcept;
 	void saveToXml(SimpleXML& xml);
@@ -205,6 +208,8 @@ private:
 	StringSearch excluded;
 
 	bool recent = false;
+
+	static atomic<uint32_t> patternRevision;
 };
 
 }
@@ -46,6 +46,10 @@ using ranges::copy_if;
 
 AutoSearchManager::AutoSearchManager() noexcept
 {
+#ifdef _DEBUG
+	AutoSearchMatcher::testRegexLiterals();
+#endif
+
 	TimerManager::getInstance()->addListener(this);
 	SearchManager::getInstance()->addListener(this);
 	DirectoryListingManager::getInstance()->addListener(this);
@@ -92,6 +96,7 @@ void AutoSearchManager::addAutoSearch(AutoSearchPtr aAutoSearch, bool search, bo
 	{
 		WLock l(cs);
 		searchItems.addItem(aAutoSearch);
+		resultMatcher.setDirty();
 	}
 
 	dirty = true;
@@ -187,6 +192,7 @@ void AutoSearchManager::removeAutoSearch(AutoSearchPtr& aItem) noexcept {
 		if(hasItem) {
 			fire(AutoSearchManagerListener::ItemRemoved(), aItem);
 			searchItems.removeItem(aItem);
+			resultMatcher.setDirty();
 			dirty = true;
 		}
 	}
@@ -652,7 +658,9 @@ AutoSearchList AutoSearchManager::matchResult(const SearchResultPtr& sr) noexcep
 	AutoSearchList matches;
 
 	RLock l (cs);
-	for(auto& as: searchItems.getItems() | views::values) {
+
+	// Only check the items whose patterns may match
+	for (auto& as: resultMatcher.getCandidates(sr, searchItems.getItems())) {
 		if (!as->allowNewItems() && !as->getManualSearch())
 			continue;
 			
@@ -22,6 +22,7 @@
 #include <airdcpp/forward.h>
 
 #include "AutoSearchManagerListener.h"
+#include "AutoSearchMatcher.h"
 #include "AutoSearchQueue.h"
 
 #include <airdcpp/filelist/DirectoryListingManagerListener.h>
@@ -113,6 +114,7 @@ private:
 	//count minutes to be more accurate than comparing ticks every minute.
 	void checkItems() noexcept;
 	Searches searchItems;
+	AutoSearchMatcher resultMatcher;
 
 	void loadAutoSearch(SimpleXML& aXml);
 
@@ -0,0 +1,320 @@
+/*
+* Copyright (C) 2011-2024 AirDC++ Project
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#include "stdinc.h"
+
+#include "AutoSearchMatcher.h"
+
+#include <airdcpp/search/SearchResult.h>
+#include <airdcpp/search/SearchTypes.h>
+#include <airdcpp/util/text/StringTokenizer.h>
+#include <airdcpp/util/text/Text.h>
+
+namespace dcpp {
+
+void AutoSearchMatcher::setDirty() noexcept {
+	WLock l(cs);
+	dirty = true;
+}
+
+bool AutoSearchMatcher::isCurrent() const noexcept {
+	return !dirty && patternRevision == AutoSearch::getPatternRevision();
+}
+
+AutoSearchList AutoSearchMatcher::getCandidates(const SearchResultPtr& aResult, const AutoSearchMap& aItems) noexcept {
+	{
+		RLock l(cs);
+		if (isCurrent()) {
+			return matchUnsafe(aResult);
+		}
+	}
+
+	WLock l(cs);
+	if (!isCurrent()) {
+		rebuild(aItems);
+	}
+
+	return matchUnsafe(aResult);
+}
+
+void AutoSearchMatcher::rebuild(const AutoSearchMap& aItems) noexcept {
+	// Read the revision first, changes made during the rebuild will cause another one
+	patternRevision = AutoSearch::getPatternRevision();
+	dirty = false;
+
+	automaton.clear();
+	entries.clear();
+	patternEntries.clear();
+	unfilteredEntries.clear();
+
+	for (const auto& as: aItems | views::values) {
+		auto index = static_cast<EntryIndex>(entries.size());
+		auto& entry = entries.emplace_back();
+		entry.item = as;
+
+		StringList literals;
+		if (as->getFileType() != SEARCH_TYPE_TTH) {
+			literals = getRequiredLiterals(as->pattern, as->getMethod());
+		}
+
+		if (literals.empty()) {
+			unfilteredEntries.push_back(index);
+			continue;
+		}
+
+		for (const auto& literal: literals) {
+			auto pattern = automaton.addPattern(literal);
+			if (pattern >= patternEntries.size()) {
+				patternEntries.resize(pattern + 1);
+			}
+
+			// The same literal may be required multiple times
+			auto& patternItems = patternEntries[pattern];
+			if (patternItems.empty() || patternItems.back() != index) {
+				patternItems.push_back(index);
+				entry.requiredPatterns++;
+			}
+		}
+	}
+
+	automaton.build();
+	dcdebug("AutoSearchMatcher: compiled %d items (%d patterns, %d unfiltered items)\n", 
+		static_cast<int>(entries.size()), static_cast<int>(automaton.getPatternCount()), static_cast<int>(unfilteredEntries.size()));
+}
+
+AutoSearchList AutoSearchMatcher::matchUnsafe(const SearchResultPtr& aResult) const noexcept {
+	vector<EntryIndex> matches(unfilteredEntries);
+
+	if (!automaton.empty()) {
+		auto pathLower = Text::toLower(aResult->getAdcPath());
+
+		// Items that don't match the full path only match the file/directory name
+		// Occurrences are counted for them only when they start within the name
+		size_t nameStart = 0;
+		{
+			auto nameLower = Text::toLower(aResult->getFileName());
+			auto nameEnd = aResult->getType() == SearchResult::Type::DIRECTORY ? pathLower.size() - 1 : pathLower.size();
+			if (nameLower.size() <= nameEnd && pathLower.compare(nameEnd - nameLower.size(), nameLower.size(), nameLower) == 0) {
+				nameStart = nameEnd - nameLower.size();
+			}
+		}
+
+		// Last start position of each found pattern
+		unordered_map<AhoCorasick::PatternId, size_t> foundPatterns;
+		automaton.match(pathLower, [&](AhoCorasick::PatternId aPattern, size_t aStartPos) {
+			foundPatterns[aPattern] = aStartPos;
+			return true;
+		});
+
+		unordered_map<EntryIndex, uint32_t> foundCounts;
+		for (const auto& [pattern, startPos]: foundPatterns) {
+			for (auto index: patternEntries[pattern]) {
+				if (startPos >= nameStart || entries[index].item->getMatchFullPath()) {
+					if (++foundCounts[index] == entries[index].requiredPatterns) {
+						matches.push_back(index);
+					}
+				}
+			}
+		}
+	}
+
+	// Keep the item order
+	ranges::sort(matches);
+
+	AutoSearchList ret;
+	for (auto index: matches) {
+		ret.push_back(entries[index].item);
+	}
+
+	return ret;
+}
+
+StringList AutoSearchMatcher::getRequiredLiterals(const string& aPattern, StringMatch::Method aMethod) noexcept {
+	StringList ret;
+	switch (aMethod) {
+		case StringMatch::PARTIAL: {
+			for (const auto& word: StringTokenizer<string>(aPattern, ' ').getTokens()) {
+				if (!word.empty()) {
+					ret.push_back(Text::toLower(word));
+				}
+			}
+			break;
+		}
+		case StringMatch::EXACT: {
+			if (!aPattern.empty()) {
+				ret.push_back(Text::toLower(aPattern));
+			}
+			break;
+		}
+		case StringMatch::WILDCARD: {
+			// Alternatives and quantifiers aren't escaped when the wildcard pattern is converted to a regex
+			if (aPattern.find_first_of("|{") != string::npos) {
+				break;
+			}
+
+			// Fragments between the wildcard characters
+			string fragment;
+			for (auto c: aPattern) {
+				if (c == '*' || c == '?') {
+					if (!fragment.empty()) {
+						ret.push_back(Text::toLower(fragment));
+						fragment.clear();
+					}
+				} else {
+					fragment += c;
+				}
+			}
+
+			if (!fragment.empty()) {
+				ret.push_back(Text::toLower(fragment));
+			}
+			break;
+		}
+		case StringMatch::REGEX: {
+			ret = getRegexLiterals(aPattern);
+			break;
+		}
+		case StringMatch::METHOD_LAST: break;
+	}
+
+	return ret;
+}
+
+StringList AutoSearchMatcher::getRegexLiterals(const string& aPattern) noexcept {
+	// Alternatives and inline modifiers make the literals optional
+	if (aPattern.find('|') != string::npos || aPattern.find("(?") != string::npos) {
+		return StringList();
+	}
+
+	// Collect the plain character runs outside of groups and character classes
+	// Quantified characters are dropped (they may not be present)
+	StringList ret;
+	string run;
+	auto endRun = [&] {
+		if (run.size() >= 2) {
+			ret.push_back(Text::toLower(run));
+		}
+
+		run.clear();
+	};
+
+	int groupDepth = 0;
+	for (size_t i = 0; i < aPattern.size(); ++i) {
+		auto c = aPattern[i];
+		switch (c) {
+			case '\\': {
+				// Escaped characters and character classes
+				endRun();
+				i++;
+				break;
+			}
+			case '[': {
+				endRun();
+
+				// Skip the class (a closing bracket right after the opening one is a literal)
+				auto end = aPattern.find(']', i + 2);
+				if (end == string::npos) {
+					return StringList();
+				}
+
+				i = end;
+				break;
+			}
+			case '(': {
+				endRun();
+				groupDepth++;
+				break;
+			}
+			case ')': {
+				endRun();
+				groupDepth--;
+				break;
+			}
+			case '?':
+			case '*': {
+				// The previous character is optional
+				if (!run.empty()) {
+					run.pop_back();
+				}
+
+				endRun();
+				break;
+			}
+			case '{': {
+				// The previous character may be repeated any number of times (including zero)
+				if (!run.empty()) {
+					run.pop_back();
+				}
+
+				endRun();
+
+				// Skip the bounds
+				auto end = aPattern.find('}', i + 1);
+				if (end == string::npos) {
+					return StringList();
+				}
+
+				i = end;
+				break;
+			}
+			case '.':
+			case '^':
+			case '$':
+			case '+': {
+				endRun();
+				break;
+			}
+			default: {
+				if (groupDepth > 0) {
+					break;
+				}
+
+				if (static_cast<uint8_t>(c) >= 0x80) {
+					// Avoid splitting multibyte characters
+					endRun();
+				} else {
+					run += c;
+				}
+			}
+		}
+	}
+
+	endRun();
+	return ret;
+}
+
+
+#ifdef _DEBUG
+void AutoSearchMatcher::testRegexLiterals() noexcept {
+	dcassert(getRegexLiterals("abc") == StringList({ "abc" }));
+	dcassert(getRegexLiterals("Abc.*Def") == StringList({ "abc", "def" }));
+	dcassert(getRegexLiterals("ab|cd").empty());
+
+	// Quantified characters and their bounds aren't required
+	dcassert(getRegexLiterals("abcx{10}def") == StringList({ "abc", "def" }));
+	dcassert(getRegexLiterals("season\\d{2,}xyz") == StringList({ "season", "xyz" }));
+	dcassert(getRegexLiterals("ab{0,3}") == StringList());
+	dcassert(getRegexLiterals("abc{2") == StringList());
+
+	// Classes and groups
+	dcassert(getRegexLiterals("foo[a-z]+bar") == StringList({ "foo", "bar" }));
+	dcassert(getRegexLiterals("foo(bar)?baz") == StringList({ "foo", "baz" }));
+}
+#endif
+
+}
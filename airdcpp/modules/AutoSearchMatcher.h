@@ -0,0 +1,83 @@
+/*
+* Copyright (C) 2011-2024 AirDC++ Project
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#ifndef DCPLUSPLUS_DCPP_AUTOSEARCH_MATCHER_H
+#define DCPLUSPLUS_DCPP_AUTOSEARCH_MATCHER_H
+
+#include <airdcpp/forward.h>
+
+#include "AutoSearch.h"
+
+#include <airdcpp/core/thread/CriticalSection.h>
+#include <airdcpp/util/text/AhoCorasick.h>
+
+namespace dcpp {
+
+// Finds the auto searches that may match a search result
+//
+// The literals that are required by the item patterns (partial match words, exact strings, wildcard fragments
+// and literal runs of regular expressions) are compiled into a single automaton so that the candidates are found
+// with one pass over the result path. Items without any usable literals are always returned as candidates.
+// The candidates must still be matched normally.
+class AutoSearchMatcher {
+public:
+	// Must be called when items are added or removed (pattern changes are detected automatically)
+	void setDirty() noexcept;
+
+	// The item map must not be modified during the call
+	AutoSearchList getCandidates(const SearchResultPtr& aResult, const AutoSearchMap& aItems) noexcept;
+
+	// Returns the literals that must appear in the (lowercase) matched string for the pattern to match
+	// Returns an empty list if no literals can be extracted
+	static StringList getRequiredLiterals(const string& aPattern, StringMatch::Method aMethod) noexcept;
+
+#ifdef _DEBUG
+	static void testRegexLiterals() noexcept;
+#endif
+private:
+	struct Entry {
+		AutoSearchPtr item;
+		uint32_t requiredPatterns = 0;
+	};
+
+	using EntryIndex = uint32_t;
+
+	bool isCurrent() const noexcept;
+	void rebuild(const AutoSearchMap& aItems) noexcept;
+	AutoSearchList matchUnsafe(const SearchResultPtr& aResult) const noexcept;
+
+	static StringList getRegexLiterals(const string& aPattern) noexcept;
+
+	mutable SharedMutex cs;
+
+	AhoCorasick automaton;
+	vector<Entry> entries;
+
+	// Entries requiring each pattern of the automaton
+	vector<vector<EntryIndex>> patternEntries;
+
+	// Entries that can't be filtered by their literals
+	vector<EntryIndex> unfilteredEntries;
+
+	bool dirty = true;
+	uint32_t patternRevision = 0;
+};
+
+}
+
+#endif
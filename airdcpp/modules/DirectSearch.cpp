@@ -27,11 +27,11 @@
 
 namespace dcpp {
 	DirectSearch::DirectSearch(const HintedUser& aUser, const SearchPtr& aSearch, uint64_t aNoResultTimeout) : noResultTimeout(aNoResultTimeout) {
-		ClientManager::getInstance()->addListener(this);
-		SearchManager::getInstance()->addListener(this);
-
 		searchToken = aSearch->token;
 
+		ClientManager::getInstance()->addListener(this);
+		SearchManager::getInstance()->addResultReceiver(searchToken, this);
+
 		maxResultCount = aSearch->maxResults;
 
 		string error;
@@ -42,11 +42,7 @@ namespace dcpp {
 		removeListeners();
 	}
 
-	void DirectSearch::on(SearchManagerListener::SR, const SearchResultPtr& aSR) noexcept {
-		if (compare(aSR->getSearchToken(), searchToken) != 0) {
-			return;
-		}
-
+	void DirectSearch::onSearchResult(const SearchResultPtr& aSR) noexcept {
 		lastResult = GET_TICK();
 
 		results.push_back(aSR);
@@ -100,6 +96,6 @@ namespace dcpp {
 
 	void DirectSearch::removeListeners() noexcept {
 		ClientManager::getInstance()->removeListener(this);
-		SearchManager::getInstance()->removeListener(this);
+		SearchManager::getInstance()->removeResultReceiver(searchToken, this);
 	}
 } // namespace dcpp
@@ -22,7 +22,7 @@
 #include <airdcpp/forward.h>
 
 #include <airdcpp/hub/ClientManagerListener.h>
-#include <airdcpp/search/SearchManagerListener.h>
+#include <airdcpp/search/SearchResultReceiver.h>
 
 #include <airdcpp/core/types/GetSet.h>
 #include <airdcpp/search/SearchResult.h>
@@ -30,7 +30,7 @@
 
 namespace dcpp {
 
-	class DirectSearch : private SearchManagerListener,
+	class DirectSearch : private SearchResultReceiver,
 		private ClientManagerListener
 	{
 	public:
@@ -52,7 +52,7 @@ namespace dcpp {
 			return timedOut;
 		}
 	private:
-		void on(SearchManagerListener::SR, const SearchResultPtr& aSR) noexcept override;
+		void onSearchResult(const SearchResultPtr& aSR) noexcept override;
 
 		// ClientManagerListener
 		void on(ClientManagerListener::DirectSearchEnd, const string& aToken, int aResultCount) noexcept override;
@@ -146,7 +146,7 @@ void DirectoryListingSearch::searchRecursive(const DirectoryListing::DirectoryPt
 	}
 
 	for (const auto& f: aDir->files) {
-		if (aStrings.matchesFile(f->getName(), f->getSize(), f->getRemoteDate(), f->getTTH())) {
+		if (aStrings.matchesFile(string(f->getName()), f->getSize(), f->getRemoteDate(), f->getTTH())) {
 			aResults.insert(aDir->getAdcPathUnsafe());
 			break;
 		}
@@ -165,7 +165,6 @@ void Bundle::addFinishedSegment(int64_t aSize) noexcept {
 	dcassert(currentDownloaded >= 0);
 	dcassert(currentDownloaded <= size);
 	dcassert(finishedSegments <= size);
-	setDirty();
 }
 
 void Bundle::removeFinishedSegment(int64_t aSize) noexcept{
@@ -218,9 +217,14 @@ string Bundle::getXmlFilePath() const noexcept {
 	return AppUtil::getPath(AppUtil::PATH_BUNDLES) + "Bundle" + getStringToken() + ".xml";
 }
 
+string Bundle::getJournalFilePath() const noexcept {
+	return getXmlFilePath() + ".journal";
+}
+
 void Bundle::deleteXmlFile() noexcept {
 	try {
 		File::deleteFile(getXmlFilePath() + ".bak");
+		File::deleteFile(getJournalFilePath());
 		File::deleteFile(getXmlFilePath());
 	} catch(const FileException& /*e1*/) {
 		//..
@@ -246,6 +250,7 @@ void Bundle::addFinishedItem(const QueueItemPtr& qi, bool aFinished) noexcept {
 	dcassert(qi->isDownloaded() && qi->getTimeFinished() > 0);
 
 	finishedFiles.push_back(qi);
+	setDirty();
 	if (!aFinished) {
 		increaseSize(qi->getSize());
 		addFinishedSegment(qi->getSize());
@@ -278,6 +283,7 @@ void Bundle::addQueue(const QueueItemPtr& qi) noexcept {
 	queueItems.push_back(qi);
 	increaseSize(qi->getSize());
 	addFinishedSegment(qi->getDownloadedSegments());
+	setDirty();
 }
 
 void Bundle::removeQueue(const QueueItemPtr& aQI, bool aFileCompleted) noexcept {
@@ -623,6 +629,12 @@ int Bundle::countRunningUsers() const noexcept {
 
 
 void Bundle::save() {
+	{
+		// Everything is included in the snapshot
+		Lock l(journalCS);
+		pendingJournal.clear();
+	}
+
 	{
 		File ff(getXmlFilePath() + ".tmp", File::WRITE, File::CREATE | File::TRUNCATE);
 		BufferedOutputStream<false> f(&ff);
@@ -691,8 +703,93 @@ void Bundle::save() {
 
 	File::deleteFile(getXmlFilePath());
 	File::renameFile(getXmlFilePath() + ".tmp", getXmlFilePath());
-	
+	File::deleteFile(getJournalFilePath());
+
+	journalSize = 0;
 	dirty = false;
 }
 
+void Bundle::saveJournal() {
+	string entries;
+
+	{
+		Lock l(journalCS);
+		entries.swap(pendingJournal);
+	}
+
+	if (entries.empty()) {
+		return;
+	}
+
+	if (journalSize + static_cast<int64_t>(entries.size()) > MAX_JOURNAL_SIZE) {
+		// Compact
+		save();
+		return;
+	}
+
+	try {
+		File f(getJournalFilePath(), File::WRITE, File::OPEN | File::CREATE);
+		f.setEndPos(0);
+		f.write(entries);
+	} catch (const FileException&) {
+		// The entries are lost, write a full snapshot next time
+		setDirty();
+		throw;
+	}
+
+	journalSize += static_cast<int64_t>(entries.size());
+}
+
+bool Bundle::hasJournalEntries() const noexcept {
+	Lock l(journalCS);
+	return !pendingJournal.empty();
+}
+
+void Bundle::addJournalEntry(const string& aEntry) noexcept {
+	if (status == STATUS_NEW) {
+		// Not saved yet
+		return;
+	}
+
+	Lock l(journalCS);
+	pendingJournal += aEntry;
+}
+
+void Bundle::addJournalSegment(const string& aTarget, const Segment& aSegment) noexcept {
+	string tmp;
+	addJournalEntry(
+		"<Segment Target=\"" + SimpleXML::escape(aTarget, tmp, true) +
+		"\" Start=\"" + Util::toString(aSegment.getStart()) +
+		"\" Size=\"" + Util::toString(aSegment.getSize()) + "\"/>\r\n"
+	);
+}
+
+void Bundle::addJournalSource(const string& aTarget, const HintedUser& aUser, const string& aNick) noexcept {
+	string tmp, tmp2;
+	addJournalEntry(
+		"<Source Target=\"" + SimpleXML::escape(aTarget, tmp, true) +
+		"\" CID=\"" + aUser.user->getCID().toBase32() +
+		"\" Nick=\"" + SimpleXML::escape(aNick, tmp2, true) +
+		"\" HubHint=\"" + aUser.hint + "\"/>\r\n"
+	);
+}
+
+void Bundle::addJournalSourceRemoval(const string& aTarget, const UserPtr& aUser, Flags::MaskType aReason) noexcept {
+	string tmp;
+	addJournalEntry(
+		"<RemoveSource Target=\"" + SimpleXML::escape(aTarget, tmp, true) +
+		"\" CID=\"" + aUser->getCID().toBase32() +
+		"\" Reason=\"" + Util::toString(aReason) + "\"/>\r\n"
+	);
+}
+
+void Bundle::addJournalPriority(const string& aTarget, Priority aPriority, bool aAutoPriority) noexcept {
+	string tmp;
+	addJournalEntry(
+		"<Priority Target=\"" + SimpleXML::escape(aTarget, tmp, true) +
+		"\" Priority=\"" + Util::toString(static_cast<int>(aPriority)) +
+		"\" AutoPriority=\"" + Util::toString(aAutoPriority) + "\"/>\r\n"
+	);
+}
+
 }
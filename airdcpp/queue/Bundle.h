@@ -22,6 +22,7 @@
 #include <string>
 #include <set>
 
+#include <airdcpp/core/thread/CriticalSection.h>
 #include <airdcpp/user/HintedUser.h>
 #include <airdcpp/hash/value/MerkleTree.h>
 #include <airdcpp/user/User.h>
@@ -33,6 +34,8 @@ namespace dcpp {
 
 using std::string;
 
+class Segment;
+
 #define DIR_BUNDLE_VERSION "2"
 #define FILE_BUNDLE_VERSION "2"
 
@@ -146,6 +149,7 @@ public:
 	string getName() const noexcept;
 
 	string getXmlFilePath() const noexcept;
+	string getJournalFilePath() const noexcept;
 	void deleteXmlFile() noexcept;
 
 	void setDirty() noexcept;
@@ -159,9 +163,27 @@ public:
 
 	bool allowAutoSearch() const noexcept;
 
+	// Writes a full snapshot of the bundle and removes the journal
 	// Throws on errors
 	void save();
 
+	/* Journal */
+
+	// The journal is compacted into a new snapshot after it has grown over this size
+	static const int64_t MAX_JOURNAL_SIZE = 256 * 1024;
+
+	// Appends the pending changes in the journal file
+	// Throws on errors
+	void saveJournal();
+	bool hasJournalEntries() const noexcept;
+
+	// Incremental changes that don't require rewriting the whole bundle XML
+	// The entries are discarded if the bundle hasn't been saved yet
+	void addJournalSegment(const string& aTarget, const Segment& aSegment) noexcept;
+	void addJournalSource(const string& aTarget, const HintedUser& aUser, const string& aNick) noexcept;
+	void addJournalSourceRemoval(const string& aTarget, const UserPtr& aUser, Flags::MaskType aReason) noexcept;
+	void addJournalPriority(const string& aTarget, Priority aPriority, bool aAutoPriority) noexcept;
+
 	void addQueue(const QueueItemPtr& qi) noexcept;
 	void removeQueue(const QueueItemPtr& qi, bool aFinished) noexcept;
 
@@ -236,6 +258,15 @@ private:
 	bool dirty = false;
 	bool recent = false;
 
+	void addJournalEntry(const string& aEntry) noexcept;
+
+	// Serialized journal entries that haven't been written yet
+	mutable CriticalSection journalCS;
+	string pendingJournal;
+
+	// Bytes appended in the journal file after the last snapshot
+	int64_t journalSize = 0;
+
 	/** QueueItems by priority and user (this is where the download order is determined) */
 	unordered_map<UserPtr, deque<QueueItemPtr>, User::Hash> userQueue[static_cast<int>(Priority::LAST)];
 	/** Currently running downloads, a QueueItem is always either here or in the userQueue */
@@ -444,12 +444,14 @@ void BundleQueue::removeBundle(const BundlePtr& aBundle) noexcept{
 
 void BundleQueue::saveQueue(bool aForce) noexcept {
 	for (const auto& b: bundles | views::values) {
-		if (b->getDirty() || aForce) {
-			try {
+		try {
+			if (b->getDirty() || aForce) {
 				b->save();
-			} catch(FileException& e) {
-				LogManager::getInstance()->message(STRING_F(SAVE_FAILED_X, b->getName() % e.getError()), LogMessage::SEV_ERROR, STRING(SETTINGS));
+			} else if (b->hasJournalEntries()) {
+				b->saveJournal();
 			}
+		} catch(FileException& e) {
+			LogManager::getInstance()->message(STRING_F(SAVE_FAILED_X, b->getName() % e.getError()), LogMessage::SEV_ERROR, STRING(SETTINGS));
 		}
 	}
 }
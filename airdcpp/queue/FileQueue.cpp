@@ -22,6 +22,7 @@
 #include <airdcpp/settings/SettingsManager.h>
 #include <airdcpp/util/text/Text.h>
 #include <airdcpp/core/timer/TimerManager.h>
+#include <airdcpp/core/thread/concurrency.h>
 
 namespace dcpp {
 
@@ -55,12 +56,8 @@ void FileQueue::remove(const QueueItemPtr& qi) noexcept {
 	}
 
 	//TTHIndex
-	auto s = tthIndex.equal_range(const_cast<TTHValue*>(&qi->getTTH()));
-	dcassert(s.first != s.second);
-
-	auto k = ranges::find(s | pair_to_range | views::values, qi);
-	if (k.base() != s.second) {
-		tthIndex.erase(k.base());
+	if (!tthIndex.erase(qi->getTTH(), qi)) {
+		dcassert(0);
 	}
 
 	// Tokens
@@ -78,27 +75,78 @@ QueueItemPtr FileQueue::findFile(QueueToken aToken) const noexcept {
 }
 
 void FileQueue::findFiles(const TTHValue& tth, QueueItemList& ql_) const noexcept {
-	ranges::copy(tthIndex.equal_range(const_cast<TTHValue*>(&tth)) | pair_to_range | views::values, back_inserter(ql_));
+	ranges::copy(tthIndex.findAll(tth), back_inserter(ql_));
 }
 
-void FileQueue::matchListing(const DirectoryListing& dl, QueueItemList& ql_) const noexcept {
-	matchDir(dl.getRoot(), ql_);
+FileQueue::ListingFileList FileQueue::getListingFiles(const DirectoryListing& aList) noexcept {
+	const auto& root = *aList.getRoot();
+
+	vector<const DirectoryListing::Directory*> topDirs;
+	for (const auto& d: root.directories | views::values) {
+		if (!d->isVirtual()) {
+			topDirs.push_back(d.get());
+		}
+	}
+
+	vector<ListingFileList> dirFiles(topDirs.size());
+
+	vector<size_t> indexes(topDirs.size());
+	iota(indexes.begin(), indexes.end(), 0);
+
+	parallel_for_each(indexes.begin(), indexes.end(), [&](size_t aIndex) {
+		auto& files = dirFiles[aIndex];
+		getListingFiles(*topDirs[aIndex], files);
+
+		ranges::sort(files);
+		files.erase(ranges::unique(files).begin(), files.end());
+	});
+
+	ListingFileList ret;
+	for (const auto& f: root.files) {
+		ret.emplace_back(f->getTTH(), f->getSize());
+	}
+
+	for (const auto& files: dirFiles) {
+		ret.insert(ret.end(), files.begin(), files.end());
+	}
+
+	ranges::sort(ret);
+	ret.erase(ranges::unique(ret).begin(), ret.end());
+	return ret;
 }
 
-void FileQueue::matchDir(const DirectoryListing::Directory::Ptr& aDir, QueueItemList& ql_) const noexcept {
-	for (const auto& d : aDir->directories | views::values) {
+void FileQueue::getListingFiles(const DirectoryListing::Directory& aDir, ListingFileList& files_) noexcept {
+	for (const auto& d: aDir.directories | views::values) {
 		if (!d->isVirtual()) {
-			matchDir(d, ql_);
+			getListingFiles(*d, files_);
 		}
 	}
 
-	for (const auto& f : aDir->files) {
-		auto tthRange = tthIndex.equal_range(const_cast<TTHValue*>(&f->getTTH()));
+	for (const auto& f: aDir.files) {
+		files_.emplace_back(f->getTTH(), f->getSize());
+	}
+}
 
-		ranges::for_each(tthRange | pair_to_range, [&](const pair<TTHValue*, QueueItemPtr>& tqp) {
-			if (!tqp.second->isDownloaded() && tqp.second->getSize() == f->getSize() && ranges::find(ql_, tqp.second) == ql_.end()) {
-				ql_.push_back(tqp.second);
+void FileQueue::matchListing(const ListingFileList& aFiles, QueueItemList& ql_) const noexcept {
+	unordered_set<const QueueItem*> added;
+	auto addItem = [&](const QueueItemPtr& aQI, int64_t aSize) {
+		if (!aQI->isDownloaded() && aQI->getSize() == aSize && added.insert(aQI.get()).second) {
+			ql_.push_back(aQI);
+		}
+	};
+
+	if (tthIndex.size() < aFiles.size()) {
+		// Look up the queued files from the listing
+		for (const auto& [tth, qi]: tthIndex) {
+			auto i = ranges::lower_bound(aFiles, *tth, std::less<>(), &ListingFile::first);
+			for (; i != aFiles.end() && i->first == *tth; ++i) {
+				addItem(qi, i->second);
 			}
+		}
+	} else {
+		// Look up the listing files from the queue (batched so that the index slots get prefetched)
+		tthIndex.findBatch(aFiles.size(), [&](size_t i) -> const TTHValue& { return aFiles[i].first; }, [&](size_t i, const QueueItemPtr& aQI) {
+			addItem(aQI, aFiles[i].second);
 		});
 	}
 }
@@ -111,8 +159,8 @@ DupeType FileQueue::isFileQueued(const TTHValue& aTTH) const noexcept {
 }
 
 QueueItemPtr FileQueue::getQueuedFile(const TTHValue& aTTH) const noexcept {
-	auto p = tthIndex.find(const_cast<TTHValue*>(&aTTH));
-	return p != tthIndex.end() ? p->second : nullptr;
+	auto p = tthIndex.find(aTTH);
+	return p ? *p : nullptr;
 }
 
 } //dcpp
@@ -45,8 +45,17 @@ public:
 	QueueItemPtr findFile(QueueToken aToken) const noexcept;
 
 	void findFiles(const TTHValue& tth, QueueItemList& ql_) const noexcept;
-	void matchListing(const DirectoryListing& dl, QueueItemList& ql_) const noexcept;
-	void matchDir(const DirectoryListing::Directory::Ptr& dir, QueueItemList& ql_) const noexcept;
+
+	// TTH and size of a listing file
+	using ListingFile = pair<TTHValue, int64_t>;
+	using ListingFileList = vector<ListingFile>;
+
+	// Returns the unique files of a listing sorted by TTH (top-level directories are collected in parallel)
+	// Doesn't access the queue
+	static ListingFileList getListingFiles(const DirectoryListing& aList) noexcept;
+
+	// Adds the unfinished items matching the listing files (each item is added once)
+	void matchListing(const ListingFileList& aFiles, QueueItemList& ql_) const noexcept;
 
 	size_t getSize() noexcept { return pathQueue.size(); }
 	QueueItem::StringMap& getPathQueue() noexcept { return pathQueue; }
@@ -61,6 +70,8 @@ private:
 	QueueItem::StringMap pathQueue;
 	QueueItem::TTHMap tthIndex;
 	QueueItem::TokenMap tokenQueue;
+
+	static void getListingFiles(const DirectoryListing::Directory& aDir, ListingFileList& files_) noexcept;
 };
 
 } // namespace dcpp
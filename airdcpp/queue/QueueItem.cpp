@@ -573,6 +573,7 @@ void QueueItem::addFinishedSegment(const Segment& aSegment) noexcept {
 #endif
 
 	dcassert(aSegment.getOverlapped() == false);
+	auto firstSegment = done.empty();
 	done.insert(aSegment);
 
 	// Consolidate segments
@@ -604,6 +605,15 @@ void QueueItem::addFinishedSegment(const Segment& aSegment) noexcept {
 		dcdebug("added " I64_FMT " for the bundle (no merging)\n", aSegment.getSize());
 		bundle->addFinishedSegment(aSegment.getSize());
 	}
+
+	if (bundle) {
+		if (firstSegment) {
+			// The temp target must be saved as well
+			bundle->setDirty();
+		} else {
+			bundle->addJournalSegment(target, aSegment);
+		}
+	}
 }
 
 bool QueueItem::isNeededPart(const PartsInfo& aPartsInfo, int64_t aBlockSize) const noexcept {
@@ -945,6 +955,7 @@ string QueueItem::Source::formatError(const Flags& aFlags) noexcept {
 void QueueItem::resetDownloaded() noexcept {
 	if (bundle) {
 		bundle->removeFinishedSegment(getDownloadedSegments());
+		bundle->setDirty();
 	}
 
 	done.clear();
@@ -26,6 +26,7 @@
 #include <airdcpp/core/classes/IncrementingIdCounter.h>
 #include <airdcpp/user/HintedUser.h>
 #include <airdcpp/hash/value/MerkleTree.h>
+#include <airdcpp/hash/value/TTHIndex.h>
 #include <airdcpp/core/classes/Segment.h>
 #include <airdcpp/util/Util.h>
 
@@ -35,7 +36,7 @@ class QueueItem : public QueueItemBase {
 public:
 	using TokenMap = unordered_map<QueueToken, QueueItemPtr>;
 	using StringMap = unordered_map<string *, QueueItemPtr, noCaseStringHash, noCaseStringEq>;
-	using TTHMap = unordered_multimap<TTHValue *, QueueItemPtr>;
+	using TTHMap = TTHIndex<QueueItemPtr>;
 	using ItemBoolList = vector<pair<QueueItemPtr, bool>>;
 
 	struct HashComp {
@@ -279,6 +280,7 @@ public:
 private:
 	friend class QueueManager;
 	friend class UserQueue;
+	friend class QueueLoader;
 	SourceList sources;
 	SourceList badSources;
 	string tempTarget;
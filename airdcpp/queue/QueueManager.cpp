@@ -42,7 +42,9 @@
 #include <airdcpp/core/io/SFVReader.h>
 #include <airdcpp/share/ShareManager.h>
 #include <airdcpp/core/io/xml/SimpleXMLReader.h>
+#include <airdcpp/core/io/stream/SegmentOutputStream.h>
 #include <airdcpp/core/io/stream/Streams.h>
+#include <airdcpp/core/timer/Tracer.h>
 #include <airdcpp/util/SystemUtil.h>
 #include <airdcpp/transfer/Transfer.h>
 #include <airdcpp/transfer/upload/UploadManager.h>
@@ -119,6 +121,123 @@ void QueueManager::shutdown() noexcept {
 	}
 }
 
+namespace {
+
+// Size of the block aligned file ranges that are hashed concurrently during rechecks
+const int64_t RECHECK_RANGE_SIZE = 64 * 1024 * 1024;
+const size_t RECHECK_READ_SIZE = 1024 * 1024;
+
+// Maximum number of concurrent reads from the same storage device during rechecks (files and their ranges combined)
+const size_t RECHECK_READERS_PER_DEVICE = 4;
+
+struct RecheckHashResult {
+	TigerTree tree;
+	uint32_t crc32 = 0;
+};
+
+// Calculates the tree (and optionally the CRC32 checksum) for a file by hashing its ranges with up to aMaxReaders concurrent reads
+// Throws FileException
+RecheckHashResult calculateRecheckHash(const string& aPath, int64_t aFileSize, int64_t aBlockSize, size_t aMaxReaders) {
+	struct RangeResult {
+		TigerTree::MerkleList leaves;
+		uint32_t crc32 = 0;
+		int64_t size = 0;
+	};
+
+	if (aFileSize == 0) {
+		RecheckHashResult ret { TigerTree(aBlockSize) };
+		ret.tree.finalize();
+		return ret;
+	}
+
+	// Leaves of a block aligned range are identical to the respective leaves of the full tree
+	auto rangeSize = max(aBlockSize, RECHECK_RANGE_SIZE - RECHECK_RANGE_SIZE % aBlockSize);
+	auto rangeCount = static_cast<size_t>((aFileSize + rangeSize - 1) / rangeSize);
+
+	vector<RangeResult> results(rangeCount);
+
+	// Each reader hashes every readerCount'th range
+	auto readerCount = min(aMaxReaders, rangeCount);
+	vector<size_t> readers(readerCount);
+	iota(readers.begin(), readers.end(), 0);
+
+	File f(aPath, File::READ, File::OPEN | File::SHARED_WRITE, File::BUFFER_SEQUENTIAL);
+
+	CriticalSection errorCS;
+	optional<string> error;
+
+	auto hashRange = [&](size_t aIndex) {
+		auto start = static_cast<int64_t>(aIndex) * rangeSize;
+		auto end = min(start + rangeSize, aFileSize);
+
+		TigerTree tt(aBlockSize);
+		CRC32Filter crc32;
+		ByteVector buf(static_cast<size_t>(min(static_cast<int64_t>(RECHECK_READ_SIZE), end - start)));
+
+		try {
+			for (auto pos = start; pos < end;) {
+				auto len = static_cast<size_t>(min(static_cast<int64_t>(buf.size()), end - pos));
+
+				// Fill the whole buffer, tree updates must be made in full base blocks
+				size_t bytesRead = 0;
+				while (bytesRead < len) {
+					auto n = f.readAt(&buf[bytesRead], len - bytesRead, pos + static_cast<int64_t>(bytesRead));
+					if (n == 0) {
+						throw FileException(STRING(SIZE_MISMATCH));
+					}
+
+					bytesRead += n;
+				}
+
+				tt.update(&buf[0], len);
+				crc32(&buf[0], len);
+				pos += static_cast<int64_t>(len);
+			}
+		} catch (const FileException& e) {
+			Lock l(errorCS);
+			error = e.getError();
+			return false;
+		}
+
+		tt.finalize();
+
+		auto& result = results[aIndex];
+		result.leaves = std::move(tt.getLeaves());
+		result.crc32 = crc32.getValue();
+		result.size = end - start;
+		return true;
+	};
+
+	parallel_for_each(readers.begin(), readers.end(), [&](size_t aReader) {
+		for (auto i = aReader; i < rangeCount; i += readerCount) {
+			if (!hashRange(i)) {
+				return;
+			}
+		}
+	});
+
+	if (error) {
+		throw FileException(*error);
+	}
+
+	RecheckHashResult ret;
+
+	ByteVector leafData;
+	leafData.reserve(TigerTree::calcBlocks(aFileSize, aBlockSize) * TTHValue::BYTES);
+	for (const auto& result: results) {
+		for (const auto& leaf: result.leaves) {
+			leafData.insert(leafData.end(), leaf.data, leaf.data + TTHValue::BYTES);
+		}
+
+		ret.crc32 = CRC32Filter::combine(ret.crc32, result.crc32, result.size);
+	}
+
+	ret.tree = TigerTree(aFileSize, aBlockSize, leafData.data());
+	return ret;
+}
+
+}
+
 void QueueManager::recheckBundle(QueueToken aBundleToken) noexcept {
 	QueueItemList ql;
 	BundlePtr b;
@@ -151,19 +270,13 @@ void QueueManager::recheckBundle(QueueToken aBundleToken) noexcept {
 	auto oldStatus = b->getStatus();
 
 	setBundlePriority(b, Priority::PAUSED_FORCE);
-	Thread::sleep(1000);
+	waitRecheckDownloads(ql);
 
 	setBundleStatus(b, Bundle::STATUS_RECHECK);
 
 	// check the files
 	int64_t failedBytes = 0;
-	
-	QueueItemList failedItems;
-	for (const auto& q : ql) {
-		if (recheckFileImpl(q->getTarget(), true, failedBytes)) {
-			failedItems.push_back(q);
-		}
-	}
+	auto failedItems = recheckFilesImpl(ql, true, failedBytes);
 
 	// finish
 	log(STRING_F(INTEGRITY_CHECK_FINISHED_BUNDLE, b->getName() %
@@ -177,31 +290,87 @@ void QueueManager::recheckBundle(QueueToken aBundleToken) noexcept {
 void QueueManager::recheckFiles(const QueueItemList& aQL) noexcept {
 	log(STRING_F(INTEGRITY_CHECK_START_FILES, aQL.size()), LogMessage::SEV_INFO);
 
-	QueueItemList failedItems;
-	int64_t failedBytes = 0;
+	vector<pair<QueueItemPtr, Priority>> oldPrios;
 	for (const auto& q : aQL) {
-		bool running;
+		oldPrios.emplace_back(q, q->getPriority());
+		setQIPriority(q, Priority::PAUSED_FORCE);
+	}
+
+	waitRecheckDownloads(aQL);
 
+	int64_t failedBytes = 0;
+	auto failedItems = recheckFilesImpl(aQL, false, failedBytes);
+
+	for (const auto& [q, prio] : oldPrios) {
+		setQIPriority(q, prio);
+	}
+
+	handleFailedRecheckItems(failedItems);
+	log(STRING_F(INTEGRITY_CHECK_FINISHED_FILES, Util::formatBytes(failedBytes)), LogMessage::SEV_INFO);
+}
+
+void QueueManager::waitRecheckDownloads(const QueueItemList& aItems) const noexcept {
+	// Paused downloads are disconnected asynchronously
+	for (int i = 0; i < 20; ++i) {
 		{
 			RLock l(cs);
-			running = q->isRunning();
+			if (ranges::none_of(aItems, [](const QueueItemPtr& q) { return q->isRunning(); })) {
+				return;
+			}
 		}
 
-		auto oldPrio = q->getPriority();
-		setQIPriority(q, Priority::PAUSED_FORCE);
-		if (running) {
-			Thread::sleep(1000);
-		}
+		Thread::sleep(100);
+	}
+}
+
+QueueItemList QueueManager::recheckFilesImpl(const QueueItemList& aItems, bool aIsBundleCheck, int64_t& failedBytes_) noexcept {
+	// Split the files in lanes that are checked concurrently
+	// Limit the number of concurrent reads from the same storage device to avoid seeking
+	struct RecheckLane {
+		QueueItemList items;
+		size_t readers = 1;
+	};
 
-		if (recheckFileImpl(q->getTarget(), false, failedBytes)) {
-			failedItems.push_back(q);
+	unordered_map<int64_t, QueueItemList> deviceItems;
+	for (const auto& q : aItems) {
+		auto deviceId = File::getDeviceId(q->getTarget());
+		if (deviceId == -1) {
+			deviceId = File::getDeviceId(q->getTempTarget());
 		}
 
-		setQIPriority(q, oldPrio);
+		deviceItems[deviceId].push_back(q);
 	}
 
-	handleFailedRecheckItems(failedItems);
-	log(STRING_F(INTEGRITY_CHECK_FINISHED_FILES, Util::formatBytes(failedBytes)), LogMessage::SEV_INFO);
+	vector<RecheckLane> lanes;
+	for (const auto& items : deviceItems | views::values) {
+		// The ranges of a file are read concurrently when there are fewer files than readers
+		auto laneCount = min(RECHECK_READERS_PER_DEVICE, items.size());
+		auto firstLane = lanes.size();
+		lanes.resize(firstLane + laneCount, RecheckLane { {}, RECHECK_READERS_PER_DEVICE / laneCount });
+		for (size_t i = 0; i < items.size(); ++i) {
+			lanes[firstLane + i % laneCount].items.push_back(items[i]);
+		}
+	}
+
+	CriticalSection resultCS;
+	QueueItemList failedItems;
+	int64_t failedBytes = 0;
+
+	parallel_for_each(lanes.begin(), lanes.end(), [&](const RecheckLane& aLane) {
+		for (const auto& q : aLane.items) {
+			int64_t laneFailedBytes = 0;
+			auto failed = recheckFileImpl(q->getTarget(), aIsBundleCheck, aLane.readers, laneFailedBytes);
+
+			Lock l(resultCS);
+			failedBytes += laneFailedBytes;
+			if (failed) {
+				failedItems.push_back(q);
+			}
+		}
+	});
+
+	failedBytes_ += failedBytes;
+	return failedItems;
 }
 
 void QueueManager::handleFailedRecheckItems(const QueueItemList& ql) noexcept {
@@ -232,7 +401,7 @@ void QueueManager::handleFailedRecheckItems(const QueueItemList& ql) noexcept {
 	fire(QueueManagerListener::BundleStatusChanged(), b);
 }
 
-bool QueueManager::recheckFileImpl(const string& aPath, bool isBundleCheck, int64_t& failedBytes_) noexcept{
+bool QueueManager::recheckFileImpl(const string& aPath, bool isBundleCheck, size_t aMaxReaders, int64_t& failedBytes_) noexcept{
 	QueueItemPtr q;
 	int64_t tempSize;
 	TTHValue tth;
@@ -318,17 +487,12 @@ bool QueueManager::recheckFileImpl(const string& aPath, bool isBundleCheck, int6
 		q->resetDownloaded();
 	}
 
-	TigerTree ttFile(tt.getBlockSize());
 	DirSFVReader sfv(q->getFilePath());
 	auto fileCRC = sfv.hasFile(Text::toLower(q->getTargetFileName()));
-	CRC32Filter crc32;
 
+	RecheckHashResult hashResult;
 	try {
-		FileReader(FileReader::ASYNC).read(checkTarget, [&](const void* x, size_t n) {
-			if (fileCRC)
-				crc32(x, n);
-			return ttFile.update(x, n), true;
-		});
+		hashResult = calculateRecheckHash(checkTarget, q->getSize(), tt.getBlockSize(), aMaxReaders);
 	} catch (const FileException & e) {
 		dcdebug("Error while reading file: %s\n", e.what());
 		failFile(e.getError());
@@ -344,30 +508,38 @@ bool QueueManager::recheckFileImpl(const string& aPath, bool isBundleCheck, int6
 	if (!q)
 		return false;
 
-	ttFile.finalize();
+	const auto& ttFile = hashResult.tree;
 
+	// Merge the verified blocks before locking
+	vector<Segment> verifiedSegments;
 	int64_t pos = 0, failedBytes = 0;
+	boost::for_each(tt.getLeaves(), ttFile.getLeaves(), [&](const TTHValue& our, const TTHValue& file) {
+		// avoid going over the file size (would happen especially with finished items)
+		auto blockSegment = Segment(pos, min(q->getSize() - pos, tt.getBlockSize()));
+
+		if (our == file) {
+			if (!verifiedSegments.empty() && verifiedSegments.back().getEnd() == pos) {
+				auto& prev = verifiedSegments.back();
+				prev = Segment(prev.getStart(), prev.getSize() + blockSegment.getSize());
+			} else {
+				verifiedSegments.push_back(blockSegment);
+			}
+		} else if (blockSegment.inSet(done)) {
+			// undownloaded segments aren't corrupted...
+			dcdebug("Integrity check failed for the block at pos " I64_FMT "\n", pos);
+			failedBytes += tt.getBlockSize();
+		}
+
+		pos += tt.getBlockSize();
+	});
+
 	bool segmentsDone = false;
 
 	{
 		WLock l(cs);
-		boost::for_each(tt.getLeaves(), ttFile.getLeaves(), [&](const TTHValue& our, const TTHValue& file) {
-			// avoid going over the file size (would happen especially with finished items)
-			auto blockSegment = Segment(pos, min(q->getSize() - pos, tt.getBlockSize()));
-
-			if (our == file) {
-				q->addFinishedSegment(blockSegment);
-			} else {
-				// undownloaded segments aren't corrupted...
-				if (!blockSegment.inSet(done))
-					return;
-
-				dcdebug("Integrity check failed for the block at pos " I64_FMT "\n", pos);
-				failedBytes += tt.getBlockSize();
-			}
-
-			pos += tt.getBlockSize();
-		});
+		for (const auto& segment : verifiedSegments) {
+			q->addFinishedSegment(segment);
+		}
 
 		segmentsDone = q->segmentsDone();
 	}
@@ -377,7 +549,7 @@ bool QueueManager::recheckFileImpl(const string& aPath, bool isBundleCheck, int6
 		log(STRING_F(INTEGRITY_CHECK,
 			STRING_F(FILE_CORRUPTION_FOUND, Util::formatBytes(failedBytes)) % q->getTarget()),
 			LogMessage::SEV_WARNING);
-	} else if (fileCRC && ttFile.getRoot() == tth && *fileCRC != crc32.getValue()) {
+	} else if (fileCRC && ttFile.getRoot() == tth && *fileCRC != hashResult.crc32) {
 		log(q->getTarget() + ": " + STRING(ERROR_HASHING_CRC32), LogMessage::SEV_ERROR);
 	}
 
@@ -1137,7 +1309,7 @@ bool QueueManager::addValidatedSource(const QueueItemPtr& qi, const HintedUser&
 #endif
 
 	if (qi->getBundle()) {
-		qi->getBundle()->setDirty();
+		qi->getBundle()->addJournalSource(qi->getTarget(), aUser, ClientManager::getInstance()->getNick(aUser, aUser.hint));
 	}
 
 	return wantConnection;
@@ -1386,11 +1558,17 @@ QueueManager::QueueMatchResults QueueManager::matchListing(const DirectoryListin
 	if (dl.getUser() == ClientManager::getInstance()->getMe())
 		return results;
 
+	static auto& matchDuration = Tracer::getHistogram(Tracer::QUEUE, "matchListing");
+	Tracer::Span span(Tracer::QUEUE, "matchListing", &matchDuration);
+
+	// Collect the listing files first to keep the locking time short
+	auto listingFiles = FileQueue::getListingFiles(dl);
+
 	QueueItemList matchingItems;
 
 	{
 		RLock l(cs);
-		fileQueue.matchListing(dl, matchingItems);
+		fileQueue.matchListing(listingFiles, matchingItems);
 	}
 
 	results.matchingFiles = static_cast<int>(matchingItems.size());
@@ -1730,6 +1908,7 @@ void QueueManager::onDownloadFailed(const QueueItemPtr& aQI, Download* aDownload
 
 			if (downloaded > 0) {
 				aQI->addFinishedSegment(Segment(aDownload->getStartPos(), downloaded));
+				SegmentOutputStream::addCommittedBytes(downloaded);
 			}
 
 			if (aRotateQueue && aQI->getBundle()) {
@@ -1844,6 +2023,7 @@ void QueueManager::onFileDownloadCompleted(const QueueItemPtr& aQI, Download* aD
 	{
 		WLock l(cs);
 		aQI->addFinishedSegment(aDownload->getSegment());
+		SegmentOutputStream::addCommittedBytes(aDownload->getSegment().getSize());
 		wholeFileCompleted = aQI->segmentsDone();
 
 		// dcdebug("Finish segment for %s (" I64_FMT ", " I64_FMT ")\n", aDownload->getToken().c_str(), aDownload->getSegment().getStart(), aDownload->getSegment().getEnd());
@@ -2040,7 +2220,7 @@ void QueueManager::removeFileSource(const QueueItemPtr& q, const UserPtr& aUser,
 	fire(QueueManagerListener::ItemSources(), q);
 
 	if (q->getBundle()) {
-		q->getBundle()->setDirty();
+		q->getBundle()->addJournalSourceRemoval(q->getTarget(), aUser, aReason);
 		fire(QueueManagerListener::BundleSources(), q->getBundle());
 	}
 endCheck:
@@ -2257,7 +2437,7 @@ void QueueManager::setQIPriority(const QueueItemPtr& q, Priority p, bool aKeepAu
 
 	fire(QueueManagerListener::ItemPriority(), q);
 
-	b->setDirty();
+	b->addJournalPriority(q->getTarget(), q->getPriority(), q->getAutoPriority());
 	if (p == Priority::PAUSED_FORCE && running) {
 		DownloadManager::getInstance()->abortDownload(q->getTarget());
 	} else if (!q->isPausedPrio()) {
@@ -2289,7 +2469,7 @@ void QueueManager::setQIAutoPriority(const string& aTarget) noexcept {
 	q->setAutoPriority(!q->getAutoPriority());
 	fire(QueueManagerListener::ItemPriority(), q);
 
-	q->getBundle()->setDirty();
+	q->getBundle()->addJournalPriority(q->getTarget(), q->getPriority(), q->getAutoPriority());
 
 	if(q->getAutoPriority()) {
 		if (SETTING(AUTOPRIO_TYPE) == SettingsManager::PRIO_PROGRESS) {
@@ -2358,20 +2538,33 @@ void QueueManager::saveQueue(bool aForce) noexcept {
 
 class QueueLoader : public SimpleXMLReader::CallBack {
 public:
+	using AttribViewList = SimpleXMLReader::AttribViewList;
+
 	QueueLoader() = default;
+	explicit QueueLoader(const string& aJournalPath) : journalPath(aJournalPath) { }
 	~QueueLoader() override = default;
-	void startTag(const string& name, StringPairList& attribs, bool simple) override;
+	void startTagView(const string& name, const AttribViewList& attribs, bool simple) override;
 	void endTag(const string& name) override;
 	void createFileBundle(QueueItemPtr& aQI, QueueToken aToken);
 
-	void loadDirectoryBundle(StringPairList& attribs, bool simple);
-	void loadFileBundle(StringPairList& attribs, bool simple);
-	void loadQueueFile(StringPairList& attribs, bool simple);
-	void loadFinishedFile(StringPairList& attribs, bool simple);
-	void loadSource(StringPairList& attribs, bool simple);
-	void loadSegment(StringPairList& attribs, bool simple);
-
-	Priority validatePrio(const string& aPrio) const;
+	void loadDirectoryBundle(const AttribViewList& attribs, bool simple);
+	void loadFileBundle(const AttribViewList& attribs, bool simple);
+	void loadQueueFile(const AttribViewList& attribs, bool simple);
+	void loadFinishedFile(const AttribViewList& attribs, bool simple);
+	void loadSource(const AttribViewList& attribs, bool simple);
+	void loadSegment(const AttribViewList& attribs, bool simple);
+	void addLoadedBundle();
+
+	// Applies the changes from the bundle journal on top of the loaded snapshot
+	// Returns true if any entries were found
+	bool loadJournal();
+	void loadJournalEntry(const string& aName, const AttribViewList& attribs);
+	void loadJournalSegment(const QueueItemPtr& aQI, const AttribViewList& attribs);
+	void loadJournalSource(const QueueItemPtr& aQI, const AttribViewList& attribs);
+	void loadJournalSourceRemoval(const QueueItemPtr& aQI, const AttribViewList& attribs);
+	void loadJournalPriority(const QueueItemPtr& aQI, const AttribViewList& attribs);
+
+	Priority validatePrio(string_view aPrio) const;
 private:
 	struct FileBundleInfo {
 		QueueToken token = 0;
@@ -2389,15 +2582,20 @@ private:
 
 	int bundleVersion = 0;
 	QueueManager* qm = QueueManager::getInstance();
+
+	const string journalPath;
+	bool inJournal = false;
+	unordered_map<string_view, QueueItemPtr> journalItems;
 };
 
 void QueueManager::loadBundleFile(const string& aXmlPath) const noexcept {
-	QueueLoader loader;
+	QueueLoader loader(aXmlPath + ".journal");
 	try {
-		File f(aXmlPath, File::READ, File::OPEN, File::BUFFER_SEQUENTIAL, false);
-		SimpleXMLReader(&loader).parse(f);
+		auto xml = File(aXmlPath, File::READ, File::OPEN, File::BUFFER_SEQUENTIAL, false).read();
+		SimpleXMLReader(&loader).parseDocument(xml);
 	} catch (const Exception& e) {
 		log(STRING_F(BUNDLE_LOAD_FAILED, aXmlPath % e.getError().c_str()), LogMessage::SEV_ERROR);
+		File::deleteFile(aXmlPath + ".journal");
 		File::deleteFile(aXmlPath);
 	}
 }
@@ -2497,8 +2695,8 @@ static const string sLastSource = "LastSource";
 static const string sAddedByAutoSearch = "AddedByAutoSearch";
 static const string sResumeTime = "ResumeTime";
 
-Priority QueueLoader::validatePrio(const string& aPrio) const {
-	int prio = Util::toInt(aPrio);
+Priority QueueLoader::validatePrio(string_view aPrio) const {
+	int prio = toInt(aPrio);
 	if (bundleVersion == 1)
 		prio++;
 
@@ -2524,26 +2722,26 @@ void QueueLoader::createFileBundle(QueueItemPtr& aQI, QueueToken aToken) {
 	}
 }
 
-void QueueLoader::loadDirectoryBundle(StringPairList& attribs, bool) {
-	bundleVersion = Util::toInt(getAttrib(attribs, sVersion, 0));
+void QueueLoader::loadDirectoryBundle(const AttribViewList& attribs, bool) {
+	bundleVersion = toInt(getAttrib(attribs, sVersion, 0));
 	if (bundleVersion == 0 || bundleVersion > Util::toInt(DIR_BUNDLE_VERSION))
 		throw Exception("Non-supported directory bundle version");
 
-	const string& bundleTarget = getAttrib(attribs, sTarget, 1);
-	const string& token = getAttrib(attribs, sToken, 2);
+	const string bundleTarget(getAttrib(attribs, sTarget, 1));
+	const string token(getAttrib(attribs, sToken, 2));
 	if (token.empty())
 		throw Exception("Missing bundle token");
 
-	auto added = Util::toTimeT(getAttrib(attribs, sAdded, 2));
-	auto dirDate = Util::toTimeT(getAttrib(attribs, sDate, 3));
-	auto b_autoSearch = Util::toBool(Util::toInt(getAttrib(attribs, sAddedByAutoSearch, 4)));
-	const string& prio = getAttrib(attribs, sPriority, 4);
+	auto added = toTimeT(getAttrib(attribs, sAdded, 2));
+	auto dirDate = toTimeT(getAttrib(attribs, sDate, 3));
+	auto b_autoSearch = Util::toBool(toInt(getAttrib(attribs, sAddedByAutoSearch, 4)));
+	auto prio = getAttrib(attribs, sPriority, 4);
 	if (added == 0) {
 		added = GET_TIME();
 	}
 
-	auto b_resumeTime = Util::toTimeT(getAttrib(attribs, sResumeTime, 5));
-	auto finished = Util::toTimeT(getAttrib(attribs, sTimeFinished, 5));
+	auto b_resumeTime = toTimeT(getAttrib(attribs, sResumeTime, 5));
+	auto finished = toTimeT(getAttrib(attribs, sTimeFinished, 5));
 
 	if (ConnectionManager::getInstance()->tokens.addToken(token, CONNECTION_TYPE_DOWNLOAD)) {
 		auto priority = !prio.empty() ? validatePrio(prio) : Priority::DEFAULT;
@@ -2559,35 +2757,35 @@ void QueueLoader::loadDirectoryBundle(StringPairList& attribs, bool) {
 }
 
 
-void QueueLoader::loadFileBundle(StringPairList& attribs, bool) {
-	bundleVersion = Util::toInt(getAttrib(attribs, sVersion, 0));
+void QueueLoader::loadFileBundle(const AttribViewList& attribs, bool) {
+	bundleVersion = toInt(getAttrib(attribs, sVersion, 0));
 	if (bundleVersion == 0 || bundleVersion > Util::toInt(FILE_BUNDLE_VERSION))
 		throw Exception("Non-supported file bundle version");
 
 	{
-		const string& token = getAttrib(attribs, sToken, 1);
+		auto token = getAttrib(attribs, sToken, 1);
 		if (token.empty())
 			throw Exception("Missing bundle token");
 
 		FileBundleInfo info;
-		info.token = Util::toUInt32(token);
-		info.date = Util::toTimeT(getAttrib(attribs, sDate, 2));
-		info.addedByAutosearch = Util::toBool(Util::toInt(getAttrib(attribs, sAddedByAutoSearch, 3)));
-		info.resumeTime = Util::toTimeT(getAttrib(attribs, sResumeTime, 4));
+		info.token = toUInt32(token);
+		info.date = toTimeT(getAttrib(attribs, sDate, 2));
+		info.addedByAutosearch = Util::toBool(toInt(getAttrib(attribs, sAddedByAutoSearch, 3)));
+		info.resumeTime = toTimeT(getAttrib(attribs, sResumeTime, 4));
 		curFileBundleInfo = std::move(info);
 	}
 
 	inFileBundle = true;
 }
 
-void QueueLoader::loadQueueFile(StringPairList& attribs, bool simple) {
-	auto size = Util::toInt64(getAttrib(attribs, sSize, 1));
+void QueueLoader::loadQueueFile(const AttribViewList& attribs, bool simple) {
+	auto size = toInt64(getAttrib(attribs, sSize, 1));
 	if (size == 0)
 		return;
 
 	string currentFileTarget;
 	try {
-		const string& tgt = getAttrib(attribs, sTarget, 0);
+		const string tgt(getAttrib(attribs, sTarget, 0));
 		// @todo do something better about existing files
 		currentFileTarget = QueueManager::checkTarget(tgt);
 		if (currentFileTarget.empty())
@@ -2601,20 +2799,20 @@ void QueueLoader::loadQueueFile(StringPairList& attribs, bool simple) {
 		return;
 	}
 
-	auto timeAdded = static_cast<time_t>(Util::toInt(getAttrib(attribs, sAdded, 2)));
+	auto timeAdded = static_cast<time_t>(toInt(getAttrib(attribs, sAdded, 2)));
 	if (timeAdded == 0)
 		timeAdded = GET_TIME();
 
-	const string& tthRoot = getAttrib(attribs, sTTH, 3);
+	const string tthRoot(getAttrib(attribs, sTTH, 3));
 	if (tthRoot.empty())
 		return;
 
 	auto p = validatePrio(getAttrib(attribs, sPriority, 4));
 
-	auto& tempTarget = getAttrib(attribs, sTempTarget, 5);
-	auto maxSegments = (uint8_t)Util::toInt(getAttrib(attribs, sMaxSegments, 5));
+	const string tempTarget(getAttrib(attribs, sTempTarget, 5));
+	auto maxSegments = (uint8_t)toInt(getAttrib(attribs, sMaxSegments, 5));
 
-	if (Util::toInt(getAttrib(attribs, sAutoPriority, 6)) == 1) {
+	if (toInt(getAttrib(attribs, sAutoPriority, 6)) == 1) {
 		p = Priority::DEFAULT;
 	}
 
@@ -2637,14 +2835,14 @@ void QueueLoader::loadQueueFile(StringPairList& attribs, bool simple) {
 		curFile = qi;
 }
 
-void QueueLoader::loadFinishedFile(StringPairList& attribs, bool) {
+void QueueLoader::loadFinishedFile(const AttribViewList& attribs, bool) {
 	//log("FOUND FINISHED TTH");
-	const string& target = getAttrib(attribs, sTarget, 0);
-	auto size = Util::toInt64(getAttrib(attribs, sSize, 1));
-	auto timeAdded = Util::toTimeT(getAttrib(attribs, sAdded, 2));
-	const string& tth = getAttrib(attribs, sTTH, 3);
-	auto finished = Util::toTimeT(getAttrib(attribs, sTimeFinished, 4));
-	const string& lastSource = getAttrib(attribs, sLastSource, 5);
+	const string target(getAttrib(attribs, sTarget, 0));
+	auto size = toInt64(getAttrib(attribs, sSize, 1));
+	auto timeAdded = toTimeT(getAttrib(attribs, sAdded, 2));
+	const string tth(getAttrib(attribs, sTTH, 3));
+	auto finished = toTimeT(getAttrib(attribs, sTimeFinished, 4));
+	const string lastSource(getAttrib(attribs, sLastSource, 5));
 
 	if (size == 0 || tth.empty() || target.empty() || timeAdded == 0)
 		return;
@@ -2669,10 +2867,10 @@ void QueueLoader::loadFinishedFile(StringPairList& attribs, bool) {
 	}
 }
 
-void QueueLoader::loadSource(StringPairList& attribs, bool) {
-	const string& cid = getAttrib(attribs, sCID, 0);
-	const string& nick = getAttrib(attribs, sNick, 1);
-	const string& hubHint = getAttrib(attribs, sHubHint, 2);
+void QueueLoader::loadSource(const AttribViewList& attribs, bool) {
+	const string cid(getAttrib(attribs, sCID, 0));
+	const string nick(getAttrib(attribs, sNick, 1));
+	const string hubHint(getAttrib(attribs, sHubHint, 2));
 
 	auto cm = ClientManager::getInstance();
 	auto user = cm->loadUser(cid, hubHint, nick);
@@ -2694,9 +2892,9 @@ void QueueLoader::loadSource(StringPairList& attribs, bool) {
 	}
 }
 
-void QueueLoader::loadSegment(StringPairList& attribs, bool) {
-	auto start = Util::toInt64(getAttrib(attribs, sStart, 0));
-	auto size = Util::toInt64(getAttrib(attribs, sSize, 1));
+void QueueLoader::loadSegment(const AttribViewList& attribs, bool) {
+	auto start = toInt64(getAttrib(attribs, sStart, 0));
+	auto size = toInt64(getAttrib(attribs, sSize, 1));
 
 	if (size > 0 && start >= 0 && (start + size) <= curFile->getSize()) {
 		curFile->addFinishedSegment(Segment(start, size));
@@ -2708,7 +2906,190 @@ void QueueLoader::loadSegment(StringPairList& attribs, bool) {
 	}
 }
 
-void QueueLoader::startTag(const string& name, StringPairList& attribs, bool simple) {
+bool QueueLoader::loadJournal() {
+	if (journalPath.empty() || !curBundle) {
+		return false;
+	}
+
+	string journal;
+	try {
+		journal = File(journalPath, File::READ, File::OPEN, File::BUFFER_SEQUENTIAL, false).read();
+	} catch (const FileException&) {
+		return false;
+	}
+
+	for (const auto& qi: curBundle->getQueueItems()) {
+		journalItems.emplace(qi->getTarget(), qi);
+	}
+
+	inJournal = true;
+	ScopedFunctor([this] {
+		inJournal = false;
+		journalItems.clear();
+	});
+
+	// Each entry is a single element on its own line
+	string_view entries(journal);
+	while (!entries.empty()) {
+		auto lineEnd = entries.find('\n');
+		if (lineEnd == string_view::npos) {
+			// Incomplete write
+			break;
+		}
+
+		auto line = entries.substr(0, lineEnd);
+		entries.remove_prefix(lineEnd + 1);
+
+		try {
+			SimpleXMLReader(this).parseDocument(line);
+		} catch (const SimpleXMLException& e) {
+			dcdebug("QueueLoader::loadJournal: invalid entry (%s)\n", e.getError().c_str());
+		}
+	}
+
+	return true;
+}
+
+static const string sRemoveSource = "RemoveSource";
+static const string sReason = "Reason";
+
+void QueueLoader::loadJournalEntry(const string& aName, const AttribViewList& attribs) {
+	auto i = journalItems.find(getAttrib(attribs, sTarget, 0));
+	if (i == journalItems.end()) {
+		// Removed or finished before the snapshot was written
+		return;
+	}
+
+	const auto& qi = i->second;
+	if (aName == sSegment) {
+		loadJournalSegment(qi, attribs);
+	} else if (aName == sSource) {
+		loadJournalSource(qi, attribs);
+	} else if (aName == sRemoveSource) {
+		loadJournalSourceRemoval(qi, attribs);
+	} else if (aName == sPriority) {
+		loadJournalPriority(qi, attribs);
+	}
+}
+
+void QueueLoader::loadJournalSegment(const QueueItemPtr& aQI, const AttribViewList& attribs) {
+	auto start = toInt64(getAttrib(attribs, sStart, 1));
+	auto size = toInt64(getAttrib(attribs, sSize, 2));
+	if (size <= 0 || start < 0 || (start + size) > aQI->getSize()) {
+		return;
+	}
+
+	// Skip the parts that are included in the snapshot already
+	vector<Segment> missing;
+	int64_t missingBytes = 0;
+	auto pos = start;
+	auto end = start + size;
+	for (const auto& s: aQI->getDone()) {
+		if (s.getEnd() <= pos) {
+			continue;
+		}
+
+		if (s.getStart() >= end) {
+			break;
+		}
+
+		if (s.getStart() > pos) {
+			missing.emplace_back(pos, s.getStart() - pos);
+			missingBytes += s.getStart() - pos;
+		}
+
+		pos = s.getEnd();
+	}
+
+	if (pos < end) {
+		missing.emplace_back(pos, end - pos);
+		missingBytes += end - pos;
+	}
+
+	if (missingBytes == 0 || static_cast<int64_t>(aQI->getDownloadedSegments()) + missingBytes >= aQI->getSize()) {
+		// Completed files are always written in the snapshot, don't finish the file here
+		return;
+	}
+
+	for (const auto& s: missing) {
+		aQI->addFinishedSegment(s);
+	}
+
+	if (aQI->getAutoPriority() && SETTING(AUTOPRIO_TYPE) == SettingsManager::PRIO_PROGRESS) {
+		aQI->setPriority(aQI->calculateAutoPriority());
+	}
+}
+
+void QueueLoader::loadJournalSource(const QueueItemPtr& aQI, const AttribViewList& attribs) {
+	const string cid(getAttrib(attribs, sCID, 1));
+	const string nick(getAttrib(attribs, sNick, 2));
+	const string hubHint(getAttrib(attribs, sHubHint, 3));
+	if (hubHint.empty()) {
+		return;
+	}
+
+	auto user = ClientManager::getInstance()->loadUser(cid, hubHint, nick);
+	if (!user) {
+		return;
+	}
+
+	try {
+		WLock l(qm->cs);
+		if (aQI->isSource(user)) {
+			return;
+		}
+
+		qm->addValidatedSource(aQI, HintedUser(user, hubHint), 0);
+	} catch (const Exception& e) {
+		qm->log(STRING_F(SOURCE_ADD_ERROR, e.what()), LogMessage::SEV_WARNING);
+	}
+}
+
+void QueueLoader::loadJournalSourceRemoval(const QueueItemPtr& aQI, const AttribViewList& attribs) {
+	auto user = ClientManager::getInstance()->findUser(CID(string(getAttrib(attribs, sCID, 1))));
+	if (!user) {
+		return;
+	}
+
+	auto reason = static_cast<Flags::MaskType>(toInt(getAttrib(attribs, sReason, 2)));
+
+	WLock l(qm->cs);
+	if (!aQI->isSource(user)) {
+		return;
+	}
+
+	qm->userQueue.removeQI(aQI, user, false, reason);
+	aQI->removeSource(user, reason);
+}
+
+void QueueLoader::loadJournalPriority(const QueueItemPtr& aQI, const AttribViewList& attribs) {
+	auto prio = toInt(getAttrib(attribs, sPriority, 1));
+	if (prio < static_cast<int>(Priority::PAUSED_FORCE) || prio > static_cast<int>(Priority::HIGHEST)) {
+		return;
+	}
+
+	WLock l(qm->cs);
+	aQI->setAutoPriority(toInt(getAttrib(attribs, sAutoPriority, 2)) == 1);
+	if (aQI->getPriority() != static_cast<Priority>(prio)) {
+		qm->userQueue.setQIPriority(aQI, static_cast<Priority>(prio));
+	}
+}
+
+void QueueLoader::addLoadedBundle() {
+	auto hasJournal = loadJournal();
+	qm->addLoadedBundle(curBundle);
+	if (hasJournal) {
+		// Compact on the next save
+		curBundle->setDirty();
+	}
+}
+
+void QueueLoader::startTagView(const string& name, const AttribViewList& attribs, bool simple) {
+	if (inJournal) {
+		loadJournalEntry(name, attribs);
+		return;
+	}
+
 	if (!inLegacyQueue && name == "Downloads") {
 		inLegacyQueue = true;
 	} else if (!inFileBundle && name == sFile) {
@@ -2741,7 +3122,7 @@ void QueueLoader::endTag(const string& name) {
 			if (!curBundle || curBundle->isEmpty()) {
 				throw Exception(STRING_F(NO_FILES_WERE_LOADED, curBundle->getTarget()));
 			} else {
-				qm->addLoadedBundle(curBundle);
+				addLoadedBundle();
 			}
 		} else if(name == sFile) {
 			ScopedFunctor([this] { curBundle = nullptr; });
@@ -2751,7 +3132,7 @@ void QueueLoader::endTag(const string& name) {
 			if (!curBundle || curBundle->isEmpty())
 				throw Exception(STRING(NO_FILES_FROM_FILE));
 
-			qm->addLoadedBundle(curBundle);
+			addLoadedBundle();
 		} else if(name == sDownload) {
 			// Queue file
 			if (inLegacyQueue && curBundle && curBundle->isFileBundle()) {
@@ -3435,13 +3816,22 @@ int QueueManager::addValidatedSources(const HintedUser& aUser, const QueueItemLi
 int QueueManager::addValidatedSources(const HintedUser& aUser, const QueueItemList& aItems, Flags::MaskType aAddBad, BundleList& matchingBundles_) noexcept {
 	bool wantConnection = false;
 
+	unordered_set<Bundle*> bundleSet;
+	for (const auto& b: matchingBundles_) {
+		bundleSet.insert(b.get());
+	}
+
 	QueueItemList addedItems;
-	{
-		// Add sources
+
+	// Add sources
+	// Large lists are handled in batches so that other threads won't need to wait for the lock too long
+	for (auto i = aItems.begin(); i != aItems.end();) {
+		auto batchEnd = i + min<ptrdiff_t>(SOURCE_BATCH_SIZE, distance(i, aItems.end()));
 
 		WLock l(cs);
-		ranges::copy_if(aItems, back_inserter(addedItems), [&](const QueueItemPtr& q) {
-			if (q->getBundle() && ranges::find(matchingBundles_, q->getBundle()) == matchingBundles_.end()) {
+		for (; i != batchEnd; ++i) {
+			const auto& q = *i;
+			if (q->getBundle() && bundleSet.insert(q->getBundle().get()).second) {
 				matchingBundles_.push_back(q->getBundle());
 			}
 
@@ -3450,13 +3840,11 @@ int QueueManager::addValidatedSources(const HintedUser& aUser, const QueueItemLi
 					wantConnection = true;
 				}
 
-				return true;
+				addedItems.push_back(q);
 			} catch (const QueueException&) {
 				// Ignore...
 			}
-
-			return false;
-		});
+		}
 	}
 
 	if (!addedItems.empty()) {
@@ -389,12 +389,12 @@ public:
 	// Blocking call
 	void shareBundle(BundlePtr aBundle, bool aSkipValidations) noexcept;
 
-	// Performs recheck for the supplied files. Recheck will be done in the calling thread.
+	// Performs recheck for the supplied files. Recheck will be done in the calling thread (the files are verified concurrently).
 	// The integrity of all finished segments will be verified and SFV will be validated for finished files
 	// The file will be paused if running
 	void recheckFiles(const QueueItemList& aQL) noexcept;
 
-	// Performs recheck for the supplied bundle. Recheck will be done in the calling thread.
+	// Performs recheck for the supplied bundle. Recheck will be done in the calling thread (the files are verified concurrently).
 	// The integrity of all finished segments will be verified and SFV will be validated for finished files
 	// The bundle will be paused if running
 	void recheckBundle(QueueToken aBundleToken) noexcept;
@@ -434,7 +434,12 @@ private:
 	/** File lists not to delete */
 	StringList protectedFileLists;
 
-	bool recheckFileImpl(const string& aPath, bool isBundleCheck, int64_t& failedBytes_) noexcept;
+	// aMaxReaders is the maximum number of concurrent reads from the file
+	bool recheckFileImpl(const string& aPath, bool isBundleCheck, size_t aMaxReaders, int64_t& failedBytes_) noexcept;
+
+	// Rechecks the files concurrently, returns the finished files that failed the check
+	QueueItemList recheckFilesImpl(const QueueItemList& aItems, bool aIsBundleCheck, int64_t& failedBytes_) noexcept;
+	void waitRecheckDownloads(const QueueItemList& aItems) const noexcept;
 	void handleFailedRecheckItems(const QueueItemList& ql) noexcept;
 
 	void connectBundleSources(const BundlePtr& aBundle) noexcept;
@@ -504,6 +509,9 @@ private:
 	int addSourcesHooked(const HintedUser& aUser, const QueueItemList& aItems, Flags::MaskType aAddBad) noexcept;
 	int addValidatedSources(const HintedUser& aUser, const QueueItemList& aItems, Flags::MaskType aAddBad) noexcept;
 	int addValidatedSources(const HintedUser& aUser, const QueueItemList& aItems, Flags::MaskType aAddBad, BundleList& bundles_) noexcept;
+
+	// Maximum number of sources to add while holding the queue lock
+	static const ptrdiff_t SOURCE_BATCH_SIZE = 1000;
 	 
 	void matchTTHList(const string& name, const HintedUser& user, int flags) noexcept;
 
@@ -62,6 +62,10 @@ namespace dcpp {
 
 			return ret;
 		}
+
+		const SearchQuery& getQuery() const noexcept {
+			return query;
+		}
 	private:
 		struct Match {
 			T item;
@@ -28,7 +28,8 @@
 namespace dcpp {
 	atomic<SearchInstanceToken> searchInstanceIdCounter { 1 };
 	SearchInstance::SearchInstance(const string& aOwnerId, uint64_t aExpirationTick) : token(searchInstanceIdCounter++), expirationTick(aExpirationTick), ownerId(aOwnerId) {
-		SearchManager::getInstance()->addListener(this);
+		// Results without a token (NMDC) are matched manually
+		SearchManager::getInstance()->addResultReceiver(Util::emptyString, this);
 		ClientManager::getInstance()->addListener(this);
 	}
 
@@ -36,7 +37,10 @@ namespace dcpp {
 		ClientManager::getInstance()->cancelSearch(this);
 
 		ClientManager::getInstance()->removeListener(this);
-		SearchManager::getInstance()->removeListener(this);
+		SearchManager::getInstance()->removeResultReceiver(Util::emptyString, this);
+		if (!currentSearchToken.empty()) {
+			SearchManager::getInstance()->removeResultReceiver(currentSearchToken, this);
+		}
 	}
 
 	optional<int64_t> SearchInstance::getTimeToExpiration() const noexcept {
@@ -79,8 +83,11 @@ namespace dcpp {
 	void SearchInstance::reset(const SearchPtr& aSearch) noexcept {
 		ClientManager::getInstance()->cancelSearch(this);
 
+		string previousSearchToken;
+
 		{
 			WLock l(cs);
+			previousSearchToken = currentSearchToken;
 			currentSearchToken = aSearch->token;
 			curMatcher = shared_ptr<SearchQuery>(SearchQuery::fromSearch(aSearch));
 			curParams = aSearch;
@@ -91,6 +98,17 @@ namespace dcpp {
 			filteredResultCount = 0;
 		}
 
+		// Results are matched against the current token so the receiver can be registered only after it has been updated
+		if (previousSearchToken != aSearch->token) {
+			if (!previousSearchToken.empty()) {
+				SearchManager::getInstance()->removeResultReceiver(previousSearchToken, this);
+			}
+
+			if (!aSearch->token.empty()) {
+				SearchManager::getInstance()->addResultReceiver(aSearch->token, this);
+			}
+		}
+
 		fire(SearchInstanceListener::Reset());
 	}
 
@@ -213,7 +231,7 @@ namespace dcpp {
 		return relevanceInfo;
 	}
 
-	void SearchInstance::on(SearchManagerListener::SR, const SearchResultPtr& aResult) noexcept {
+	void SearchInstance::onSearchResult(const SearchResultPtr& aResult) noexcept {
 		auto relevanceInfo = matchResult(aResult);
 		if (!relevanceInfo) {
 			return;
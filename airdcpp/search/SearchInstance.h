@@ -24,6 +24,7 @@
 #include <airdcpp/hub/ClientManagerListener.h>
 #include <airdcpp/search/SearchInstanceListener.h>
 #include <airdcpp/search/SearchManagerListener.h>
+#include <airdcpp/search/SearchResultReceiver.h>
 
 #include <airdcpp/search/GroupedSearchResult.h>
 #include <airdcpp/core/Speaker.h>
@@ -31,7 +32,7 @@
 
 namespace dcpp {
 	struct SearchQueueInfo;
-	class SearchInstance : public Speaker<SearchInstanceListener>, private SearchManagerListener, private ClientManagerListener {
+	class SearchInstance : public Speaker<SearchInstanceListener>, private SearchResultReceiver, private ClientManagerListener {
 	public:
 		SearchInstance(const string& aOwnerId, uint64_t aExpirationTick = 0);
 		~SearchInstance() override;
@@ -76,7 +77,7 @@ namespace dcpp {
 
 		IGETSET(bool, freeSlotsOnly, FreeSlotsOnly, false);
 	private:
-		void on(SearchManagerListener::SR, const SearchResultPtr& aResult) noexcept override;
+		void onSearchResult(const SearchResultPtr& aResult) noexcept override;
 		optional<SearchResult::RelevanceInfo> matchResult(const SearchResultPtr& aResult) noexcept;
 
 		GroupedSearchResult::Map results;
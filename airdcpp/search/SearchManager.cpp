@@ -35,6 +35,9 @@
 
 namespace dcpp {
 
+// Result receivers that are being called by the current thread
+static thread_local vector<const void*> receiverDispatchStack;
+
 SearchManager::SearchManager() : 
 	searchTypes(make_unique<SearchTypes>([this]{ fire(SearchManagerListener::SearchTypesChanged()); })), 
 	udpServer(make_unique<UDPServer>()) 
@@ -264,7 +267,7 @@ void SearchManager::onSR(const string& x, const string& aRemoteIP /*Util::emptyS
 		adcPath, aRemoteIP, TTHValue(tth), Util::emptyString, 0, connection, DirectoryContentInfo::uninitialized()
 	);
 
-	fire(SearchManagerListener::SR(), sr);
+	dispatchResult(sr);
 }
 
 void SearchManager::onRES(const AdcCommand& cmd, const UserPtr& aFrom, const string& aRemoteIp) {
@@ -331,7 +334,61 @@ void SearchManager::onRES(const AdcCommand& cmd, const UserPtr& aFrom, const str
 		return;
 	}
 
-	fire(SearchManagerListener::SR(), sr);
+	dispatchResult(sr);
+}
+
+void SearchManager::dispatchResult(const SearchResultPtr& aResult) noexcept {
+	// Broad listeners
+	fire(SearchManagerListener::SR(), aResult);
+
+	// Owners of the search
+	vector<ResultReceiverPtr> receivers;
+
+	{
+		RLock l(receiverCS);
+		for (const auto& r: resultReceivers.equal_range(aResult->getSearchToken()) | pair_to_range | views::values) {
+			// Registered while the lock is held so that removeResultReceiver can't miss the delivery
+			r->dispatches++;
+			receivers.push_back(r);
+		}
+	}
+
+	for (const auto& r: receivers) {
+		receiverDispatchStack.push_back(r.get());
+		r->receiver->onSearchResult(aResult);
+		receiverDispatchStack.pop_back();
+
+		r->dispatches--;
+		r->dispatches.notify_all();
+	}
+}
+
+void SearchManager::addResultReceiver(const string& aToken, SearchResultReceiver* aReceiver) noexcept {
+	WLock l(receiverCS);
+	resultReceivers.emplace(aToken, make_shared<ResultReceiver>(aReceiver));
+}
+
+void SearchManager::removeResultReceiver(const string& aToken, SearchResultReceiver* aReceiver) noexcept {
+	ResultReceiverPtr removed;
+
+	{
+		WLock l(receiverCS);
+		auto [begin, end] = resultReceivers.equal_range(aToken);
+		auto i = find_if(begin, end, [aReceiver](const auto& r) { return r.second->receiver == aReceiver; });
+		if (i == end) {
+			return;
+		}
+
+		removed = std::move(i->second);
+		resultReceivers.erase(i);
+	}
+
+	// The receiver may be deleted after returning, wait for the deliveries in other threads
+	// (results delivered by the current thread are still on the call stack and they can't be waited for)
+	const auto ownDispatches = static_cast<int>(ranges::count(receiverDispatchStack, removed.get()));
+	for (auto n = removed->dispatches.load(); n > ownDispatches; n = removed->dispatches.load()) {
+		removed->dispatches.wait(n);
+	}
 }
 
 void SearchManager::on(TimerManagerListener::Minute, uint64_t aTick) noexcept {
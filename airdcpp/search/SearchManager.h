@@ -37,6 +37,7 @@ namespace dcpp {
 
 class SearchTypes;
 class SocketException;
+class SearchResultReceiver;
 class UDPServer;
 
 struct SearchQueueInfo {
@@ -66,6 +67,12 @@ public:
 
 	bool decryptPacket(string& x, size_t aLen, const ByteVector& aBuf);
 
+	// Results are delivered to the SR listeners (all results) and to the receivers registered for the result token
+	// Receivers registered with an empty token get the results without a token (NMDC)
+	// Removing a receiver blocks until the results that are being delivered to it by other threads have been handled
+	void addResultReceiver(const string& aToken, SearchResultReceiver* aReceiver) noexcept;
+	void removeResultReceiver(const string& aToken, SearchResultReceiver* aReceiver) noexcept;
+
 	SearchInstancePtr createSearchInstance(const string& aOwnerId, uint64_t aExpirationTick = 0) noexcept;
 	SearchInstancePtr removeSearchInstance(SearchInstanceToken aToken) noexcept;
 	SearchInstancePtr getSearchInstance(SearchInstanceToken aToken) const noexcept;
@@ -95,6 +102,22 @@ private:
 	
 	void on(TimerManagerListener::Minute, uint64_t aTick) noexcept override;
 
+	void dispatchResult(const SearchResultPtr& aResult) noexcept;
+
+	struct ResultReceiver {
+		explicit ResultReceiver(SearchResultReceiver* aReceiver) noexcept : receiver(aReceiver) { }
+
+		SearchResultReceiver* const receiver;
+
+		// Number of threads delivering results to the receiver
+		atomic<int> dispatches = 0;
+	};
+
+	using ResultReceiverPtr = shared_ptr<ResultReceiver>;
+
+	mutable SharedMutex receiverCS;
+	unordered_multimap<string, ResultReceiverPtr> resultReceivers;
+
 	const unique_ptr<SearchTypes> searchTypes;
 	const unique_ptr<UDPServer> udpServer;
 
@@ -341,6 +341,7 @@ const string SettingsManager::settingTags[] =
 	"ClearDirectoryHistory", "ClearExcludeHistory", "ClearDirHistory", "NoIpOverride6", "IPUpdate6",
 	"SkipEmptyDirsShare", "RemoveExpiredAs", "AdcLogGroupCID", "ShareFollowSymlinks", "UseDefaultCertPaths", "StartupRefresh",
 	"FLReportDupeFiles", "UseUploadBundles", "LogIgnored", "RemoveFinishedBundles", "AlwaysCCPM",
+	"PreallocateDownloads", "DownloadDropCache", "EnableTracing",
 
 	"PopupBotPms", "PopupHubPms", "SortFavUsersFirst",
 #ifdef HAVE_GUI
@@ -645,6 +646,9 @@ SettingsManager::SettingsManager() : connectionRegex("(\\d+(\\.\\d+)?)")
 	setDefault(LOG_IGNORED, true);
 	setDefault(REMOVE_FINISHED_BUNDLES, false);
 	setDefault(ALWAYS_CCPM, false);
+	setDefault(PREALLOCATE_DOWNLOADS, false);
+	setDefault(DOWNLOAD_DROP_CACHE, false);
+	setDefault(ENABLE_TRACING, false);
 
 	setDefault(MAX_RECENT_HUBS, 30);
 	setDefault(MAX_RECENT_PRIVATE_CHATS, 15);
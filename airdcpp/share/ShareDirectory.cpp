@@ -27,6 +27,8 @@
 #include <airdcpp/search/SearchQuery.h>
 #include <airdcpp/search/SearchResult.h>
 #include <airdcpp/settings/SettingsManager.h>
+#include <airdcpp/share/ShareProfileBlooms.h>
+#include <airdcpp/share/ShareUploadCache.h>
 #include <airdcpp/core/io/xml/SimpleXML.h>
 
 namespace dcpp {
@@ -94,7 +96,11 @@ ShareDirectory::Ptr ShareDirectory::cloneRoot(const Ptr& aOldRoot, time_t aLastW
 }
 
 bool ShareDirectory::setParent(const ShareDirectory::Ptr& aDirectory, ShareDirectory* aParent) noexcept {
-	aDirectory->parent = aParent;
+	if (aDirectory->parent != aParent) {
+		// Linked parents may be read concurrently
+		aDirectory->parent = aParent;
+	}
+
 	if (aParent) {
 		if (auto inserted = aParent->directories.insert_sorted(aDirectory).second; !inserted) {
 			dcassert(0);
@@ -107,6 +113,22 @@ bool ShareDirectory::setParent(const ShareDirectory::Ptr& aDirectory, ShareDirec
 	return true;
 }
 
+void ShareDirectory::linkParent(ShareDirectory& aDirectory, ShareDirectory* aParent) noexcept {
+	dcassert(!aDirectory.parent);
+	aDirectory.parent = aParent;
+}
+
+void ShareDirectory::detach(ShareDirectory& aDirectory) noexcept {
+	if (!aDirectory.parent) {
+		return;
+	}
+
+	auto& siblings = aDirectory.parent->directories;
+	if (auto i = siblings.find(aDirectory.realName.getLower()); i != siblings.end() && i->get() == &aDirectory) {
+		siblings.erase(i);
+	}
+}
+
 void ShareDirectory::updateModifyDate() {
 	lastWrite = dcpp::File::getLastModified(getRealPathUnsafe());
 }
@@ -158,14 +180,14 @@ void ShareDirectory::addFile(DualString&& aName, const HashedFile& aFileInfo, Sh
 		auto i = files.find(aName.getLower());
 		if (i != files.end()) {
 			// Get rid of false constness...
-			(*i)->cleanIndices(sharedSize_, maps_.tthIndex);
+			(*i)->cleanIndices(sharedSize_, maps_);
 			delete* i;
 			files.erase(i);
 		}
 	}
 
 	auto it = files.insert_sorted(new ShareDirectory::File(std::move(aName), this, aFileInfo)).first;
-	(*it)->updateIndices(maps_.getBloom(), sharedSize_, maps_.tthIndex);
+	(*it)->updateIndices(maps_, sharedSize_);
 
 	if (dirtyProfiles_) {
 		copyRootProfiles(*dirtyProfiles_, true);
@@ -275,6 +297,15 @@ void ShareDirectory::getProfileInfo(ProfileToken aProfile, int64_t& totalSize_,
 	}
 }
 
+void ShareDirectory::getContentRecursive(vector<const ShareDirectory*>& directories_, vector<const File*>& files_) const noexcept {
+	directories_.push_back(this);
+	ranges::copy(files, back_inserter(files_));
+
+	for (const auto& d : directories) {
+		d->getContentRecursive(directories_, files_);
+	}
+}
+
 bool ShareDirectory::hasProfile(const ProfileTokenSet& aProfiles) const noexcept {
 	if (root && root->hasRootProfile(aProfiles)) {
 		return true;
@@ -326,8 +357,8 @@ bool ShareDirectory::hasProfile(const OptionalProfileToken& aProfile) const noex
 
 
 // INDEXES
-void ShareDirectory::cleanIndices(ShareDirectory& aDirectory, int64_t& sharedSize_, File::TTHMap& tthIndex_, ShareDirectory::MultiMap& dirNames_) noexcept {
-	aDirectory.cleanIndices(sharedSize_, tthIndex_, dirNames_);
+void ShareDirectory::cleanIndices(ShareDirectory& aDirectory, int64_t& sharedSize_, ShareTreeMaps& maps_) noexcept {
+	aDirectory.cleanIndices(sharedSize_, maps_);
 
 	if (aDirectory.parent) {
 		aDirectory.parent->directories.erase_key(aDirectory.realName.getLower());
@@ -335,38 +366,46 @@ void ShareDirectory::cleanIndices(ShareDirectory& aDirectory, int64_t& sharedSiz
 	}
 }
 
-void ShareDirectory::cleanIndices(int64_t& sharedSize_, ShareDirectory::File::TTHMap& tthIndex_, ShareDirectory::MultiMap& dirNames_) const noexcept {
+void ShareDirectory::cleanIndices(int64_t& sharedSize_, ShareTreeMaps& maps_) const noexcept {
 	for (const auto& d : directories) {
-		d->cleanIndices(sharedSize_, tthIndex_, dirNames_);
+		d->cleanIndices(sharedSize_, maps_);
 	}
 
 	//remove from the name map
-	removeDirName(*this, dirNames_);
+	removeDirName(*this, maps_.lowerDirNameMap);
 
 	//remove all files
 	for (const auto& f : files) {
-		f->cleanIndices(sharedSize_, tthIndex_);
+		f->cleanIndices(sharedSize_, maps_);
 	}
 }
 
-void ShareDirectory::File::updateIndices(ShareBloom& bloom_, int64_t& sharedSize_, TTHMap& tthIndex_) noexcept {
+void ShareDirectory::File::updateIndices(ShareTreeMaps& maps_, int64_t& sharedSize_) noexcept {
 	parent->increaseSize(size, sharedSize_);
 
 #ifdef _DEBUG
-	checkAddedTTHDebug(this, tthIndex_);
+	checkAddedTTHDebug(this, maps_.tthIndex);
 #endif
-	tthIndex_.emplace(&tth, this);
-	bloom_.add(name.getLower());
+	maps_.tthIndex.emplace(&tth, this);
+	maps_.getBloom().add(name.getLower());
+
+	if (maps_.profileBlooms) {
+		maps_.profileBlooms->addFile(*this);
+	}
 }
 
-void ShareDirectory::File::cleanIndices(int64_t& sharedSize_, File::TTHMap& tthIndex_) noexcept {
+void ShareDirectory::File::cleanIndices(int64_t& sharedSize_, ShareTreeMaps& maps_) noexcept {
 	parent->decreaseSize(size, sharedSize_);
 
-	auto flst = tthIndex_.equal_range(&tth);
-	auto p = ranges::find(flst | pair_to_range | views::values, this);
-	if (p.base() != flst.second)
-		tthIndex_.erase(p.base());
-	else
+	if (maps_.profileBlooms) {
+		maps_.profileBlooms->removeFile(*this);
+	}
+
+	if (maps_.uploadCache) {
+		maps_.uploadCache->remove(tth);
+	}
+
+	if (!maps_.tthIndex.erase(tth, this))
 		dcassert(0);
 }
 
@@ -404,9 +443,8 @@ void ShareDirectory::checkAddedDirNameDebug(const ShareDirectory::Ptr& aDir, Sha
 }
 
 void ShareDirectory::File::checkAddedTTHDebug(const ShareDirectory::File* aFile, ShareDirectory::File::TTHMap& aTTHIndex) noexcept {
-	auto flst = aTTHIndex.equal_range(const_cast<TTHValue*>(&aFile->getTTH()));
-	auto p = ranges::find(flst | pair_to_range | views::values, aFile);
-	dcassert(p.base() == flst.second);
+	auto flst = aTTHIndex.findAll(aFile->getTTH());
+	dcassert(ranges::find(flst, aFile) == flst.end());
 }
 
 #endif
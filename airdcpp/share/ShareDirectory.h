@@ -24,6 +24,7 @@
 #include <airdcpp/core/types/GetSet.h>
 #include <airdcpp/hash/value/HashBloom.h>
 #include <airdcpp/hash/value/MerkleTree.h>
+#include <airdcpp/hash/value/TTHIndex.h>
 #include <airdcpp/core/classes/SortedVector.h>
 #include <airdcpp/util/Util.h>
 
@@ -88,6 +89,8 @@ private:
 };
 
 class ShareTreeMaps;
+class ShareProfileBlooms;
+class ShareUploadCache;
 class FilelistDirectory;
 class ShareDirectory {
 public:
@@ -109,7 +112,7 @@ public:
 
 		typedef SortedVector<File*, std::vector, string, Compare, NameLower> Set;
 		typedef SortedVector<const File*, std::vector, string, Compare, NameLower> ConstSet;
-		typedef unordered_multimap<TTHValue*, const ShareDirectory::File*> TTHMap;
+		typedef TTHIndex<const ShareDirectory::File*> TTHMap;
 
 		File(DualString&& aName, ShareDirectory* aParent, const HashedFile& aFileInfo);
 		~File();
@@ -126,8 +129,8 @@ public:
 		GETSET(time_t, lastWrite, LastWrite);
 		GETSET(TTHValue, tth, TTH);
 
-		void updateIndices(ShareBloom& aBloom_, int64_t& sharedSize_, File::TTHMap& tthIndex_) noexcept;
-		void cleanIndices(int64_t& sharedSize_, TTHMap& tthIndex_) noexcept;
+		void updateIndices(ShareTreeMaps& maps_, int64_t& sharedSize_) noexcept;
+		void cleanIndices(int64_t& sharedSize_, ShareTreeMaps& maps_) noexcept;
 
 #ifdef _DEBUG
 		// Checks that duplicate/incorrect files won't get through
@@ -177,8 +180,16 @@ public:
 	// Possible directories with the same name must be removed from the parent first
 	static bool setParent(const ShareDirectory::Ptr& aDirectory, ShareDirectory* aParent) noexcept;
 
+	// Set the parent without adding the directory in it
+	// Allows resolving paths of the files before the directory is added in the tree with setParent
+	static void linkParent(ShareDirectory& aDirectory, ShareDirectory* aParent) noexcept;
+
+	// Remove the directory from its parent
+	// The parent pointer is kept so that paths of the files can be resolved until they have been removed from the indices
+	static void detach(ShareDirectory& aDirectory) noexcept;
+
 	// Remove directory from possible parent and all shared containers
-	static void cleanIndices(ShareDirectory& aDirectory, int64_t& sharedSize_, File::TTHMap& tthIndex_, ShareDirectory::MultiMap& aDirNames_) noexcept;
+	static void cleanIndices(ShareDirectory& aDirectory, int64_t& sharedSize_, ShareTreeMaps& maps_) noexcept;
 
 	struct HasRootProfile {
 		HasRootProfile(const OptionalProfileToken& aProfile) : profile(aProfile) { }
@@ -216,6 +227,9 @@ public:
 
 	void getProfileInfo(ProfileToken aProfile, int64_t& totalSize_, size_t& filesCount_) const noexcept;
 
+	// Collect the directory and all its subdirectories and files
+	void getContentRecursive(vector<const ShareDirectory*>& directories_, vector<const File*>& files_) const noexcept;
+
 	void search(SearchResultInfo::Set& aResults, SearchQuery& aStrings, int aLevel) const noexcept;
 
 	void toTTHList(OutputStream& tthList, string& tmp2, bool aRecursive) const;
@@ -295,7 +309,7 @@ public:
 	ShareDirectory(DualString&& aRealName, ShareDirectory* aParent, time_t aLastWrite, const ShareRoot::Ptr& aRoot = nullptr);
 private:
 	File::Set files;
-	void cleanIndices(int64_t& sharedSize_, File::TTHMap& tthIndex_, ShareDirectory::MultiMap& dirNames_) const noexcept;
+	void cleanIndices(int64_t& sharedSize_, ShareTreeMaps& maps_) const noexcept;
 
 	ShareDirectory* parent;
 	Set directories;
@@ -311,7 +325,8 @@ private:
 class ShareTreeMaps {
 public:
 	typedef std::function<ShareBloom*()> GetBloomF;
-	ShareTreeMaps(GetBloomF&& aGetBloomF) : getBloomF(aGetBloomF) {}
+	ShareTreeMaps(GetBloomF&& aGetBloomF, ShareProfileBlooms* aProfileBlooms = nullptr, ShareUploadCache* aUploadCache = nullptr) : 
+		profileBlooms(aProfileBlooms), uploadCache(aUploadCache), getBloomF(aGetBloomF) {}
 
 	// Map real name to virtual name - multiple real names may be mapped to a single virtual one
 	ShareDirectory::Map rootPaths;
@@ -323,6 +338,10 @@ public:
 	ShareBloom& getBloom() noexcept {
 		return *getBloomF();
 	}
+
+	// Set only for the actual share tree (not for refresh tasks)
+	ShareProfileBlooms* const profileBlooms;
+	ShareUploadCache* const uploadCache;
 private:
 	GetBloomF getBloomF;
 };
@@ -43,6 +43,7 @@
 #include <airdcpp/core/version.h>
 
 #include <airdcpp/core/thread/concurrency.h>
+#include <airdcpp/core/timer/Tracer.h>
 
 namespace dcpp {
 
@@ -159,15 +160,17 @@ struct ShareManager::ShareLoader : public SimpleXMLReader::ThreadedCallBack, pub
 	}
 
 
-	void startTag(const string& aName, StringPairList& aAttribs, bool aSimple) override {
+	void startTagView(const string& aName, const SimpleXMLReader::AttribViewList& aAttribs, bool aSimple) override {
 		if(compare(aName, SDIRECTORY) == 0) {
-			const string& name = getAttrib(aAttribs, SNAME, 0);
-			const string& date = getAttrib(aAttribs, DATE, 1);
+			const string name(getAttrib(aAttribs, SNAME, 0));
+			auto date = toTimeT(getAttrib(aAttribs, DATE, 1));
+
+			addPendingFiles();
 
 			if (!name.empty()) {
 				curDirPath += name + PATH_SEPARATOR;
 
-				cur = ShareDirectory::createNormal(name, cur, Util::toTimeT(date), *this).get();
+				cur = ShareDirectory::createNormal(name, cur, date, *this).get();
 				if (!cur) {
 					throw Exception("Duplicate directory name");
 				}
@@ -181,30 +184,30 @@ struct ShareManager::ShareLoader : public SimpleXMLReader::ThreadedCallBack, pub
 				}
 			}
 		} else if (cur && compare(aName, SFILE) == 0) {
-			const auto& fname = getAttrib(aAttribs, SNAME, 0);
+			auto fname = getAttrib(aAttribs, SNAME, 0);
 			if (fname.empty()) {
-				dcdebug("Invalid file found: %s\n", fname.c_str());
+				dcdebug("Invalid file found in directory %s\n", curDirPath.c_str());
 				return;
 			}
 
-			try {
-				DualString name(fname);
-				HashedFile fi;
-				HashManager::getInstance()->getFileInfo(curDirPathLower + name.getLower(), curDirPath + fname, fi);
-				cur->addFile(std::move(name), fi, *this, stats.addedSize);
-			} catch(Exception& e) {
-				stats.hashSize += File::getSize(curDirPath + fname);
-				dcdebug("Error loading shared file %s \n", e.getError().c_str());
+			const string nameStr(fname);
+			DualString name(nameStr);
+			pendingFiles.emplace_back(curDirPath + nameStr, curDirPathLower + name.getLower(), HashedFile());
+			pendingFileNames.push_back(std::move(name));
+			if (pendingFiles.size() >= MAX_HASHED_FILE_BATCH) {
+				addPendingFiles();
 			}
 		} else if (compare(aName, SHARE) == 0) {
-			auto version = Util::toInt(getAttrib(aAttribs, SVERSION, 0));
+			auto version = toInt(getAttrib(aAttribs, SVERSION, 0));
 			if (version > Util::toInt(SHARE_CACHE_VERSION))
 				throw Exception("Newer cache version"); //don't load those...
 
-			cur->setLastWrite(Util::toTimeT(getAttrib(aAttribs, DATE, 2)));
+			cur->setLastWrite(toTimeT(getAttrib(aAttribs, DATE, 2)));
 		}
 	}
 	void endTag(const string& name) override {
+		addPendingFiles();
+
 		if (compare(name, SDIRECTORY) == 0) {
 			if (cur) {
 				curDirPath = PathUtil::getParentDir(curDirPath);
@@ -217,6 +220,30 @@ struct ShareManager::ShareLoader : public SimpleXMLReader::ThreadedCallBack, pub
 private:
 	friend struct SizeSort;
 
+	// Add files of the current directory (the hash database is queried with a single lookup)
+	void addPendingFiles() noexcept {
+		if (pendingFiles.empty()) {
+			return;
+		}
+
+		HashManager::getInstance()->getFileInfos(pendingFiles);
+		for (size_t i = 0; i < pendingFiles.size(); ++i) {
+			const auto& query = pendingFiles[i];
+			if (query.found) {
+				cur->addFile(std::move(pendingFileNames[i]), query.file, *this, stats.addedSize);
+			} else {
+				stats.hashSize += max(query.file.getSize(), static_cast<int64_t>(0));
+				dcdebug("Error loading shared file %s\n", query.path.c_str());
+			}
+		}
+
+		pendingFiles.clear();
+		pendingFileNames.clear();
+	}
+
+	HashedFileQueryList pendingFiles;
+	vector<DualString> pendingFileNames;
+
 	ShareDirectory* cur;
 
 	string curDirPathLower;
@@ -501,6 +528,9 @@ void ShareManager::getRealPaths(const string& aVirtualPath, StringList& realPath
 
 void ShareManager::search(SearchResultList& results_, ShareSearch& aSearch) {
 	if (aSearch.search.root) {
+		static auto& tthDuration = Tracer::getHistogram(Tracer::SEARCH, "tthSearch");
+		Tracer::Span span(Tracer::SEARCH, "tthSearch", &tthDuration);
+
 		searchCounters.tthSearches++;
 		for (const auto& p : hashedFileProviders) {
 			p->search(results_, *aSearch.search.root, aSearch);
@@ -509,6 +539,9 @@ void ShareManager::search(SearchResultList& results_, ShareSearch& aSearch) {
 		return;
 	}
 
+	static auto& textDuration = Tracer::getHistogram(Tracer::SEARCH, "textSearch");
+	Tracer::Span span(Tracer::SEARCH, "textSearch", &textDuration);
+
 	tree->searchText(results_, aSearch, searchCounters);
 }
 
@@ -664,12 +697,34 @@ bool ShareManager::RefreshTaskHandler::ShareBuilder::validateFileItem(const File
 	return true;
 }
 
+void ShareManager::RefreshTaskHandler::ShareBuilder::addHashedFiles(const ShareDirectory::Ptr& aParent, HashedFileQueryList& files_, vector<DualString>& names_) noexcept {
+	HashManager::getInstance()->checkTTHs(files_);
+
+	for (size_t i = 0; i < files_.size(); ++i) {
+		const auto& query = files_[i];
+		if (query.found) {
+			aParent->addFile(std::move(names_[i]), query.file, *this, stats.addedSize);
+		} else {
+			stats.hashSize += query.file.getSize();
+		}
+	}
+
+	files_.clear();
+	names_.clear();
+}
+
 void ShareManager::RefreshTaskHandler::ShareBuilder::buildTree(const string& aPath, const string& aPathLower, const ShareDirectory::Ptr& aParent, const ShareDirectory::Ptr& aOldParent, const bool& aStopping) {
 	ErrorCollector errors;
+
+	// Files are looked up from the hash database in batches
+	HashedFileQueryList hashedFiles;
+	vector<DualString> hashedFileNames;
+
 	FileFindIter end;
 	for(FileFindIter i(aPath, "*"); i != end && !aStopping; ++i) {
 		const auto name = i->getFileName();
 		if(name.empty()) {
+			addHashedFiles(aParent, hashedFiles, hashedFileNames);
 			return;
 		}
 
@@ -741,19 +796,16 @@ void ShareManager::RefreshTaskHandler::ShareBuilder::buildTree(const string& aPa
 			}
 
 			// Add it
-			auto size = i->getSize();
-			try {
-				HashedFile fi(i->getLastWriteTime(), size);
-				if(HashManager::getInstance()->checkTTH(aPathLower + dualName.getLower(), aPath + name, fi)) {
-					aParent->addFile(std::move(dualName), fi, *this, stats.addedSize);
-				} else {
-					stats.hashSize += size;
-				}
-			} catch(const HashException&) {
+			hashedFiles.emplace_back(aPath + name, aPathLower + dualName.getLower(), HashedFile(i->getLastWriteTime(), i->getSize()));
+			hashedFileNames.push_back(std::move(dualName));
+			if (hashedFiles.size() >= MAX_HASHED_FILE_BATCH) {
+				addHashedFiles(aParent, hashedFiles, hashedFileNames);
 			}
 		}
 	}
 
+	addHashedFiles(aParent, hashedFiles, hashedFileNames);
+
 	auto msg = errors.getMessage();
 	if (!msg.empty()) {
 		log(STRING_F(SHARE_FILES_BLOCKED, aPath % msg), LogMessage::SEV_INFO);
@@ -815,6 +867,9 @@ RefreshTaskQueueInfo ShareManager::refreshPathsHookedThrow(ShareRefreshPriority
 }
 
 bool ShareManager::handleRefreshPath(const string& aRefreshPath, const ShareRefreshTask& aTask, ShareRefreshStats& totalStats, ShareBloom* bloom_, ProfileTokenSet& dirtyProfiles_) noexcept {
+	static auto& refreshDuration = Tracer::getHistogram(Tracer::REFRESH, "refreshPath");
+	Tracer::Span span(Tracer::REFRESH, "refreshPath", &refreshDuration);
+
 	ShareDirectory::Ptr optionalOldDirectory = nullptr;
 
 	{
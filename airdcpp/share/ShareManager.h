@@ -29,6 +29,7 @@
 #include <airdcpp/core/classes/Exception.h>
 #include <airdcpp/share/UploadFileProvider.h>
 #include <airdcpp/message/Message.h>
+#include <airdcpp/hash/HashedFile.h>
 #include <airdcpp/hash/value/MerkleTree.h>
 #include <airdcpp/share/ShareDirectory.h>
 #include <airdcpp/share/ShareDirectoryInfo.h>
@@ -211,6 +212,9 @@ public:
 
 	struct ShareLoader;
 
+	// Maximum number of files to look up from the hash database at once when building the tree
+	static const size_t MAX_HASHED_FILE_BATCH = 1000;
+
 	void registerUploadFileProvider(const UploadFileProvider* aProvider) noexcept;
 
 	ShareProfileManager& getProfileMgr() noexcept {
@@ -271,6 +275,9 @@ private:
 
 			bool validateFileItem(const FileItemInfoBase& aFileItem, const string& aPath, bool aIsNew, bool aNewParent, ErrorCollector& aErrorCollector) noexcept;
 
+			// Check the hash information for the listed files and add the hashed ones in the directory
+			void addHashedFiles(const ShareDirectory::Ptr& aParent, HashedFileQueryList& files_, vector<DualString>& names_) noexcept;
+
 			const ShareManager& sm;
 		};
 
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2011-2024 AirDC++ Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "stdinc.h"
+#include <airdcpp/share/ShareProfileBlooms.h>
+
+namespace dcpp {
+
+void ShareProfileBlooms::getBloom(ProfileToken aProfile, HashBloom& bloom_, const ShareDirectory::File::TTHMap& aTTHIndex) noexcept {
+	Lock l(cs);
+	auto& profileBlooms = blooms[aProfile];
+	auto i = ranges::find_if(profileBlooms, [&](const auto& b) { return b->hasSameParams(bloom_); });
+	if (i == profileBlooms.end()) {
+		// The parameters change when the file count of the profile changes (or when a hub with different settings asks for it)
+		auto profileBloom = make_unique<CountingHashBloom>();
+		profileBloom->reset(bloom_.getK(), bloom_.getM(), bloom_.getH());
+
+		for (const auto& [tth, file] : aTTHIndex) {
+			if (file->hasProfile(aProfile)) {
+				profileBloom->add(*tth);
+			}
+		}
+
+		if (profileBlooms.size() >= MAX_PROFILE_BLOOMS) {
+			profileBlooms.pop_back();
+		}
+
+		i = profileBlooms.insert(profileBlooms.begin(), std::move(profileBloom));
+	} else if (i != profileBlooms.begin()) {
+		// Move to front
+		std::rotate(profileBlooms.begin(), i, i + 1);
+		i = profileBlooms.begin();
+	}
+
+	bloom_.merge(**i);
+}
+
+void ShareProfileBlooms::addFile(const ShareDirectory::File& aFile) noexcept {
+	for (const auto& [profile, profileBlooms] : blooms) {
+		if (aFile.hasProfile(profile)) {
+			for (const auto& bloom : profileBlooms) {
+				bloom->add(aFile.getTTH());
+			}
+		}
+	}
+}
+
+void ShareProfileBlooms::removeFile(const ShareDirectory::File& aFile) noexcept {
+	for (const auto& [profile, profileBlooms] : blooms) {
+		if (aFile.hasProfile(profile)) {
+			for (const auto& bloom : profileBlooms) {
+				bloom->remove(aFile.getTTH());
+			}
+		}
+	}
+}
+
+void ShareProfileBlooms::removeProfile(ProfileToken aProfile) noexcept {
+	blooms.erase(aProfile);
+}
+
+void ShareProfileBlooms::clear() noexcept {
+	blooms.clear();
+}
+
+} // namespace dcpp
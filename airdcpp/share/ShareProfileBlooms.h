@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2011-2024 AirDC++ Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef DCPLUSPLUS_DCPP_SHARE_PROFILE_BLOOMS_H
+#define DCPLUSPLUS_DCPP_SHARE_PROFILE_BLOOMS_H
+
+#include <airdcpp/core/header/typedefs.h>
+
+#include <airdcpp/core/thread/CriticalSection.h>
+#include <airdcpp/hash/value/HashBloom.h>
+#include <airdcpp/share/ShareDirectory.h>
+
+namespace dcpp {
+
+// TTH blooms of share profiles that are kept up to date when files are added or removed
+// The bloom of a profile is created when it's requested for the first time with the wanted parameters
+// (bits can't be shared between blooms of different sizes, so the parameters must match exactly)
+//
+// Blooms are created while holding the read lock of the TTH index and updated while holding the write lock
+class ShareProfileBlooms {
+public:
+	// Merge the profile bloom into bloom_ (using the parameters of bloom_)
+	void getBloom(ProfileToken aProfile, HashBloom& bloom_, const ShareDirectory::File::TTHMap& aTTHIndex) noexcept;
+
+	void addFile(const ShareDirectory::File& aFile) noexcept;
+	void removeFile(const ShareDirectory::File& aFile) noexcept;
+
+	// Profiles of a root have changed
+	void removeProfile(ProfileToken aProfile) noexcept;
+	void clear() noexcept;
+private:
+	// Hubs with different settings (or hubs that requested the bloom with an older file count)
+	// may use different parameters for the same profile
+	static const size_t MAX_PROFILE_BLOOMS = 3;
+
+	// Most recently used first
+	using BloomList = vector<unique_ptr<CountingHashBloom>>;
+	unordered_map<ProfileToken, BloomList> blooms;
+
+	// Blooms may be created concurrently by multiple readers
+	CriticalSection cs;
+};
+
+} // namespace dcpp
+
+#endif // !defined(DCPLUSPLUS_DCPP_SHARE_PROFILE_BLOOMS_H)
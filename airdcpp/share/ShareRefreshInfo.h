@@ -56,7 +56,9 @@ public:
 	string path;
 
 	bool checkContent(const ShareDirectory::Ptr& aDirectory) noexcept;
-	void applyRefreshChanges(ShareDirectory::MultiMap& lowerDirNameMap_, ShareDirectory::Map& rootPaths_, ShareDirectory::File::TTHMap& tthIndex_, int64_t& sharedBytes_, ProfileTokenSet* dirtyProfiles) noexcept;
+
+	// The indices must have been merged by the share tree before calling this
+	void applyRefreshChanges(ShareDirectory::Map& rootPaths_, int64_t& sharedBytes_, ProfileTokenSet* dirtyProfiles) noexcept;
 
 	ShareRefreshInfo(ShareRefreshInfo&) = delete;
 	ShareRefreshInfo& operator=(ShareRefreshInfo&) = delete;
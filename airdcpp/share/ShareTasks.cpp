@@ -68,7 +68,7 @@ ShareRefreshInfo::ShareRefreshInfo(const string& aPath, const ShareDirectory::Pt
 bool ShareRefreshInfo::checkContent(const ShareDirectory::Ptr& aDirectory) noexcept {
 	if (SETTING(SKIP_EMPTY_DIRS_SHARE) && aDirectory->getDirectories().empty() && aDirectory->getFiles().empty()) {
 		// Remove from parent
-		ShareDirectory::cleanIndices(*aDirectory.get(), stats.addedSize, tthIndex, lowerDirNameMap);
+		ShareDirectory::cleanIndices(*aDirectory.get(), stats.addedSize, *this);
 		return false;
 	}
 
@@ -76,20 +76,7 @@ bool ShareRefreshInfo::checkContent(const ShareDirectory::Ptr& aDirectory) noexc
 }
 
 
-void ShareRefreshInfo::applyRefreshChanges(ShareDirectory::MultiMap& lowerDirNameMap_, ShareDirectory::Map& rootPaths_, ShareDirectory::File::TTHMap& tthIndex_, int64_t& sharedBytes_, ProfileTokenSet* dirtyProfiles_) noexcept {
-#ifdef _DEBUG
-	for (const auto& d : lowerDirNameMap | views::values) {
-		ShareDirectory::checkAddedDirNameDebug(d, lowerDirNameMap_);
-	}
-
-	for (const auto& f : tthIndex | views::values) {
-		ShareDirectory::File::checkAddedTTHDebug(f, tthIndex_);
-	}
-#endif
-
-	lowerDirNameMap_.insert(lowerDirNameMap.begin(), lowerDirNameMap.end());
-	tthIndex_.insert(tthIndex.begin(), tthIndex.end());
-
+void ShareRefreshInfo::applyRefreshChanges(ShareDirectory::Map& rootPaths_, int64_t& sharedBytes_, ProfileTokenSet* dirtyProfiles_) noexcept {
 	// Add new roots
 	for (const auto& [p, rootDir] : rootPaths) {
 		//dcassert(rootPaths_.find(rp.first) == rootPaths_.end());
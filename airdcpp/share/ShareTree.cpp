@@ -42,7 +42,7 @@ using ranges::find_if;
 using ranges::copy;
 
 
-ShareTree::ShareTree() : bloom(make_unique<ShareBloom>(1 << 20)), ShareTreeMaps([this] { return bloom.get(); })
+ShareTree::ShareTree() : bloom(make_unique<ShareBloom>(1 << 20)), ShareTreeMaps([this] { return bloom.get(); }, &profileBlooms, &uploadCache)
 {
 #if defined(_DEBUG) && defined(_WIN32)
 	testDualString();
@@ -50,16 +50,15 @@ ShareTree::ShareTree() : bloom(make_unique<ShareBloom>(1 << 20)), ShareTreeMaps(
 }
 
 void ShareTree::getRealPaths(const TTHValue& aTTH, StringList& paths_) const noexcept {
-	RLock l(cs);
-	const auto i = tthIndex.equal_range(const_cast<TTHValue*>(&aTTH));
-	for (const auto& f: i | pair_to_range | views::values) {
+	RLock l(indexCS);
+	for (const auto& f: tthIndex.findAll(aTTH)) {
 		paths_.push_back(f->getRealPath());
 	}
 }
 
 bool ShareTree::isFileShared(const TTHValue& aTTH) const noexcept {
-	RLock l(cs);
-	return tthIndex.contains(const_cast<TTHValue*>(&aTTH));
+	RLock l(indexCS);
+	return tthIndex.contains(aTTH);
 }
 
 bool ShareTree::toRealWithSize(const UploadFileQuery& aQuery, string& path_, int64_t& size_, bool& noAccess_) const noexcept {
@@ -67,13 +66,18 @@ bool ShareTree::toRealWithSize(const UploadFileQuery& aQuery, string& path_, int
 		return false;
 	}
 
-	RLock l(cs);
-	const auto flst = tthIndex.equal_range(const_cast<TTHValue*>(&aQuery.tth));
-	for(const auto& file: flst | pair_to_range | views::values) {
+	if (uploadCache.get(aQuery.tth, aQuery.profiles, path_, size_)) {
+		noAccess_ = false;
+		return true;
+	}
+
+	RLock l(indexCS);
+	for(const auto& file: tthIndex.findAll(aQuery.tth)) {
 		if (!aQuery.profiles || file->getParent()->hasProfile(*aQuery.profiles)) {
 			noAccess_ = false;
 			path_ = file->getRealPath();
 			size_ = file->getSize();
+			uploadCache.add(aQuery.tth, path_, size_, file->getParent()->getRootProfiles());
 			return true;
 		} else {
 			noAccess_ = true;
@@ -84,9 +88,9 @@ bool ShareTree::toRealWithSize(const UploadFileQuery& aQuery, string& path_, int
 }
 
 AdcCommand ShareTree::getFileInfo(const TTHValue& aTTH) const {
-	RLock l(cs);
-	if (auto i = tthIndex.find(const_cast<TTHValue*>(&aTTH)); i != tthIndex.end()) {
-		const ShareDirectory::File* f = i->second;
+	RLock l(indexCS);
+	if (auto i = tthIndex.find(aTTH); i) {
+		const ShareDirectory::File* f = *i;
 		AdcCommand cmd(AdcCommand::CMD_RES);
 		cmd.addParam("FN", f->getAdcPath());
 		cmd.addParam("SI", Util::toString(f->getSize()));
@@ -158,16 +162,13 @@ string ShareTree::validateVirtualName(const string& aVirt) const noexcept {
 }
 
 void ShareTree::countStats(time_t& totalAge_, size_t& totalDirs_, int64_t& totalSize_, size_t& totalFiles_, size_t& uniqueFiles, size_t& lowerCaseFiles_, size_t& totalStrLen_, size_t& roots_) const noexcept{
-	unordered_set<decltype(tthIndex)::key_type> uniqueTTHs;
-
 	RLock l(cs);
 
-	for (auto tth : tthIndex | views::keys) {
-		uniqueTTHs.insert(tth);
+	{
+		RLock li(indexCS);
+		uniqueFiles = tthIndex.keyCount();
 	}
 
-	uniqueFiles = uniqueTTHs.size();
-
 	for (const auto& d : rootPaths | views::values) {
 		totalDirs_++;
 		roots_++;
@@ -283,9 +284,8 @@ void ShareTree::getDirectoriesByAdcNameUnsafe(const string& aAdcPath, ShareDirec
 }
 
 bool ShareTree::isFileShared(const TTHValue& aTTH, ProfileToken aProfile) const noexcept{
-	RLock l (cs);
-	const auto files = tthIndex.equal_range(const_cast<TTHValue*>(&aTTH));
-	for(auto f: files | pair_to_range | views::values) {
+	RLock l(indexCS);
+	for(auto f: tthIndex.findAll(aTTH)) {
 		if (f->getParent()->hasProfile(aProfile)) {
 			return true;
 		}
@@ -311,9 +311,8 @@ ShareDirectory::File::ConstSet ShareTree::findFiles(const TTHValue& aTTH) const
 	ShareDirectory::File::ConstSet ret;
 
 	{
-		RLock l(cs);
-		auto files = tthIndex.equal_range(const_cast<TTHValue*>(&aTTH));
-		for (auto& f : files | pair_to_range | views::values) {
+		RLock l(indexCS);
+		for (auto& f : tthIndex.findAll(aTTH)) {
 			ret.insert_sorted(f);
 		}
 	}
@@ -403,18 +402,20 @@ ShareRoot::Ptr ShareTree::removeShareRoot(const string& aPath) noexcept {
 	ShareDirectory::Ptr directory = nullptr;
 
 	{
-		WLock l(cs);
-		auto k = rootPaths.find(aPath);
-		if (k == rootPaths.end()) {
-			return nullptr;
-		}
-
-		directory = k->second;
+		Lock w(writeCS);
+		{
+			WLock l(cs);
+			auto k = rootPaths.find(aPath);
+			if (k == rootPaths.end()) {
+				return nullptr;
+			}
 
-		rootPaths.erase(k);
+			directory = k->second;
+			rootPaths.erase(k);
+		}
 
 		// Remove the root
-		ShareDirectory::cleanIndices(*directory, sharedSize, tthIndex, lowerDirNameMap);
+		removeDetachedDirectory(*directory);
 	}
 
 	File::deleteFile(directory->getRoot()->getCacheXmlPath());
@@ -428,11 +429,15 @@ ShareRoot::Ptr ShareTree::removeShareRoot(const string& aPath) noexcept {
 
 void ShareTree::removeProfile(ProfileToken aProfile, StringList& rootsToRemove_) noexcept {
 	WLock l(cs);
+	WLock li(indexCS);
 	for (auto const& [path, root] : rootPaths) {
 		if (root->getRoot()->removeRootProfile(aProfile)) {
 			rootsToRemove_.push_back(path);
 		}
 	}
+
+	profileBlooms.removeProfile(aProfile);
+	uploadCache.clear();
 }
 
 ShareRoot::Ptr ShareTree::updateShareRoot(const ShareDirectoryInfoPtr& aDirectoryInfo) noexcept {
@@ -441,6 +446,7 @@ ShareRoot::Ptr ShareTree::updateShareRoot(const ShareDirectoryInfoPtr& aDirector
 	auto vName = validateVirtualName(aDirectoryInfo->virtualName);
 	{
 		WLock l(cs);
+		WLock li(indexCS);
 		auto directory = findRootUnsafe(aDirectoryInfo->path);
 		if (!directory) {
 			return nullptr;
@@ -451,10 +457,15 @@ ShareRoot::Ptr ShareTree::updateShareRoot(const ShareDirectoryInfoPtr& aDirector
 		ShareDirectory::removeDirName(*directory, lowerDirNameMap);
 		rootDirectory->setName(vName);
 		ShareDirectory::addDirName(directory, lowerDirNameMap, *bloom.get());
-	}
 
-	rootDirectory->setIncoming(aDirectoryInfo->incoming);
-	rootDirectory->setRootProfiles(aDirectoryInfo->profiles);
+		rootDirectory->setIncoming(aDirectoryInfo->incoming);
+
+		// Files of the root may belong to different profiles now (the cached data must be dropped
+		// in the same section so that removed files are never matched against the new profiles)
+		rootDirectory->setRootProfiles(aDirectoryInfo->profiles);
+		profileBlooms.clear();
+		uploadCache.clear();
+	}
 
 #ifdef _DEBUG
 	validateDirectoryTreeDebug();
@@ -464,50 +475,128 @@ ShareRoot::Ptr ShareTree::updateShareRoot(const ShareDirectoryInfoPtr& aDirector
 }
 
 bool ShareTree::applyRefreshChanges(ShareRefreshInfo& ri, ProfileTokenSet* aDirtyProfiles) {
-	ShareDirectory* parent = nullptr;
+	Lock w(writeCS);
 
-	WLock l(cs);
+	auto oldDirectory = ri.optionalOldDirectory;
+	auto newDirectory = ri.newDirectory;
+	auto isRoot = oldDirectory && oldDirectory->isRoot();
 
-	// Recursively remove the content of this dir from TTHIndex and directory name map
-	if (ri.optionalOldDirectory) {
+	if (isRoot) {
 		// Root removed while refreshing?
-		if (ri.optionalOldDirectory->isRoot() && !findRootUnsafe(ri.path)) {
+		RLock l(cs);
+		if (!findRootUnsafe(ri.path)) {
 			return false;
 		}
-
-		parent = ri.optionalOldDirectory->getParent();
-
-		// Remove the old directory
-		ShareDirectory::cleanIndices(*ri.optionalOldDirectory, sharedSize, tthIndex, lowerDirNameMap);
 	}
 
-	// Set the parent for refreshed subdirectories
+	// Link the parent for refreshed subdirectories
 	// (previous directory should always be available for roots)
-	if (!ri.optionalOldDirectory || !ri.optionalOldDirectory->isRoot()) {
-		// All content was removed?
-		if (!ri.checkContent(ri.newDirectory)) {
-			return false;
-		}
-
+	ShareDirectory* parent = nullptr;
+	auto addNew = isRoot || ri.checkContent(newDirectory); // All content was removed?
+	if (addNew && !isRoot) {
+		WLock l(cs);
+		parent = oldDirectory ? oldDirectory->getParent() : nullptr;
 		if (!parent) {
 			// Create new parent
 			auto newParent = ensureDirectoryUnsafe(PathUtil::getParentDir(ri.path));
-			if (!newParent) {
-				return false;
-			} else {
-				parent = newParent.get();
-			}
+			parent = newParent.get();
 		}
 
-		// Set the parent
-		if (!ShareDirectory::setParent(ri.newDirectory, parent)) {
-			return false;
+		if (parent) {
+			ShareDirectory::linkParent(*newDirectory, parent);
+		} else {
+			addNew = false;
 		}
 	}
 
-	ri.applyRefreshChanges(lowerDirNameMap, rootPaths, tthIndex, sharedSize, aDirtyProfiles);
+	// Files of the new directory can be found from the index before the directory is in the tree
+	// and files of the old directory until the directory has been replaced
+	if (addNew) {
+		addIndicesBatched(ri);
+	}
+
+	auto added = false;
+	{
+		WLock l(cs);
+		if (oldDirectory) {
+			ShareDirectory::detach(*oldDirectory);
+		}
+
+		if (addNew) {
+			// Set the parent
+			added = isRoot || ShareDirectory::setParent(newDirectory, parent);
+			if (added) {
+				ri.applyRefreshChanges(rootPaths, sharedSize, aDirtyProfiles);
+			}
+		}
+	}
+
+	if (addNew && !added) {
+		removeIndicesBatched(*newDirectory);
+	}
+
+	// Recursively remove the content of the old directory from TTHIndex and directory name map
+	if (oldDirectory) {
+		removeDetachedDirectory(*oldDirectory);
+	}
+
 	dcdebug("Share changes applied for the directory %s\n", ri.path.c_str());
-	return true;
+	return added;
+}
+
+void ShareTree::addIndicesBatched(ShareRefreshInfo& ri) noexcept {
+	forEachBatch(ri.lowerDirNameMap, cs, [this](const auto& aName) {
+#ifdef _DEBUG
+		ShareDirectory::checkAddedDirNameDebug(aName.second, lowerDirNameMap);
+#endif
+		lowerDirNameMap.insert(aName);
+	});
+
+	{
+		WLock l(indexCS);
+		tthIndex.reserve(tthIndex.keyCount() + ri.tthIndex.keyCount());
+	}
+
+	forEachBatch(ri.tthIndex, indexCS, [this](const auto& aEntry) {
+		const auto& [tth, file] = aEntry;
+#ifdef _DEBUG
+		ShareDirectory::File::checkAddedTTHDebug(file, tthIndex);
+#endif
+		tthIndex.emplace(tth, file);
+
+		// Refreshed files weren't added in the profile blooms by the task
+		profileBlooms.addFile(*file);
+	});
+}
+
+void ShareTree::removeDetachedDirectory(const ShareDirectory& aDirectory) noexcept {
+	auto size = aDirectory.getTotalSize();
+	{
+		WLock l(cs);
+		sharedSize -= size;
+	}
+
+	removeIndicesBatched(aDirectory);
+}
+
+void ShareTree::removeIndicesBatched(const ShareDirectory& aDirectory) noexcept {
+	// The directory isn't in the tree anymore so its content won't change
+	vector<const ShareDirectory*> directories;
+	vector<const ShareDirectory::File*> files;
+	aDirectory.getContentRecursive(directories, files);
+
+	forEachBatch(directories, cs, [this](const ShareDirectory* aDir) {
+		ShareDirectory::removeDirName(*aDir, lowerDirNameMap);
+	});
+
+	forEachBatch(files, indexCS, [this](const ShareDirectory::File* aFile) {
+		profileBlooms.removeFile(*aFile);
+		uploadCache.remove(aFile->getTTH());
+
+		if (!tthIndex.erase(aFile->getTTH(), aFile)) {
+			dcassert(0);
+		}
+	});
 }
 
 ShareDirectoryInfoPtr ShareTree::getRootInfoUnsafe(const ShareDirectory::Ptr& aDir) const noexcept {
@@ -550,12 +639,8 @@ ShareDirectoryInfoList ShareTree::getRootInfos() const noexcept {
 }
 		
 void ShareTree::getBloom(ProfileToken aToken, HashBloom& bloom_) const noexcept {
-	RLock l(cs);
-	for (const auto& [tth, file] : tthIndex) {
-		if (file->hasProfile(aToken)) {
-			bloom_.add(*tth);
-		}
-	}
+	RLock l(indexCS);
+	profileBlooms.getBloom(aToken, bloom_, tthIndex);
 }
 
 void ShareTree::getBloomFileCount(ProfileToken aToken, size_t& fileCount_) const noexcept {
@@ -688,9 +773,8 @@ bool ShareTree::addDirectoryResultUnsafe(const ShareDirectory* aDir, SearchResul
 }
 
 void ShareTree::search(SearchResultList& results, const TTHValue& aTTH, const ShareSearch& aSearchInfo) const noexcept {
-	RLock l(cs);
-	const auto i = tthIndex.equal_range(const_cast<TTHValue*>(&aTTH));
-	for (auto& f : i | pair_to_range | views::values) {
+	RLock l(indexCS);
+	for (auto& f : tthIndex.findAll(aTTH)) {
 		if (f->hasProfile(aSearchInfo.profile) && PathUtil::isParentOrExactAdc(aSearchInfo.virtualPath, f->getAdcPath())) {
 			f->addSR(results, aSearchInfo.search.addParents);
 			return;
@@ -907,6 +991,7 @@ bool ShareTree::findFileByRealPath(const string& aPath, const ShareFileCallback&
 
 void ShareTree::addHashedFile(const string& aRealPath, const HashedFile& aFileInfo, ProfileTokenSet* dirtyProfiles) noexcept {
 	WLock l(cs);
+	WLock li(indexCS);
 	auto d = ensureDirectoryUnsafe(PathUtil::getFilePath(aRealPath));
 	if (!d) {
 		return;
@@ -945,6 +1030,7 @@ void ShareTree::testDualString() {
 
 void ShareTree::validateDirectoryTreeDebug() const noexcept {
 	RLock l(cs);
+	RLock li(indexCS);
 	OrderedStringSet directories, files;
 
 	auto start = GET_TICK();
@@ -997,8 +1083,7 @@ void ShareTree::validateDirectoryRecursiveDebugUnsafe(const ShareDirectory::Ptr&
 
 	int64_t realDirectorySize = 0;
 	for (const auto& f : aDir->getFiles()) {
-		auto flst = tthIndex.equal_range(const_cast<TTHValue*>(&f->getTTH()));
-		dcassert(ranges::count_if(flst | pair_to_range | views::values, [&](const ShareDirectory::File* aFile) {
+		dcassert(ranges::count_if(tthIndex.findAll(f->getTTH()), [&](const ShareDirectory::File* aFile) {
 			return aFile->getRealPath() == f->getRealPath();
 		}) == 1);
 
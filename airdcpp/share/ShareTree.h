@@ -27,7 +27,9 @@
 #include <airdcpp/hash/value/MerkleTree.h>
 #include <airdcpp/share/ShareDirectory.h>
 #include <airdcpp/share/ShareDirectoryInfo.h>
+#include <airdcpp/share/ShareProfileBlooms.h>
 #include <airdcpp/share/ShareStats.h>
+#include <airdcpp/share/ShareUploadCache.h>
 #include <airdcpp/core/classes/SortedVector.h>
 #include <airdcpp/share/UploadFileProvider.h>
 #include <airdcpp/connection/UserConnection.h>
@@ -175,12 +177,54 @@ public:
 
 	SharedMutex& getCS() const noexcept { return cs; }
 private:
+	// Directory tree, root paths, directory names and the search bloom
+	// Refreshes hold the write lock only while applying each batch of changes
 	mutable SharedMutex cs;
 
+	// TTH index, profile blooms and the data that is needed for resolving paths of indexed files
+	// (root paths, names and profiles)
+	// Uploads won't need to wait for the tree lock, which is held for long periods when generating file lists
+	// Lock order: cs -> indexCS
+	mutable SharedMutex indexCS;
+
+	// Only one refresh/removal may modify the indices at a time (readers never lock this)
+	CriticalSection writeCS;
+
+	// Maximum number of items to update while holding the write lock
+	static const size_t INDEX_BATCH_SIZE = 2048;
+
+	// Apply changes for a large number of items in batches so that readers won't need to wait for the whole update
+	template<class RangeT, class HandlerT>
+	static void forEachBatch(const RangeT& aItems, SharedMutex& aCS, const HandlerT& aHandler) noexcept {
+		auto i = ranges::begin(aItems);
+		const auto end = ranges::end(aItems);
+		while (i != end) {
+			WLock l(aCS);
+			for (size_t count = 0; count < INDEX_BATCH_SIZE && i != end; ++count, ++i) {
+				aHandler(*i);
+			}
+		}
+	}
+
+	// Add the content of a refreshed directory in the indices before it's added in the tree
+	void addIndicesBatched(ShareRefreshInfo& ri) noexcept;
+
+	// Remove the content of a directory that is no longer in the tree from the indices
+	void removeIndicesBatched(const ShareDirectory& aDirectory) noexcept;
+
+	// Remove a directory that has been removed from the tree from the indices and the shared size
+	void removeDetachedDirectory(const ShareDirectory& aDirectory) noexcept;
+
 	bool matchBloom(const SearchQuery& aSearch) const noexcept;
 
 	unique_ptr<ShareBloom> bloom;
 
+	// TTH blooms requested by hubs
+	mutable ShareProfileBlooms profileBlooms;
+
+	// Has its own locks so that repeated upload requests won't need to wait for the index lock
+	mutable ShareUploadCache uploadCache;
+
 	ShareDirectoryInfoPtr getRootInfoUnsafe(const ShareDirectory::Ptr& aDir) const noexcept;
 
 	bool addDirectoryResultUnsafe(const ShareDirectory* aDir, SearchResultList& aResults, const OptionalProfileToken& aProfile, const SearchQuery& srch) const noexcept;
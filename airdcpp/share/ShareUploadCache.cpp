@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2011-2024 AirDC++ Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "stdinc.h"
+#include <airdcpp/share/ShareUploadCache.h>
+
+namespace dcpp {
+
+bool ShareUploadCache::get(const TTHValue& aTTH, const ProfileTokenSet* aProfiles, string& path_, int64_t& size_) noexcept {
+	auto& shard = getShard(aTTH);
+
+	Lock l(shard.cs);
+	auto i = shard.index.find(aTTH);
+	if (i == shard.index.end()) {
+		return false;
+	}
+
+	const auto& location = *i->second;
+	if (aProfiles && ranges::none_of(*aProfiles, [&](auto profile) { return location.profiles.contains(profile); })) {
+		// There may be other copies that are available for these profiles
+		return false;
+	}
+
+	// Move to front
+	shard.locations.splice(shard.locations.begin(), shard.locations, i->second);
+
+	path_ = location.path;
+	size_ = location.size;
+	return true;
+}
+
+void ShareUploadCache::add(const TTHValue& aTTH, const string& aPath, int64_t aSize, ProfileTokenSet&& aProfiles) noexcept {
+	auto& shard = getShard(aTTH);
+
+	Lock l(shard.cs);
+	if (auto i = shard.index.find(aTTH); i != shard.index.end()) {
+		shard.locations.erase(i->second);
+		shard.index.erase(i);
+	} else if (shard.locations.size() >= MAX_SHARD_SIZE) {
+		// Evict the least recently used file
+		shard.index.erase(shard.locations.back().tth);
+		shard.locations.pop_back();
+	}
+
+	shard.locations.push_front(Location({ aTTH, aPath, aSize, std::move(aProfiles) }));
+	shard.index.emplace(aTTH, shard.locations.begin());
+}
+
+void ShareUploadCache::remove(const TTHValue& aTTH) noexcept {
+	auto& shard = getShard(aTTH);
+
+	Lock l(shard.cs);
+	if (auto i = shard.index.find(aTTH); i != shard.index.end()) {
+		shard.locations.erase(i->second);
+		shard.index.erase(i);
+	}
+}
+
+void ShareUploadCache::clear() noexcept {
+	for (auto& shard : shards) {
+		Lock l(shard.cs);
+		shard.index.clear();
+		shard.locations.clear();
+	}
+}
+
+} // namespace dcpp
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2011-2024 AirDC++ Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef DCPLUSPLUS_DCPP_SHARE_UPLOAD_CACHE_H
+#define DCPLUSPLUS_DCPP_SHARE_UPLOAD_CACHE_H
+
+#include <airdcpp/core/header/typedefs.h>
+
+#include <airdcpp/core/thread/CriticalSection.h>
+#include <airdcpp/hash/value/MerkleTree.h>
+
+namespace dcpp {
+
+// Locations of recently uploaded files
+// Upload requests for files that have been resolved earlier (e.g. all segments after the first one)
+// don't need to lock the share tree, which may be held by refreshes for long periods
+//
+// Files must be removed from the cache while holding the write lock of the TTH index
+// and added while holding the read lock so that removed files won't get re-added
+class ShareUploadCache {
+public:
+	// Returns false if the file isn't cached or it isn't available in any of the wanted profiles
+	bool get(const TTHValue& aTTH, const ProfileTokenSet* aProfiles, string& path_, int64_t& size_) noexcept;
+
+	void add(const TTHValue& aTTH, const string& aPath, int64_t aSize, ProfileTokenSet&& aProfiles) noexcept;
+	void remove(const TTHValue& aTTH) noexcept;
+
+	void clear() noexcept;
+private:
+	struct Location {
+		TTHValue tth;
+		string path;
+		int64_t size;
+		ProfileTokenSet profiles;
+	};
+
+	// The least recently used files are evicted when a shard gets full
+	static const size_t SHARD_COUNT = 16;
+	static const size_t MAX_SHARD_SIZE = 512;
+
+	struct Shard {
+		// Most recently used first
+		std::list<Location> locations;
+		unordered_map<TTHValue, std::list<Location>::iterator> index;
+
+		// Lookups update the order as well
+		CriticalSection cs;
+	};
+
+	Shard& getShard(const TTHValue& aTTH) noexcept {
+		return shards[aTTH.data[0] % SHARD_COUNT];
+	}
+
+	array<Shard, SHARD_COUNT> shards;
+};
+
+} // namespace dcpp
+
+#endif // !defined(DCPLUSPLUS_DCPP_SHARE_UPLOAD_CACHE_H)
@@ -28,7 +28,7 @@
 #include <airdcpp/util/PathUtil.h>
 #include <airdcpp/queue/QueueItem.h>
 #include <airdcpp/settings/SettingsManager.h>
-#include <airdcpp/core/io/stream/SharedFileStream.h>
+#include <airdcpp/core/io/stream/SegmentOutputStream.h>
 #include <airdcpp/core/io/stream/Streams.h>
 #include <airdcpp/connection/UserConnection.h>
 #include <airdcpp/core/io/compress/ZUtils.h>
@@ -265,21 +265,16 @@ void Download::open(int64_t bytes, bool z, bool aHasDownloadedBytes) {
 			File::ensureDirectory(target);
 		}
 
-		int fileFlags = File::OPEN | File::CREATE | File::SHARED_WRITE;
+		SegmentOutputStream::Options options;
+		options.bufferSize = static_cast<size_t>(max(SETTING(BUFFER_SIZE), 0)) * 1024;
+		options.preallocate = SETTING(PREALLOCATE_DOWNLOADS);
+		options.dropCache = SETTING(DOWNLOAD_DROP_CACHE);
 		if (getSegment().getEnd() != fullSize) {
 			// Segmented download, let Windows decide the buffering
-			fileFlags |= File::BUFFER_AUTO;
+			options.fileFlags |= File::BUFFER_AUTO;
 		}
 
-		auto f = make_unique<SharedFileStream>(target, File::WRITE, fileFlags);
-
-		if(f->getSize() != fullSize) {
-			f->setSize(fullSize);
-		}
-
-		f->setPos(getSegment().getStart());
-
-		output = std::move(f);
+		output = make_unique<SegmentOutputStream>(target, fullSize, getSegment().getStart(), options);
 		tempTarget = target;
 	} else if(getType() == Transfer::TYPE_FULL_LIST) {
 		auto target = getPath();
@@ -299,7 +294,7 @@ void Download::open(int64_t bytes, bool z, bool aHasDownloadedBytes) {
 		output.reset(new MerkleTreeOutputStream<TigerTree>(tt));
 	}
 
-	if((getType() == Transfer::TYPE_FILE || getType() == Transfer::TYPE_FULL_LIST) && SETTING(BUFFER_SIZE) > 0 ) {
+	if(getType() == Transfer::TYPE_FULL_LIST && SETTING(BUFFER_SIZE) > 0) {
 		output.reset(new BufferedOutputStream<true>(output.release()));
 	}
 
@@ -554,11 +554,13 @@ string Util::formatFileType(const string& aPath) noexcept {
 #define MIN_REMOTE_FILE_ITEM_DATE 946684800 // 1/1/2000
 
 time_t Util::parseRemoteFileItemDate(const string& aString) noexcept {
-	auto date = static_cast<time_t>(toInt64(aString)); // handle negative values too
+	return validateRemoteFileItemDate(static_cast<time_t>(toInt64(aString))); // handle negative values too
+}
 
+time_t Util::validateRemoteFileItemDate(time_t aDate) noexcept {
 	// Avoid using really old dates as those are most likely invalid and 
 	// would confuse the client/user (e.g. with grouped search results)
-	return date <= MIN_REMOTE_FILE_ITEM_DATE ? 0 : date;
+	return aDate <= MIN_REMOTE_FILE_ITEM_DATE ? 0 : aDate;
 }
 
 /* natural sorting */
@@ -212,6 +212,7 @@ public:
 	}
 
 	static time_t parseRemoteFileItemDate(const string& aString) noexcept;
+	static time_t validateRemoteFileItemDate(time_t aDate) noexcept;
 
 	static int toInt(const string& aString) noexcept {
 		return atoi(aString.c_str());
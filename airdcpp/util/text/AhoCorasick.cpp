@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2011-2024 AirDC++ Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "stdinc.h"
+#include <airdcpp/util/text/AhoCorasick.h>
+
+namespace dcpp {
+
+AhoCorasick::PatternId AhoCorasick::addPattern(const string& aPattern) noexcept {
+	dcassert(!aPattern.empty());
+	built = false;
+
+	uint32_t state = ROOT;
+	for (auto c: aPattern) {
+		auto& edges = nodes[state].edges;
+		auto e = ranges::find_if(edges, [c](const auto& aEdge) { return aEdge.first == static_cast<uint8_t>(c); });
+		if (e != edges.end()) {
+			state = e->second;
+			continue;
+		}
+
+		auto n = static_cast<uint32_t>(nodes.size());
+		edges.emplace_back(static_cast<uint8_t>(c), n);
+		nodes.emplace_back();
+		state = n;
+	}
+
+	auto& node = nodes[state];
+	if (node.pattern == NO_PATTERN) {
+		node.pattern = static_cast<PatternId>(patternLengths.size());
+		patternLengths.push_back(aPattern.size());
+	}
+
+	return node.pattern;
+}
+
+uint32_t AhoCorasick::findEdge(uint32_t aNode, uint8_t aChar) const noexcept {
+	const auto& edges = nodes[aNode].edges;
+	if (edges.size() <= 8) {
+		for (const auto& [c, n]: edges) {
+			if (c == aChar) {
+				return n;
+			}
+		}
+
+		return NO_NODE;
+	}
+
+	auto e = lower_bound(edges.begin(), edges.end(), aChar, [](const pair<uint8_t, uint32_t>& aEdge, uint8_t aC) { return aEdge.first < aC; });
+	return e != edges.end() && e->first == aChar ? e->second : NO_NODE;
+}
+
+void AhoCorasick::build() noexcept {
+	for (auto& node: nodes) {
+		ranges::sort(node.edges);
+	}
+
+	rootEdges.fill(ROOT);
+
+	// Breadth-first so that the failure targets (shorter suffixes) are always ready
+	vector<uint32_t> queue;
+	queue.reserve(nodes.size());
+	for (const auto& [c, n]: nodes[ROOT].edges) {
+		rootEdges[c] = n;
+		nodes[n].fail = ROOT;
+		nodes[n].outputLink = NO_NODE;
+		queue.push_back(n);
+	}
+
+	for (size_t i = 0; i < queue.size(); ++i) {
+		auto parent = queue[i];
+		for (const auto& [c, n]: nodes[parent].edges) {
+			auto fail = next(nodes[parent].fail, c);
+			nodes[n].fail = fail;
+			nodes[n].outputLink = nodes[fail].pattern != NO_PATTERN ? fail : nodes[fail].outputLink;
+			queue.push_back(n);
+		}
+	}
+
+	built = true;
+}
+
+void AhoCorasick::clear() noexcept {
+	nodes.clear();
+	nodes.emplace_back();
+	patternLengths.clear();
+	rootEdges.fill(ROOT);
+	built = false;
+}
+
+} // namespace dcpp
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2011-2024 AirDC++ Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef DCPLUSPLUS_DCPP_AHO_CORASICK_H
+#define DCPLUSPLUS_DCPP_AHO_CORASICK_H
+
+#include <airdcpp/core/header/debug.h>
+#include <airdcpp/core/header/typedefs.h>
+
+namespace dcpp {
+
+// Aho-Corasick automaton for finding the occurrences of multiple byte patterns with a single pass over the text
+//
+// Patterns are added first and the automaton is built with build() before matching. Matching is case-sensitive,
+// callers handle the case folding (patterns and texts are generally lowercase).
+class AhoCorasick {
+public:
+	using PatternId = uint32_t;
+
+	// Returns the ID of the pattern (identical patterns share the same ID)
+	// Empty patterns aren't allowed
+	PatternId addPattern(const string& aPattern) noexcept;
+
+	// Calculates the failure links, must be called after the patterns have been added
+	void build() noexcept;
+	void clear() noexcept;
+
+	bool empty() const noexcept { return patternLengths.empty(); }
+	size_t getPatternCount() const noexcept { return patternLengths.size(); }
+	size_t getPatternLength(PatternId aPattern) const noexcept { return patternLengths[aPattern]; }
+
+	// Calls aMatchF(PatternId, size_t aStartPos) for each occurrence in the order of the end positions
+	// (occurrences with the same end position are reported from the longest pattern)
+	// Matching stops if the handler returns false
+	template<typename MatchF>
+	void match(string_view aText, const MatchF& aMatchF) const noexcept {
+		dcassert(built || empty());
+		uint32_t state = ROOT;
+		for (size_t pos = 0; pos < aText.size(); ++pos) {
+			state = next(state, static_cast<uint8_t>(aText[pos]));
+
+			for (auto s = nodes[state].pattern != NO_PATTERN ? state : nodes[state].outputLink; s != NO_NODE; s = nodes[s].outputLink) {
+				auto pattern = nodes[s].pattern;
+				if (!aMatchF(pattern, pos + 1 - patternLengths[pattern])) {
+					return;
+				}
+			}
+		}
+	}
+private:
+	static const uint32_t ROOT = 0;
+	static const uint32_t NO_NODE = static_cast<uint32_t>(-1);
+	static const PatternId NO_PATTERN = static_cast<PatternId>(-1);
+
+	struct Node {
+		// Sorted by the character after the automaton has been built
+		vector<pair<uint8_t, uint32_t>> edges;
+
+		uint32_t fail = ROOT;
+
+		// The next node in the failure chain that ends a pattern
+		uint32_t outputLink = NO_NODE;
+		PatternId pattern = NO_PATTERN;
+	};
+
+	uint32_t findEdge(uint32_t aNode, uint8_t aChar) const noexcept;
+
+	uint32_t next(uint32_t aState, uint8_t aChar) const noexcept {
+		while (aState != ROOT) {
+			auto n = findEdge(aState, aChar);
+			if (n != NO_NODE) {
+				return n;
+			}
+
+			aState = nodes[aState].fail;
+		}
+
+		return rootEdges[aChar];
+	}
+
+	vector<Node> nodes = vector<Node>(1);
+	vector<size_t> patternLengths;
+
+	// Transitions from the root are looked up for most of the characters
+	array<uint32_t, 256> rootEdges {};
+	bool built = false;
+};
+
+} // namespace dcpp
+
+#endif // !defined(DCPLUSPLUS_DCPP_AHO_CORASICK_H)
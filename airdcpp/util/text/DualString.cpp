@@ -21,6 +21,11 @@
 #include <airdcpp/util/text/DualString.h>
 #include <airdcpp/util/text/Text.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DCPP_DUALSTRING_SSE2
+#endif
+
 using std::string;
 
 #define ARRAY_BITS (sizeof(MaskType)*8)
@@ -33,6 +38,11 @@ DualString::DualString(const string& aStr) : str(dcpp::Text::toLower(aStr)) {
 
 // Set possible uppercase characters
 void DualString::init(const string& aNormalStr) noexcept {
+	if (aNormalStr.size() == str.size() && dcpp::Text::asciiPrefixLength(aNormalStr.data(), aNormalStr.size()) == aNormalStr.size()) {
+		initAscii(aNormalStr);
+		return;
+	}
+
 	int arrayPos = 0, bitPos = 0;
 	auto iNormal = aNormalStr.c_str();
 	auto iLower = str.c_str();
@@ -42,7 +52,8 @@ void DualString::init(const string& aNormalStr) noexcept {
 		int nLower = dcpp::Text::utf8ToWc(iLower, cLower);
 		if (cNormal != cLower) {
 			if (!charSizes) {
-				initSizeArray(aNormalStr.size());
+				// The bits are indexed by the lowercase string, which may also be longer
+				initSizeArray(str.size());
 			}
 			charSizes.get()[arrayPos] |= (1 << bitPos);
 		}
@@ -60,6 +71,43 @@ void DualString::init(const string& aNormalStr) noexcept {
 	}
 }
 
+// Both strings contain ASCII characters only so the bits can be set by comparing the bytes directly
+void DualString::initAscii(const string& aNormalStr) noexcept {
+	const auto normal = aNormalStr.data();
+	const auto lower = str.data();
+	// Stop at the first null character similar to the generic version
+	const auto len = strlen(lower);
+
+	auto setBits = [this](size_t aPos, MaskType aBits) {
+		if (!charSizes) {
+			initSizeArray(str.size());
+		}
+
+		charSizes.get()[aPos / ARRAY_BITS] |= aBits << (aPos % ARRAY_BITS);
+	};
+
+	size_t i = 0;
+
+#ifdef DCPP_DUALSTRING_SSE2
+	// ARRAY_BITS is a multiple of 16 so the chunk bits never span across array items
+	for (; i + 16 <= len; i += 16) {
+		const auto chunkNormal = _mm_loadu_si128(reinterpret_cast<const __m128i*>(normal + i));
+		const auto chunkLower = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lower + i));
+		const auto equal = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunkNormal, chunkLower)));
+		const auto differs = ~equal & 0xFFFFu;
+		if (differs != 0) {
+			setBits(i, static_cast<MaskType>(differs));
+		}
+	}
+#endif
+
+	for (; i < len; ++i) {
+		if (normal[i] != lower[i]) {
+			setBits(i, 1);
+		}
+	}
+}
+
 size_t DualString::length() const noexcept {
 	return str.length();
 }
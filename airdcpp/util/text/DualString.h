@@ -47,6 +47,7 @@ public:
 	DualString& operator= (const DualString& other) = delete;
 private:
 	void init(const string& aNormalStr) noexcept;
+	void initAscii(const string& aNormalStr) noexcept;
 	size_t initSizeArray(size_t strLen) noexcept;
 	std::unique_ptr<MaskType[]> charSizes;
 
@@ -89,36 +89,142 @@ size_t StringSearch::Pattern::matchLower(const string& aText, int aStartPos) con
 
 
 void StringSearch::addString(const string& aStr) {
-	if (!aStr.empty())
-		patterns.emplace_back(Text::toLower(aStr));
+	if (aStr.empty())
+		return;
+
+	const auto& p = patterns.emplace_back(Text::toLower(aStr));
+	patternIds.push_back(automaton.addPattern(p.str()));
+	automatonBuilt = false;
+}
+
+StringSearch::StringSearch(const StringSearch& rhs) noexcept : patterns(rhs.patterns), patternIds(rhs.patternIds), automaton(rhs.getAutomaton()) {
+
+}
+
+StringSearch& StringSearch::operator=(const StringSearch& rhs) noexcept {
+	if (this != &rhs) {
+		patterns = rhs.patterns;
+		patternIds = rhs.patternIds;
+		automaton = rhs.getAutomaton();
+		automatonBuilt = true;
+	}
+
+	return *this;
+}
+
+const AhoCorasick& StringSearch::getAutomaton() const noexcept {
+	if (!automatonBuilt.load(memory_order_acquire)) {
+		Lock l(automatonCS);
+		if (!automatonBuilt.load(memory_order_relaxed)) {
+			automaton.build();
+			automatonBuilt.store(true, memory_order_release);
+		}
+	}
+
+	return automaton;
 }
 
 bool StringSearch::match_all(const string& aText) const {
 	auto text = Text::toLower(aText);
-	for (const auto& p : patterns) {
-		if (p.matchLower(text) == string::npos) {
-			return false;
-		}
+	if (patterns.size() == 1) {
+		return patterns.front().matchLower(text) != string::npos;
 	}
 
-	return true;
+	// Each distinct pattern must be found
+	const auto& ac = getAutomaton();
+	vector<bool> found(ac.getPatternCount(), false);
+	auto left = ac.getPatternCount();
+	ac.match(text, [&](AhoCorasick::PatternId aPattern, size_t) {
+		if (!found[aPattern]) {
+			found[aPattern] = true;
+			left--;
+		}
+
+		return left > 0;
+	});
+
+	return left == 0;
 }
 
 bool StringSearch::match_any_lower(const string& aText) const {
-	for (const auto& p : patterns) {
-		if (p.matchLower(aText) != string::npos) {
-			return true;
-		}
+	if (patterns.size() == 1) {
+		return patterns.front().matchLower(aText) != string::npos;
 	}
 
-	return false;
+	auto found = false;
+	getAutomaton().match(aText, [&found](AhoCorasick::PatternId, size_t) {
+		found = true;
+		return false;
+	});
+
+	return found;
 }
 
 bool StringSearch::match_any(const string& aText) const {
 	return match_any_lower(Text::toLower(aText));
 }
 
+StringSearch::OccurrenceList StringSearch::findAll(const string& aText) const noexcept {
+	OccurrenceList ret;
+	getAutomaton().match(aText, [&ret](AhoCorasick::PatternId aPattern, size_t aStartPos) {
+		ret.emplace_back(aPattern, aStartPos);
+		return true;
+	});
+
+	return ret;
+}
+
 int StringSearch::matchLower(const string& aText, bool aResumeOnNoMatch, ResultList* results_) const {
+	dcassert(Text::isLower(aText));
+	if (patterns.size() <= 1) {
+		return matchLowerSingle(aText, aResumeOnNoMatch, results_);
+	}
+
+	auto occurrences = findAll(aText);
+
+	int matches = 0;
+	for (size_t listPos = 0; listPos < patterns.size(); ++listPos) {
+		auto id = patternIds[listPos];
+
+		// Prefer sequential match order if this isn't the first pattern:
+		// pick the first occurrence after the previous pattern, or the last one if there are none
+		auto prevPos = results_ && listPos > 0 ? (*results_)[listPos - 1] : string::npos;
+
+		size_t first = string::npos, firstAfterPrev = string::npos, last = string::npos;
+		for (const auto& [pattern, pos]: occurrences) {
+			if (pattern != id) {
+				continue;
+			}
+
+			if (first == string::npos) {
+				first = pos;
+			}
+
+			if (prevPos != string::npos && firstAfterPrev == string::npos && pos >= prevPos) {
+				firstAfterPrev = pos;
+			}
+
+			last = pos;
+		}
+
+		auto addPos = prevPos == string::npos ? first : (firstAfterPrev != string::npos ? firstAfterPrev : last);
+		if (addPos != string::npos) {
+			matches++;
+			if (results_) {
+				(*results_)[listPos] = addPos;
+			}
+		} else if (!aResumeOnNoMatch) {
+			if (results_) {
+				fill_n((*results_).begin(), listPos, string::npos);
+			}
+			return 0;
+		}
+	}
+
+	return matches;
+}
+
+int StringSearch::matchLowerSingle(const string& aText, bool aResumeOnNoMatch, ResultList* results_) const {
 	int matches = 0, listPos = 0;
 	for (const auto& p: patterns) {
 		size_t addPos = string::npos;
@@ -159,6 +265,9 @@ int StringSearch::matchLower(const string& aText, bool aResumeOnNoMatch, ResultL
 
 void StringSearch::clear() {
 	patterns.clear();
+	patternIds.clear();
+	automaton.clear();
+	automatonBuilt = true;
 }
 
 string StringSearch::toString() const noexcept {
@@ -21,14 +21,17 @@
 
 #include <airdcpp/core/header/typedefs.h>
 
+#include <airdcpp/core/thread/CriticalSection.h>
+#include <airdcpp/util/text/AhoCorasick.h>
+
 namespace dcpp {
 
 /**
 * A class that implements a fast substring search algo suited for matching
-* one pattern against many strings (currently Quick Search, a variant of
-* Boyer-Moore. Code based on "A very fast substring search algorithm" by
-* D. Sunday).
-* @todo Perhaps find an algo suitable for matching multiple substrings.
+* patterns against many strings. Single patterns are matched with Quick Search,
+* a variant of Boyer-Moore (code based on "A very fast substring search algorithm"
+* by D. Sunday). Multiple patterns are matched with a single pass over the text
+* using an Aho-Corasick automaton.
 */
 class StringSearch {
 public:
@@ -64,6 +67,10 @@ public:
 
 	typedef vector<Pattern> PatternList;
 
+	StringSearch() = default;
+	StringSearch(const StringSearch& rhs) noexcept;
+	StringSearch& operator=(const StringSearch& rhs) noexcept;
+
 	bool match_all(const string& aText) const;
 	bool match_any(const string& aText) const;
 	bool match_any_lower(const string& aText) const;
@@ -79,7 +86,26 @@ public:
 	string toString() const noexcept;
 	StringList toStringList() const noexcept;
 private:
+	// Sequential matching with the individual patterns
+	int matchLowerSingle(const string& aText, bool aResumeOnNoMatch, ResultList* results_) const;
+
+	// Collects the occurrences of all patterns in order of the end positions
+	using Occurrence = pair<AhoCorasick::PatternId, size_t>;
+	using OccurrenceList = vector<Occurrence>;
+	OccurrenceList findAll(const string& aText) const noexcept;
+
 	PatternList patterns;
+
+	// Automaton pattern ID for each pattern (identical patterns share the ID)
+	vector<AhoCorasick::PatternId> patternIds;
+
+	// The automaton is built when it's needed for matching for the first time after adding patterns
+	// (matching may happen from multiple threads)
+	const AhoCorasick& getAutomaton() const noexcept;
+
+	mutable AhoCorasick automaton;
+	mutable atomic<bool> automatonBuilt = true;
+	mutable CriticalSection automatonCS;
 };
 
 } // namespace dcpp
@@ -30,6 +30,16 @@
 
 #include <airdcpp/util/Util.h>
 
+#include <bit>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DCPP_TEXT_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define DCPP_TEXT_NEON
+#endif
+
 namespace dcpp {
 
 namespace Text {
@@ -37,8 +47,23 @@ namespace Text {
 const string utf8 = "utf-8"; // optimization
 string systemCharset;
 
+// The ASCII fast paths may only be used if the locale maps A-Z to a-z and leaves other ASCII characters untouched
+static bool checkAsciiCaseMapping() noexcept {
+	for (wchar_t c = 0; c < 0x80; ++c) {
+		auto expected = c >= L'A' && c <= L'Z' ? c + (L'a' - L'A') : c;
+		if (toLower(c) != expected) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool asciiCaseMapping = checkAsciiCaseMapping();
+
 void initialize() {
 	setlocale(LC_ALL, "");
+	asciiCaseMapping = checkAsciiCaseMapping();
 
 #ifdef _WIN32
 	char *ctype = setlocale(LC_CTYPE, NULL);
@@ -64,6 +89,8 @@ void initialize() {
 	systemCharset = string(nl_langinfo(CODESET));
 #endif
 	dcassert(sanitizeUtf8("A\xc3Name") == "A_Name");
+	dcassert(toLower("ABCDEFGHIJKLMNOPQRSTUVWXYZ@[`{0123456789") == "abcdefghijklmnopqrstuvwxyz@[`{0123456789");
+	dcassert(validateUtf8("0123456789ABCDEF\xc3\xa4") && !validateUtf8("0123456789ABCDEF\xc3"));
 }
 
 #ifdef _WIN32
@@ -87,6 +114,65 @@ bool isAscii(const char* str) noexcept {
 	return true;
 }
 
+size_t asciiPrefixLength(const char* aStr, size_t aLen) noexcept {
+	size_t i = 0;
+
+#if defined(DCPP_TEXT_SSE2)
+	for (; i + 16 <= aLen; i += 16) {
+		const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aStr + i));
+		const auto mask = _mm_movemask_epi8(chunk);
+		if (mask != 0) {
+			return i + std::countr_zero(static_cast<unsigned>(mask));
+		}
+	}
+#elif defined(DCPP_TEXT_NEON)
+	for (; i + 16 <= aLen; i += 16) {
+		const auto chunk = vld1q_u8(reinterpret_cast<const uint8_t*>(aStr + i));
+		if (vmaxvq_u8(chunk) & 0x80) {
+			break;
+		}
+	}
+#endif
+
+	for (; i < aLen; ++i) {
+		if (static_cast<uint8_t>(aStr[i]) & 0x80) {
+			break;
+		}
+	}
+
+	return i;
+}
+
+// Lowercases ASCII characters (the caller must check that the locale maps them in the standard way)
+static void asciiToLower(const char* aStr, size_t aLen, char* out_) noexcept {
+	size_t i = 0;
+
+#if defined(DCPP_TEXT_SSE2)
+	const auto before = _mm_set1_epi8('A' - 1);
+	const auto after = _mm_set1_epi8('Z' + 1);
+	const auto caseBit = _mm_set1_epi8(0x20);
+	for (; i + 16 <= aLen; i += 16) {
+		const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aStr + i));
+		const auto upper = _mm_and_si128(_mm_cmpgt_epi8(chunk, before), _mm_cmplt_epi8(chunk, after));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out_ + i), _mm_or_si128(chunk, _mm_and_si128(upper, caseBit)));
+	}
+#elif defined(DCPP_TEXT_NEON)
+	const auto first = vdupq_n_u8('A');
+	const auto last = vdupq_n_u8('Z');
+	const auto caseBit = vdupq_n_u8(0x20);
+	for (; i + 16 <= aLen; i += 16) {
+		const auto chunk = vld1q_u8(reinterpret_cast<const uint8_t*>(aStr + i));
+		const auto upper = vandq_u8(vcgeq_u8(chunk, first), vcleq_u8(chunk, last));
+		vst1q_u8(reinterpret_cast<uint8_t*>(out_ + i), vorrq_u8(chunk, vandq_u8(upper, caseBit)));
+	}
+#endif
+
+	for (; i < aLen; ++i) {
+		auto c = aStr[i];
+		out_[i] = c >= 'A' && c <= 'Z' ? static_cast<char>(c | 0x20) : c;
+	}
+}
+
 // NOTE: this won't handle UTF-16 surrogate pairs
 int utf8ToWc(const char* str, wchar_t& c) {
 	const auto c0 = static_cast<uint8_t>(str[0]);
@@ -170,12 +256,17 @@ string sanitizeUtf8(const string& str) noexcept {
 	return tgt;
 }
 
-bool validateUtf8(const string& str) noexcept {
+bool validateUtf8(string_view str) noexcept {
 	string::size_type i = 0;
 	while (i < str.length()) {
+		// ASCII characters are always valid
+		i += asciiPrefixLength(str.data() + i, str.length() - i);
+		if (i == str.length())
+			break;
+
 		wchar_t dummy = 0;
 		int j = utf8ToWc(&str[i], dummy);
-		if (j < 0)
+		if (j < 0 || i + j > str.length())
 			return false;
 		i += j;
 	}
@@ -212,15 +303,35 @@ string toLower(const string& str) noexcept {
 	if(str.empty())
 		return Util::emptyString;
 
+	auto asciiLen = asciiCaseMapping ? asciiPrefixLength(str.data(), str.length()) : 0;
+	if (asciiLen == str.length()) {
+		string tmp(str.length(), '\0');
+		asciiToLower(str.data(), str.length(), tmp.data());
+		return tmp;
+	}
+
 #ifdef _WIN32
 	// WinAPI will handle UTF-16 surrogate pairs correctly
 	auto wstr = utf8ToWide(str);
 	return wideToUtf8(Text::toLowerReplace(wstr));
 #else
-	string tmp;
+	string tmp(asciiLen, '\0');
 	tmp.reserve(str.length());
+	asciiToLower(str.data(), asciiLen, tmp.data());
+
 	const char* end = &str[0] + str.length();
-	for(const char* p = &str[0]; p < end;) {
+	for(const char* p = &str[0] + asciiLen; p < end;) {
+		if (asciiCaseMapping) {
+			auto n = asciiPrefixLength(p, end - p);
+			if (n > 0) {
+				auto pos = tmp.length();
+				tmp.resize(pos + n);
+				asciiToLower(p, n, &tmp[pos]);
+				p += n;
+				continue;
+			}
+		}
+
 		wchar_t c = 0;
 		int n = utf8ToWc(p, c);
 		if(n < 0) {
@@ -99,10 +99,13 @@ namespace Text {
 
 	inline bool isAscii(const string& str) noexcept { return isAscii(str.c_str()); }
 	bool isAscii(const char* str) noexcept;
+
+	// Returns the length of the leading part of the string that contains ASCII characters only
+	size_t asciiPrefixLength(const char* aStr, size_t aLen) noexcept;
 	inline char asciiToLower(char c) { dcassert((((uint8_t)c) & 0x80) == 0); return (char)tolower(c); }
 
 	string sanitizeUtf8(const string& str) noexcept;
-	bool validateUtf8(const string& str) noexcept;
+	bool validateUtf8(string_view str) noexcept;
 
 	wchar_t toLower(wchar_t c) noexcept;
 	wchar_t toUpper(wchar_t c) noexcept;
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2011-2024 AirDC++ Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "stdinc.h"
+#include "Bench.h"
+
+#include <chrono>
+#include <iostream>
+
+namespace dcpp::bench {
+
+namespace {
+	volatile uint64_t sink = 0;
+}
+
+void consume(uint64_t aValue) noexcept {
+	sink = sink + aValue;
+}
+
+bool Runner::isEnabled(const string& aGroup) const noexcept {
+	auto prefix = aGroup + ".";
+	return prefix.starts_with(options.filter) || options.filter.starts_with(prefix);
+}
+
+void Runner::run(const string& aName, uint64_t aItems, uint64_t aBytes, const std::function<void ()>& aF) {
+	if (!aName.starts_with(options.filter)) {
+		return;
+	}
+
+	Result result { aName, aItems, aBytes, {} };
+
+	// Warm up
+	aF();
+
+	for (int i = 0; i < options.repeat; ++i) {
+		auto start = std::chrono::steady_clock::now();
+		aF();
+		auto end = std::chrono::steady_clock::now();
+		result.runNs.push_back(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+	}
+
+	ranges::sort(result.runNs);
+
+	auto median = result.runNs[result.runNs.size() / 2];
+	std::cerr << aName << ": " << (static_cast<double>(median) / 1e6) << " ms";
+	if (aItems > 0 && median > 0) {
+		std::cerr << ", " << static_cast<uint64_t>(static_cast<double>(aItems) * 1e9 / static_cast<double>(median)) << " items/s";
+	}
+
+	if (aBytes > 0 && median > 0) {
+		std::cerr << ", " << (static_cast<double>(aBytes) * 1e3 / static_cast<double>(median)) << " MB/s";
+	}
+
+	std::cerr << std::endl;
+	results.push_back(std::move(result));
+}
+
+void Runner::addCounter(const string& aName, uint64_t aValue) noexcept {
+	if (!aName.starts_with(options.filter)) {
+		return;
+	}
+
+	std::cerr << aName << ": " << aValue << std::endl;
+	counters.emplace_back(aName, aValue);
+}
+
+string Runner::toJson() const noexcept {
+	string ret = "{\n\t\"seed\": " + std::to_string(options.seed) + ",\n\t\"files\": " + std::to_string(options.files) + ",\n\t\"results\": [";
+	for (size_t i = 0; i < results.size(); ++i) {
+		const auto& r = results[i];
+		auto median = r.runNs[r.runNs.size() / 2];
+
+		ret += i == 0 ? "\n" : ",\n";
+		ret += "\t\t{ \"name\": \"" + r.name + "\"";
+		ret += ", \"items\": " + std::to_string(r.items);
+		ret += ", \"bytes\": " + std::to_string(r.bytes);
+		ret += ", \"min_ns\": " + std::to_string(r.runNs.front());
+		ret += ", \"median_ns\": " + std::to_string(median);
+		ret += ", \"max_ns\": " + std::to_string(r.runNs.back());
+		ret += " }";
+	}
+
+	ret += "\n\t],\n\t\"counters\": {";
+	for (size_t i = 0; i < counters.size(); ++i) {
+		ret += i == 0 ? "\n" : ",\n";
+		ret += "\t\t\"" + counters[i].first + "\": " + std::to_string(counters[i].second);
+	}
+
+	ret += "\n\t}\n}\n";
+	return ret;
+}
+
+} // namespace dcpp::bench
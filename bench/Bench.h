@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2011-2024 AirDC++ Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef DCPLUSPLUS_BENCH_BENCH_H
+#define DCPLUSPLUS_BENCH_BENCH_H
+
+#include <airdcpp/core/header/typedefs.h>
+
+namespace dcpp::bench {
+
+struct Options {
+	// Only run benchmarks whose name starts with this string (e.g. "share" or "share.searchText")
+	string filter;
+
+	// Number of measured runs for each benchmark (the median is reported)
+	int repeat = 5;
+
+	// Number of files in the synthetic share tree and filelists
+	size_t files = 1000000;
+
+	// Seed for all data generators
+	uint64_t seed = 1;
+
+	// Directory for the temporary files of the disk benchmarks (the current directory if empty)
+	string tempDirectory;
+};
+
+// Runs the benchmarks and collects the results
+class Runner {
+public:
+	explicit Runner(const Options& aOptions) : options(aOptions) { }
+
+	const Options& getOptions() const noexcept {
+		return options;
+	}
+
+	// Should the data for the benchmark group (name prefix before the dot) be generated?
+	bool isEnabled(const string& aGroup) const noexcept;
+
+	// Measures the function
+	// aItems/aBytes tell the amount of work performed by a single call for reporting the throughput
+	void run(const string& aName, uint64_t aItems, uint64_t aBytes, const std::function<void ()>& aF);
+
+	// Reports an internal statistic of the benchmarked component (e.g. the number of calls or bytes written)
+	void addCounter(const string& aName, uint64_t aValue) noexcept;
+
+	// Results in JSON format
+	string toJson() const noexcept;
+private:
+	struct Result {
+		string name;
+		uint64_t items;
+		uint64_t bytes;
+		vector<uint64_t> runNs;
+	};
+
+	const Options options;
+	vector<Result> results;
+	vector<pair<string, uint64_t>> counters;
+};
+
+// Prevents the compiler from optimizing away unused results
+void consume(uint64_t aValue) noexcept;
+
+void runHashBenchmarks(Runner& aRunner);
+void runShareBenchmarks(Runner& aRunner);
+void runXMLBenchmarks(Runner& aRunner);
+void runProtocolBenchmarks(Runner& aRunner);
+void runQueueBenchmarks(Runner& aRunner);
+void runSpeakerBenchmarks(Runner& aRunner);
+void runTLSBenchmarks(Runner& aRunner);
+
+} // namespace dcpp::bench
+
+#endif // !defined(DCPLUSPLUS_BENCH_BENCH_H)
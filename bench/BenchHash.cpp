@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2011-2024 AirDC++ Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "stdinc.h"
+#include "Bench.h"
+#include "Generators.h"
+
+#include <airdcpp/hash/value/MerkleTree.h>
+#include <airdcpp/hash/value/TigerHash.h>
+#include <airdcpp/hash/value/TTHIndex.h>
+
+namespace dcpp::bench {
+
+namespace {
+	struct IndexedFile {
+		TTHValue tth;
+	};
+
+	// Same operations for the flat index and the multimap that it replaced
+	template<class IndexT>
+	struct IndexOps;
+
+	template<>
+	struct IndexOps<TTHIndex<const IndexedFile*>> {
+		using Index = TTHIndex<const IndexedFile*>;
+		static void add(Index& index_, IndexedFile& aFile) noexcept { index_.emplace(&aFile.tth, &aFile); }
+		static void remove(Index& index_, const IndexedFile& aFile) noexcept { index_.erase(aFile.tth, &aFile); }
+		static size_t count(const Index& aIndex, const TTHValue& aTTH) noexcept { return ranges::distance(aIndex.findAll(aTTH)); }
+	};
+
+	template<>
+	struct IndexOps<unordered_multimap<TTHValue*, const IndexedFile*>> {
+		using Index = unordered_multimap<TTHValue*, const IndexedFile*>;
+		static void add(Index& index_, IndexedFile& aFile) noexcept { index_.emplace(&aFile.tth, &aFile); }
+		static void remove(Index& index_, const IndexedFile& aFile) noexcept {
+			auto range = index_.equal_range(const_cast<TTHValue*>(&aFile.tth));
+			auto i = ranges::find_if(range.first, range.second, [&](const auto& p) { return p.second == &aFile; });
+			if (i != range.second) {
+				index_.erase(i);
+			}
+		}
+		static size_t count(const Index& aIndex, const TTHValue& aTTH) noexcept { return aIndex.count(const_cast<TTHValue*>(&aTTH)); }
+	};
+
+	template<class IndexT>
+	void runIndexBenchmarks(Runner& aRunner, const string& aName, vector<IndexedFile>& files_, const vector<TTHValue>& aQueries) {
+		using Ops = IndexOps<IndexT>;
+
+		aRunner.run("hash." + aName + "Build", files_.size(), 0, [&] {
+			IndexT index;
+			for (auto& f: files_) {
+				Ops::add(index, f);
+			}
+
+			consume(index.size());
+		});
+
+		IndexT index;
+		for (auto& f: files_) {
+			Ops::add(index, f);
+		}
+
+		aRunner.run("hash." + aName + "Find", aQueries.size(), 0, [&] {
+			size_t found = 0;
+			for (const auto& tth: aQueries) {
+				found += Ops::count(index, tth);
+			}
+
+			consume(found);
+		});
+
+		// Remove and re-add every tenth file (as in partial refreshes)
+		aRunner.run("hash." + aName + "Update", files_.size() / 5, 0, [&] {
+			for (size_t i = 0; i < files_.size(); i += 10) {
+				Ops::remove(index, files_[i]);
+			}
+
+			for (size_t i = 0; i < files_.size(); i += 10) {
+				Ops::add(index, files_[i]);
+			}
+
+			consume(index.size());
+		});
+	}
+}
+
+void runHashBenchmarks(Runner& aRunner) {
+	if (!aRunner.isEnabled("hash")) {
+		return;
+	}
+
+	Generator gen(aRunner.getOptions().seed);
+
+	const size_t LARGE_SIZE = 256 * 1024 * 1024;
+	const size_t SMALL_SIZE = 16 * 1024;
+	const size_t SMALL_COUNT = 4096;
+
+	auto data = gen.bytes(LARGE_SIZE);
+
+	aRunner.run("hash.tiger", 0, LARGE_SIZE, [&] {
+		TigerHash h;
+		h.update(data.data(), data.size());
+		consume(h.finalize()[0]);
+	});
+
+	// Same block size as used by the hasher
+	aRunner.run("hash.merkleTree", 0, LARGE_SIZE, [&] {
+		TigerTree tt(max<int64_t>(TigerTree::calcBlockSize(LARGE_SIZE, 10), 64 * 1024));
+		tt.update(data.data(), data.size());
+		tt.finalize();
+		consume(tt.getRoot().data[0]);
+	});
+
+	aRunner.run("hash.merkleTreeSmallFiles", SMALL_COUNT, SMALL_SIZE * SMALL_COUNT, [&] {
+		for (size_t i = 0; i < SMALL_COUNT; ++i) {
+			TigerTree tt(64 * 1024);
+			tt.update(data.data() + i * SMALL_SIZE, SMALL_SIZE);
+			tt.finalize();
+			consume(tt.getRoot().data[0]);
+		}
+	});
+
+	// TTH index of the share/queue (about 5% of the files are duplicates)
+	const size_t TTH_QUERY_COUNT = 1000000;
+
+	const auto fileCount = aRunner.getOptions().files;
+	vector<IndexedFile> files;
+	files.reserve(fileCount);
+	for (size_t i = 0; i < fileCount; ++i) {
+		files.push_back({ i > 0 && gen.next(20) == 0 ? files[gen.next(i)].tth : gen.tth() });
+	}
+
+	// Half of the TTHs exist in the index
+	vector<TTHValue> queries;
+	for (size_t i = 0; i < TTH_QUERY_COUNT; ++i) {
+		queries.push_back(i % 2 == 0 ? files[gen.next(files.size())].tth : gen.tth());
+	}
+
+	runIndexBenchmarks<TTHIndex<const IndexedFile*>>(aRunner, "tthIndex", files, queries);
+	runIndexBenchmarks<unordered_multimap<TTHValue*, const IndexedFile*>>(aRunner, "tthMultimap", files, queries);
+}
+
+} // namespace dcpp::bench
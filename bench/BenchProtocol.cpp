@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2011-2024 AirDC++ Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "stdinc.h"
+#include "Bench.h"
+#include "Generators.h"
+
+#include <airdcpp/protocol/AdcCommand.h>
+
+namespace dcpp::bench {
+
+void runProtocolBenchmarks(Runner& aRunner) {
+	if (!aRunner.isEnabled("adc")) {
+		return;
+	}
+
+	Generator gen(aRunner.getOptions().seed);
+
+	const size_t COMMAND_COUNT = 100000;
+	auto lines = generateAdcCommands(gen, COMMAND_COUNT);
+
+	size_t bytes = 0;
+	for (const auto& l: lines) {
+		bytes += l.size();
+	}
+
+	aRunner.run("adc.parse", COMMAND_COUNT, bytes, [&] {
+		for (const auto& l: lines) {
+			try {
+				AdcCommand cmd(l);
+				consume(cmd.getParameters().size());
+			} catch (const ParseException&) {
+				consume(0);
+			}
+		}
+	});
+
+	vector<AdcCommand> commands;
+	for (const auto& l: lines) {
+		try {
+			commands.emplace_back(l);
+		} catch (const ParseException&) {
+			// The generated commands should always be valid
+			dcassert(0);
+		}
+	}
+
+	aRunner.run("adc.serialize", commands.size(), bytes, [&] {
+		for (const auto& cmd: commands) {
+			consume(cmd.toString().size());
+		}
+	});
+}
+
+} // namespace dcpp::bench
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2011-2024 AirDC++ Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "stdinc.h"
+#include "Bench.h"
+#include "Generators.h"
+
+#include <airdcpp/core/classes/Exception.h>
+#include <airdcpp/core/io/File.h>
+#include <airdcpp/core/io/stream/SegmentOutputStream.h>
+#include <airdcpp/queue/QueueItem.h>
+#include <airdcpp/util/PathUtil.h>
+
+#include <iostream>
+
+namespace dcpp::bench {
+
+namespace {
+	// Downloads a file with multiple segments whose data arrives in interleaved chunks of random size (as from parallel connections)
+	// and reports the disk write statistics of the segment streams
+	void runSegmentWriteBenchmark(Runner& aRunner, const string& aName, const string& aPath, size_t aBufferSize) {
+		const int64_t FILE_SIZE = 64 * 1024 * 1024;
+		const int64_t SEGMENTS = 8;
+		const int64_t SEGMENT_SIZE = FILE_SIZE / SEGMENTS;
+		const size_t MAX_CHUNK = 64 * 1024;
+
+		Generator gen(aRunner.getOptions().seed);
+		const auto data = gen.bytes(MAX_CHUNK);
+
+		const auto before = SegmentOutputStream::getStats();
+		aRunner.run(aName, 0, FILE_SIZE, [&] {
+			SegmentOutputStream::Options options;
+			options.bufferSize = aBufferSize;
+
+			vector<unique_ptr<SegmentOutputStream>> streams;
+			vector<int64_t> left(SEGMENTS, SEGMENT_SIZE);
+			for (int64_t i = 0; i < SEGMENTS; ++i) {
+				streams.push_back(make_unique<SegmentOutputStream>(aPath, FILE_SIZE, i * SEGMENT_SIZE, options));
+			}
+
+			for (auto active = SEGMENTS; active > 0;) {
+				for (int64_t i = 0; i < SEGMENTS; ++i) {
+					if (left[i] == 0) {
+						continue;
+					}
+
+					auto len = min(static_cast<int64_t>(gen.next(MAX_CHUNK) + 1), left[i]);
+					streams[i]->write(data.data(), static_cast<size_t>(len));
+					left[i] -= len;
+					if (left[i] == 0) {
+						streams[i]->flushBuffers(false);
+						active--;
+					}
+				}
+			}
+
+			streams.clear();
+			SegmentOutputStream::addCommittedBytes(FILE_SIZE);
+		});
+
+		const auto after = SegmentOutputStream::getStats();
+
+		SegmentOutputStream::Stats stats;
+		stats.writtenBytes = after.writtenBytes - before.writtenBytes;
+		stats.writes = after.writes - before.writes;
+		stats.committedBytes = after.committedBytes - before.committedBytes;
+
+		aRunner.addCounter(aName + ".writes", static_cast<uint64_t>(stats.writes));
+		aRunner.addCounter(aName + ".averageWriteSize", static_cast<uint64_t>(stats.getAverageWriteSize()));
+		aRunner.addCounter(aName + ".writeAmplificationPercent", static_cast<uint64_t>(stats.getWriteAmplification() * 100));
+	}
+}
+
+void runQueueBenchmarks(Runner& aRunner) {
+	if (!aRunner.isEnabled("queue")) {
+		return;
+	}
+
+	Generator gen(aRunner.getOptions().seed);
+
+	const int64_t FILE_SIZE = 8LL * 1024 * 1024 * 1024;
+	const int64_t BLOCK_SIZE = 1024 * 1024;
+	const size_t SEGMENT_QUERIES = 10000;
+
+	auto qi = make_shared<QueueItem>("bench.bin", FILE_SIZE, Priority::NORMAL, QueueItem::FLAG_NORMAL, 1700000000, gen.tth(), "bench.bin.dctmp");
+
+	// Fragmented download, about a third of the blocks have been finished
+	for (int64_t pos = 0; pos < FILE_SIZE; pos += BLOCK_SIZE) {
+		if (gen.next(3) == 0) {
+			qi->addFinishedSegment(Segment(pos, BLOCK_SIZE));
+		}
+	}
+
+	aRunner.run("queue.nextSegment", SEGMENT_QUERIES, 0, [&] {
+		for (size_t i = 0; i < SEGMENT_QUERIES; ++i) {
+			auto wanted = BLOCK_SIZE << (i % 6);
+			auto segment = qi->getNextSegment(BLOCK_SIZE, wanted, static_cast<int64_t>(i % 10) * 1024 * 1024, nullptr, false);
+			consume(static_cast<uint64_t>(segment.getStart()));
+		}
+	});
+
+	const auto segmentPath = PathUtil::ensureTrailingSlash(aRunner.getOptions().tempDirectory) + "airdcpp-bench-segments.tmp";
+	try {
+		runSegmentWriteBenchmark(aRunner, "queue.segmentWrite", segmentPath, 256 * 1024);
+		runSegmentWriteBenchmark(aRunner, "queue.segmentWriteUnbuffered", segmentPath, 0);
+	} catch (const FileException& e) {
+		std::cerr << "queue.segmentWrite: " << e.getError() << std::endl;
+	}
+
+	File::deleteFile(segmentPath);
+}
+
+} // namespace dcpp::bench
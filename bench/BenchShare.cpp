@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2011-2024 AirDC++ Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "stdinc.h"
+#include "Bench.h"
+#include "Generators.h"
+
+#include <airdcpp/core/io/compress/BZUtils.h>
+#include <airdcpp/core/io/stream/FilteredFile.h>
+#include <airdcpp/core/io/stream/Streams.h>
+#include <airdcpp/hash/value/HashBloom.h>
+#include <airdcpp/search/SearchQuery.h>
+#include <airdcpp/search/SearchResult.h>
+#include <airdcpp/share/ShareRefreshInfo.h>
+#include <airdcpp/share/ShareSearchInfo.h>
+#include <airdcpp/share/ShareTree.h>
+#include <airdcpp/util/text/Text.h>
+
+namespace dcpp::bench {
+
+namespace {
+	const ProfileToken PROFILE = 0;
+	const string ROOT_PATH = PATH_SEPARATOR_STR "airdcpp-bench" PATH_SEPARATOR_STR "share" PATH_SEPARATOR_STR;
+	const time_t DATE = 1700000000;
+
+	void addDirectory(const SyntheticDirectory& aDir, ShareDirectory* parent_, ShareRefreshInfo& ri_) noexcept {
+		for (const auto& d: aDir.directories) {
+			auto dir = ShareDirectory::createNormal(DualString(d.name), parent_, DATE, ri_);
+			if (dir) {
+				addDirectory(d, dir.get(), ri_);
+			}
+		}
+
+		for (const auto& f: aDir.files) {
+			parent_->addFile(DualString(f.name), HashedFile(f.tth, DATE, f.size), ri_, ri_.stats.addedSize);
+		}
+	}
+
+	// Builds the share with the same steps as a refresh of the root
+	unique_ptr<ShareTree> buildShare(const SyntheticDirectory& aRoot) {
+		auto tree = make_unique<ShareTree>();
+		tree->addShareRoot(ROOT_PATH, "Share", { PROFILE }, false, DATE, DATE);
+
+		ShareDirectory::Ptr root;
+		{
+			RLock l(tree->getCS());
+			root = tree->findDirectoryUnsafe(ROOT_PATH);
+		}
+
+		ShareRefreshInfo ri(ROOT_PATH, root, DATE, *tree->getBloom());
+		addDirectory(aRoot, ri.newDirectory.get(), ri);
+		tree->applyRefreshChanges(ri, nullptr);
+		return tree;
+	}
+}
+
+void runShareBenchmarks(Runner& aRunner) {
+	if (!aRunner.isEnabled("share")) {
+		return;
+	}
+
+	const auto& options = aRunner.getOptions();
+	Generator gen(options.seed);
+
+	const size_t QUERY_COUNT = 1000;
+	const size_t TTH_QUERY_COUNT = 100000;
+
+	auto root = generateTree(gen, options.files);
+	auto queries = generateSearchQueries(gen, root, QUERY_COUNT);
+
+	// Half of the TTHs exist in share
+	vector<TTHValue> tths;
+	forEachFile(root, [&](const SyntheticFile& aFile) {
+		if (tths.size() < TTH_QUERY_COUNT / 2) {
+			tths.push_back(aFile.tth);
+		}
+	});
+
+	while (tths.size() < TTH_QUERY_COUNT) {
+		tths.push_back(gen.tth());
+	}
+
+	aRunner.run("share.build", options.files, 0, [&] {
+		consume(buildShare(root)->getSharedSize());
+	});
+
+	auto tree = buildShare(root);
+
+	const UserPtr user;
+	aRunner.run("share.searchText", QUERY_COUNT, 0, [&] {
+		ShareSearchCounters counters;
+		for (const auto& params: queries) {
+			SearchQuery query(params, 100);
+			ShareSearch search(query, PROFILE, user, ADC_ROOT_STR);
+
+			SearchResultList results;
+			tree->searchText(results, search, counters);
+			consume(results.size());
+		}
+	});
+
+	aRunner.run("share.searchTTH", TTH_QUERY_COUNT, 0, [&] {
+		for (const auto& tth: tths) {
+			SearchQuery query(tth);
+			ShareSearch search(query, PROFILE, user, ADC_ROOT_STR);
+
+			SearchResultList results;
+			tree->search(results, tth, search);
+			consume(results.size());
+		}
+	});
+
+	aRunner.run("share.nameBloomMatch", QUERY_COUNT, 0, [&] {
+		const auto& bloom = *tree->getBloom();
+		for (const auto& params: queries) {
+			for (const auto& p: params) {
+				consume(bloom.match(Text::toLower(p.substr(2))));
+			}
+		}
+	});
+
+	// Parameters as requested by hubs (h = 24 bits per hash)
+	HashBloom hashBloom;
+	{
+		auto k = HashBloom::get_k(options.files, 24);
+		hashBloom.reset(k, HashBloom::get_m(options.files, k), 24);
+		tree->getBloom(PROFILE, hashBloom);
+	}
+
+	aRunner.run("share.hashBloomMatch", TTH_QUERY_COUNT, 0, [&] {
+		for (const auto& tth: tths) {
+			consume(hashBloom.match(tth));
+		}
+	});
+
+	const auto noDupes = [](const StringList&, int) { };
+	string listing;
+	aRunner.run("share.filelist", options.files, 0, [&] {
+		listing.clear();
+		StringOutputStream os(listing);
+		tree->toFilelist(os, ADC_ROOT_STR, PROFILE, true, noDupes);
+		consume(listing.size());
+	});
+
+	aRunner.run("share.filelistBzip2", options.files, listing.size(), [&] {
+		string compressed;
+		{
+			FilteredOutputStream<BZFilter, true> os(new StringOutputStream(compressed));
+			os.write(listing);
+			os.flushBuffers(true);
+		}
+
+		consume(compressed.size());
+	});
+}
+
+} // namespace dcpp::bench
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2011-2024 AirDC++ Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "stdinc.h"
+#include "Bench.h"
+
+#include <airdcpp/core/Speaker.h>
+
+#include <thread>
+
+namespace dcpp::bench {
+
+namespace {
+	struct BenchEvent { };
+
+	class BenchListener {
+	public:
+		virtual ~BenchListener() = default;
+
+		virtual void on(BenchEvent, uint64_t aValue) noexcept {
+			consume(aValue);
+		}
+	};
+
+	class BenchSpeaker : public Speaker<BenchListener> { };
+}
+
+void runSpeakerBenchmarks(Runner& aRunner) {
+	if (!aRunner.isEnabled("speaker")) {
+		return;
+	}
+
+	const size_t LISTENERS = 8;
+	const uint64_t FIRES = 1000000;
+	const size_t THREADS = 4;
+
+	BenchSpeaker speaker;
+	vector<BenchListener> listeners(LISTENERS);
+	for (auto& l: listeners) {
+		speaker.addListener(&l);
+	}
+
+	aRunner.run("speaker.fire", FIRES, 0, [&] {
+		for (uint64_t i = 0; i < FIRES; ++i) {
+			speaker.fire(BenchEvent(), i);
+		}
+	});
+
+	// Dispatches from multiple threads don't wait for each other
+	aRunner.run("speaker.fireConcurrent", FIRES, 0, [&] {
+		vector<std::thread> threads;
+		for (size_t t = 0; t < THREADS; ++t) {
+			threads.emplace_back([&speaker, fires = FIRES / THREADS] {
+				for (uint64_t i = 0; i < fires; ++i) {
+					speaker.fire(BenchEvent(), i);
+				}
+			});
+		}
+
+		for (auto& t: threads) {
+			t.join();
+		}
+	});
+
+	SpeakerStats::setLatencyTracking(true);
+	aRunner.run("speaker.fireLatency", FIRES, 0, [&] {
+		for (uint64_t i = 0; i < FIRES; ++i) {
+			speaker.fire(BenchEvent(), i);
+		}
+	});
+	SpeakerStats::setLatencyTracking(false);
+
+	speaker.removeListeners();
+
+	// Dispatch statistics of the benchmark event
+	for (const auto& e: SpeakerStats::getEvents()) {
+		if (e.name != typeid(BenchEvent).name()) {
+			continue;
+		}
+
+		aRunner.addCounter("speaker.stats.dispatches", e.dispatches);
+		aRunner.addCounter("speaker.stats.listenerCalls", e.listenerCalls);
+		for (size_t i = 0; i < e.latency.size(); ++i) {
+			if (e.latency[i] == 0) {
+				continue;
+			}
+
+			auto bucket = i + 1 < e.latency.size() ? "under" + std::to_string(1ULL << i) + "us" : "slower";
+			aRunner.addCounter("speaker.stats.latency." + bucket, e.latency[i]);
+		}
+	}
+}
+
+} // namespace dcpp::bench
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2011-2024 AirDC++ Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "stdinc.h"
+#include "Bench.h"
+
+#include <airdcpp/core/classes/Exception.h>
+#include <airdcpp/core/crypto/CryptoManager.h>
+#include <airdcpp/core/io/File.h>
+#include <airdcpp/settings/SettingsManager.h>
+#include <airdcpp/util/PathUtil.h>
+
+#include <iostream>
+
+namespace dcpp::bench {
+
+namespace {
+	// Connects a client and a server through an in-memory BIO pair the same way as SSLSocket
+	// (the client has pinned the keyprint of the server, the server doesn't verify the client)
+	// Returns false if the handshake failed
+	bool handshake(const string& aKeyprint, bool aResume) noexcept {
+		auto cm = CryptoManager::getInstance();
+		ssl::SSL client(SSL_new(cm->getSSLContext(CryptoManager::SSL_CLIENT)));
+		ssl::SSL server(SSL_new(cm->getSSLContext(CryptoManager::SSL_SERVER)));
+		if (!client || !server) {
+			return false;
+		}
+
+		BIO* clientBio = nullptr;
+		BIO* serverBio = nullptr;
+		BIO_new_bio_pair(&clientBio, 0, &serverBio, 0);
+		SSL_set_bio(client, clientBio, clientBio);
+		SSL_set_bio(server, serverBio, serverBio);
+
+		CryptoManager::SSLVerifyData verifyData(false, aKeyprint);
+		SSL_set_ex_data(client, CryptoManager::idxVerifyData, &verifyData);
+		if (aResume) {
+			cm->setCachedSession(client, aKeyprint);
+		}
+
+		SSL_set_verify(server, SSL_VERIFY_NONE, nullptr);
+
+		SSL_set_connect_state(client);
+		SSL_set_accept_state(server);
+
+		auto clientDone = false, serverDone = false;
+		while (!clientDone || !serverDone) {
+			auto progress = false;
+			for (auto [ssl, done] : { pair<::SSL*, bool*>(client, &clientDone), pair<::SSL*, bool*>(server, &serverDone) }) {
+				if (*done) {
+					continue;
+				}
+
+				auto ret = SSL_do_handshake(ssl);
+				if (ret == 1) {
+					*done = true;
+					progress = true;
+					cm->onHandshakeCompleted(ssl);
+				} else if (auto err = SSL_get_error(ssl, ret); err != SSL_ERROR_WANT_READ && err != SSL_ERROR_WANT_WRITE) {
+					return false;
+				}
+			}
+
+			if (!progress && BIO_ctrl_pending(clientBio) == 0 && BIO_ctrl_pending(serverBio) == 0) {
+				return false;
+			}
+		}
+
+		// TLS 1.3 session tickets are sent after the handshake, read some data so that the client will receive the ticket
+		char data = 0;
+		if (SSL_write(server, &data, 1) != 1 || SSL_read(client, &data, 1) != 1) {
+			return false;
+		}
+
+		// Sessions of connections that weren't shut down are invalidated by OpenSSL
+		SSL_shutdown(client);
+		SSL_shutdown(server);
+		return true;
+	}
+}
+
+void runTLSBenchmarks(Runner& aRunner) {
+	if (!aRunner.isEnabled("tls")) {
+		return;
+	}
+
+	const size_t HANDSHAKES = 200;
+
+	// Generate a certificate for both contexts
+	const auto tempDirectory = PathUtil::ensureTrailingSlash(aRunner.getOptions().tempDirectory);
+	const auto certPath = tempDirectory + "airdcpp-bench.crt";
+	const auto keyPath = tempDirectory + "airdcpp-bench.key";
+
+	SettingsManager::getInstance()->set(SettingsManager::TLS_CERTIFICATE_FILE, certPath);
+	SettingsManager::getInstance()->set(SettingsManager::TLS_PRIVATE_KEY_FILE, keyPath);
+
+	auto cm = CryptoManager::getInstance();
+	string keyprint;
+	try {
+		cm->generateCertificate();
+		for (auto context : { CryptoManager::SSL_CLIENT, CryptoManager::SSL_SERVER }) {
+			if (!ssl::SSL_CTX_use_certificate_file(cm->getSSLContext(context), certPath.c_str(), SSL_FILETYPE_PEM) ||
+				!ssl::SSL_CTX_use_PrivateKey_file(cm->getSSLContext(context), keyPath.c_str(), SSL_FILETYPE_PEM)
+			) {
+				throw CryptoException("Failed to load the generated certificate");
+			}
+		}
+
+		auto x509 = ssl::getX509(certPath.c_str());
+		keyprint = CryptoManager::keyprintToString(ssl::X509_digest(x509, EVP_sha256()));
+	} catch (const CryptoException& e) {
+		std::cerr << "tls: " << e.getError() << std::endl;
+	}
+
+	File::deleteFile(certPath);
+	File::deleteFile(keyPath);
+
+	if (keyprint.empty()) {
+		return;
+	}
+
+	auto failed = false;
+	aRunner.run("tls.handshakeFull", HANDSHAKES, 0, [&] {
+		for (size_t i = 0; i < HANDSHAKES; ++i) {
+			failed |= !handshake(keyprint, false);
+		}
+	});
+
+	aRunner.run("tls.handshakeResumed", HANDSHAKES, 0, [&] {
+		for (size_t i = 0; i < HANDSHAKES; ++i) {
+			failed |= !handshake(keyprint, true);
+		}
+	});
+
+	if (failed) {
+		std::cerr << "tls: handshake failed" << std::endl;
+	}
+
+	// Both sides are counted
+	auto stats = cm->getSessionStats();
+	aRunner.addCounter("tls.stats.fullHandshakes", static_cast<uint64_t>(stats.fullHandshakes));
+	aRunner.addCounter("tls.stats.resumedHandshakes", static_cast<uint64_t>(stats.resumedHandshakes));
+	aRunner.addCounter("tls.stats.cachedSessions", stats.cachedSessions);
+}
+
+} // namespace dcpp::bench
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2011-2024 AirDC++ Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "stdinc.h"
+#include "Bench.h"
+#include "Generators.h"
+
+#include <airdcpp/core/io/stream/Streams.h>
+#include <airdcpp/core/io/xml/SimpleXMLReader.h>
+
+namespace dcpp::bench {
+
+namespace {
+	// Reads the attributes similar to the filelist loader
+	struct FilelistCounter : public SimpleXMLReader::CallBack {
+		void startTagView(const string& aName, const SimpleXMLReader::AttribViewList& aAttribs, bool) override {
+			tags++;
+			if (aName == "File") {
+				size += toInt64(getAttrib(aAttribs, "Size", 1));
+				nameBytes += getAttrib(aAttribs, "Name", 0).size();
+			}
+		}
+
+		uint64_t tags = 0;
+		int64_t size = 0;
+		size_t nameBytes = 0;
+	};
+}
+
+void runXMLBenchmarks(Runner& aRunner) {
+	if (!aRunner.isEnabled("xml")) {
+		return;
+	}
+
+	const auto& options = aRunner.getOptions();
+	Generator gen(options.seed);
+
+	auto listing = generateFilelist(generateTree(gen, options.files));
+
+	aRunner.run("xml.parseDocument", options.files, listing.size(), [&] {
+		FilelistCounter counter;
+		SimpleXMLReader(&counter).parseDocument(listing);
+		consume(counter.tags);
+	});
+
+	aRunner.run("xml.parseStream", options.files, listing.size(), [&] {
+		FilelistCounter counter;
+		MemoryInputStream is(listing);
+		SimpleXMLReader(&counter).parse(is);
+		consume(counter.tags);
+	});
+}
+
+} // namespace dcpp::bench
@@ -0,0 +1,326 @@
+/*
+ * Copyright (C) 2011-2024 AirDC++ Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+// Differential fuzzer for the flat TTH index
+// Runs random operations on TTHIndex and on the multimap that it replaced and compares the results
+
+#include "stdinc.h"
+#include "Generators.h"
+
+#include <airdcpp/hash/value/TTHIndex.h>
+#include <airdcpp/util/Util.h>
+
+#include <iostream>
+
+using namespace dcpp;
+using namespace dcpp::bench;
+
+namespace {
+	// Keep the index small so that the table is resized and the probe sequences wrap around often
+	const size_t MAX_ITEMS = 3000;
+
+	// Distinct TTHs used by the items (duplicates are chained in the index)
+	const size_t KEY_COUNT = 1024;
+
+	// The values point to the items and the keys point to the TTH inside the item (as in the share and the queue)
+	struct Item {
+		TTHValue tth;
+		uint64_t id;
+	};
+
+	using Index = TTHIndex<const Item*>;
+	using ReferenceIndex = unordered_multimap<TTHValue*, const Item*>;
+
+	// Some keys have equal hashes (same first bytes) and some hashes differ only in the high bits
+	// so that the slot matching and the backward shift deletion get exercised
+	vector<TTHValue> generateKeys(Generator& aGen) noexcept {
+		vector<TTHValue> ret;
+		while (ret.size() < KEY_COUNT) {
+			auto tth = aGen.tth();
+			switch (aGen.next(4)) {
+				case 0: {
+					// Same hash as an earlier key
+					if (!ret.empty()) {
+						memcpy(tth.data, ret[aGen.next(ret.size())].data, sizeof(size_t));
+					}
+					break;
+				}
+				case 1: {
+					// Same low bits as an earlier key
+					if (!ret.empty()) {
+						memcpy(tth.data, ret[aGen.next(ret.size())].data, 2);
+					}
+					break;
+				}
+				default: break;
+			}
+
+			ret.push_back(tth);
+		}
+
+		return ret;
+	}
+
+	class Fuzzer {
+	public:
+		explicit Fuzzer(uint64_t aSeed) : gen(aSeed), keys(generateKeys(gen)) { }
+
+		void run(uint64_t aIterations) noexcept {
+			for (uint64_t i = 0; i < aIterations; ++i) {
+				step();
+			}
+
+			checkAll();
+		}
+
+		uint64_t getOperations() const noexcept {
+			return operations;
+		}
+
+		uint64_t getFailures() const noexcept {
+			return failures;
+		}
+	private:
+		void step() noexcept {
+			operations++;
+
+			auto op = gen.next(100);
+			if (op < 40) {
+				if (items.size() < MAX_ITEMS) {
+					add();
+				} else {
+					remove();
+				}
+			} else if (op < 70) {
+				remove();
+			} else if (op < 75) {
+				removeMissing();
+			} else if (op < 90) {
+				lookup(keys[gen.next(keys.size())]);
+			} else if (op < 95) {
+				lookupBatch();
+			} else if (op < 97) {
+				index.reserve(gen.next(MAX_ITEMS * 2));
+			} else if (op < 98) {
+				checkAll();
+			} else if (gen.next(20) == 0) {
+				clear();
+			}
+		}
+
+		void add() noexcept {
+			auto item = make_unique<Item>(Item({ keys[gen.next(keys.size())], nextId++ }));
+			index.emplace(&item->tth, item.get());
+			reference.emplace(&item->tth, item.get());
+			items.push_back(std::move(item));
+		}
+
+		void remove() noexcept {
+			if (items.empty()) {
+				return;
+			}
+
+			auto pos = gen.next(items.size());
+			auto& item = items[pos];
+
+			auto erased = index.erase(item->tth, item.get());
+			auto referenceErased = eraseReference(item->tth, item.get());
+			if (erased != referenceErased) {
+				fail("erase");
+			}
+
+			std::swap(item, items.back());
+			items.pop_back();
+		}
+
+		// The value doesn't exist with this TTH
+		void removeMissing() noexcept {
+			Item missing({ keys[gen.next(keys.size())], nextId++ });
+			if (index.erase(missing.tth, &missing) || eraseReference(missing.tth, &missing)) {
+				fail("erase (missing value)");
+			}
+
+			if (!items.empty()) {
+				// Existing value, different TTH
+				const auto& item = items[gen.next(items.size())];
+				const auto& tth = keys[gen.next(keys.size())];
+				if (tth != item->tth && index.erase(tth, item.get())) {
+					fail("erase (wrong TTH)");
+				}
+			}
+		}
+
+		bool eraseReference(const TTHValue& aTTH, const Item* aItem) noexcept {
+			auto range = reference.equal_range(const_cast<TTHValue*>(&aTTH));
+			for (auto i = range.first; i != range.second; ++i) {
+				if (i->second == aItem) {
+					reference.erase(i);
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		vector<const Item*> findReference(const TTHValue& aTTH) const noexcept {
+			vector<const Item*> ret;
+			auto range = reference.equal_range(const_cast<TTHValue*>(&aTTH));
+			for (auto i = range.first; i != range.second; ++i) {
+				ret.push_back(i->second);
+			}
+
+			ranges::sort(ret);
+			return ret;
+		}
+
+		void lookup(const TTHValue& aTTH) noexcept {
+			auto expected = findReference(aTTH);
+
+			vector<const Item*> found;
+			for (const auto& item : index.findAll(aTTH)) {
+				found.push_back(item);
+			}
+
+			ranges::sort(found);
+			if (found != expected) {
+				fail("findAll");
+			}
+
+			if (index.contains(aTTH) != !expected.empty()) {
+				fail("contains");
+			}
+
+			auto first = index.find(aTTH);
+			if (!first ? !expected.empty() : !ranges::binary_search(expected, *first)) {
+				fail("find");
+			}
+		}
+
+		void lookupBatch() noexcept {
+			vector<TTHValue> batch;
+			for (auto count = gen.next(40); batch.size() < count;) {
+				batch.push_back(keys[gen.next(keys.size())]);
+			}
+
+			vector<pair<size_t, const Item*>> found, expected;
+			index.findBatch(batch.size(), [&](size_t i) -> const TTHValue& { return batch[i]; }, [&](size_t i, const Item* aItem) {
+				found.emplace_back(i, aItem);
+			});
+
+			for (size_t i = 0; i < batch.size(); ++i) {
+				for (const auto& item : findReference(batch[i])) {
+					expected.emplace_back(i, item);
+				}
+			}
+
+			ranges::sort(found);
+			ranges::sort(expected);
+			if (found != expected) {
+				fail("findBatch");
+			}
+		}
+
+		void checkAll() noexcept {
+			if (index.size() != reference.size() || index.empty() != reference.empty()) {
+				fail("size");
+			}
+
+			set<TTHValue> distinctKeys;
+			for (const auto& tth : reference | views::keys) {
+				distinctKeys.insert(*tth);
+			}
+
+			if (index.keyCount() != distinctKeys.size()) {
+				fail("keyCount");
+			}
+
+			vector<pair<TTHValue*, const Item*>> found(index.begin(), index.end()), expected(reference.begin(), reference.end());
+			ranges::sort(found);
+			ranges::sort(expected);
+			if (found != expected) {
+				fail("iteration");
+			}
+
+			// The key must always point to the TTH of its own value
+			if (ranges::any_of(found, [](const auto& aEntry) { return aEntry.first != &aEntry.second->tth; })) {
+				fail("iteration (key)");
+			}
+		}
+
+		void clear() noexcept {
+			index.clear();
+			reference.clear();
+			items.clear();
+		}
+
+		void fail(const string& aFunction) noexcept {
+			// Don't flood the output
+			if (failures++ < 20) {
+				std::cerr << aFunction << " mismatch after " << operations << " operations" << std::endl;
+			}
+		}
+
+		Generator gen;
+		const vector<TTHValue> keys;
+
+		Index index;
+		ReferenceIndex reference;
+		vector<unique_ptr<Item>> items;
+
+		uint64_t nextId = 0;
+		uint64_t operations = 0;
+		uint64_t failures = 0;
+	};
+}
+
+static void printUsage() {
+	std::cerr <<
+		"Usage: airdcpp-tthindex-fuzz [options]\n"
+		"\n"
+		"  --iterations <count>  Number of random operations (default 10000000)\n"
+		"  --seed <value>        Seed for the operation generator (default 1)\n";
+}
+
+int main(int argc, char* argv[]) {
+	uint64_t iterations = 10000000;
+	uint64_t seed = 1;
+
+	for (int i = 1; i < argc; ++i) {
+		string arg = argv[i];
+		if (i + 1 >= argc) {
+			printUsage();
+			return 1;
+		}
+
+		string value = argv[++i];
+		if (arg == "--iterations") {
+			iterations = static_cast<uint64_t>(Util::toInt64(value));
+		} else if (arg == "--seed") {
+			seed = static_cast<uint64_t>(Util::toInt64(value));
+		} else {
+			printUsage();
+			return 1;
+		}
+	}
+
+	Fuzzer fuzzer(seed);
+	fuzzer.run(iterations);
+
+	std::cout << fuzzer.getOperations() << " operations checked, " << fuzzer.getFailures() << " mismatches" << std::endl;
+	return fuzzer.getFailures() == 0 ? 0 : 1;
+}
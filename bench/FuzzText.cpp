@@ -0,0 +1,294 @@
+/*
+ * Copyright (C) 2011-2024 AirDC++ Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+// Differential fuzzer for the vectorized text functions
+// Compares Text::validateUtf8, Text::toLower and DualString against the plain per-character implementations
+
+#include "stdinc.h"
+#include "Generators.h"
+
+#include <airdcpp/util/Util.h>
+#include <airdcpp/util/text/DualString.h>
+#include <airdcpp/util/text/Text.h>
+
+#include <iostream>
+
+using namespace dcpp;
+using namespace dcpp::bench;
+
+namespace {
+	// Lengths around the 16 byte chunk size of the vectorized loops
+	const size_t MAX_LENGTH = 70;
+
+	const char* const multibyteChars[] = {
+		"\xc3\xa4", // ä
+		"\xc3\x84", // Ä
+		"\xc3\x9f", // ß
+		"\xce\xa3", // Σ
+		"\xe2\x82\xac", // €
+		"\xe1\xba\x9e", // ẞ
+		"\xf0\x9f\x98\x80", // emoji (4 bytes)
+	};
+
+	const char* const invalidSequences[] = {
+		"\xc3", // truncated
+		"\xe2\x82", // truncated
+		"\x80", // lone continuation byte
+		"\xc0\xaf", // overlong
+		"\xed\xa0\x80", // surrogate
+		"\xf8\x88\x80\x80\x80", // 5 bytes
+		"\xff",
+	};
+
+	// Plain implementations of the functions before the ASCII fast paths were added
+
+	bool validateUtf8Scalar(const string& aStr) noexcept {
+		string::size_type i = 0;
+		while (i < aStr.length()) {
+			wchar_t dummy = 0;
+			int j = Text::utf8ToWc(&aStr[i], dummy);
+			if (j < 0 || i + j > aStr.length())
+				return false;
+			i += j;
+		}
+		return true;
+	}
+
+	string toLowerScalar(const string& aStr) noexcept {
+		if (aStr.empty())
+			return Util::emptyString;
+
+#ifdef _WIN32
+		auto wstr = Text::utf8ToWide(aStr);
+		return Text::wideToUtf8(Text::toLowerReplace(wstr));
+#else
+		string tmp;
+		tmp.reserve(aStr.length());
+		const char* end = &aStr[0] + aStr.length();
+		for (const char* p = &aStr[0]; p < end;) {
+			wchar_t c = 0;
+			int n = Text::utf8ToWc(p, c);
+			if (n < 0) {
+				tmp += '_';
+				p += abs(n);
+			} else {
+				p += n;
+				Text::wcToUtf8(Text::toLower(c), tmp);
+			}
+		}
+		return tmp;
+#endif
+	}
+
+	// Result of DualString::getNormal with the mask calculated by comparing each decoded character
+	string dualStringNormalScalar(const string& aStr, bool& lowerCaseOnly_) noexcept {
+		const auto lower = toLowerScalar(aStr);
+		const size_t bits = sizeof(DualString::MaskType) * 8;
+
+		vector<DualString::MaskType> mask;
+		size_t pos = 0;
+		auto iNormal = aStr.c_str();
+		for (auto iLower = lower.c_str(); *iLower;) {
+			wchar_t cNormal = 0, cLower = 0;
+			int nNormal = Text::utf8ToWc(iNormal, cNormal);
+			int nLower = Text::utf8ToWc(iLower, cLower);
+			if (cNormal != cLower) {
+				if (mask.empty()) {
+					mask.resize((lower.size() + bits - 1) / bits);
+				}
+
+				mask[pos / bits] |= static_cast<DualString::MaskType>(1) << (pos % bits);
+			}
+
+			iNormal += abs(nNormal);
+			iLower += abs(nLower);
+			pos += abs(nLower);
+		}
+
+		lowerCaseOnly_ = mask.empty();
+		if (mask.empty()) {
+			return lower;
+		}
+
+		string ret;
+		pos = 0;
+		const char* end = lower.c_str() + lower.size();
+		for (auto iLower = lower.c_str(); iLower < end;) {
+			if (mask[pos / bits] & (static_cast<DualString::MaskType>(1) << (pos % bits))) {
+				wchar_t cLower = 0;
+				int nLower = Text::utf8ToWc(iLower, cLower);
+				Text::wcToUtf8(Text::toUpper(cLower), ret);
+				pos += abs(nLower);
+				iLower += abs(nLower);
+			} else {
+				ret += *iLower;
+				pos++;
+				iLower++;
+			}
+		}
+
+		return ret;
+	}
+
+	string randomLengthInput(Generator& aGen, const std::function<void (string&)>& aAppend) noexcept {
+		auto len = aGen.next(MAX_LENGTH + 1);
+		string ret;
+		while (ret.size() < len) {
+			aAppend(ret);
+		}
+
+		return ret;
+	}
+
+	// Random bytes (including null characters)
+	string randomBytes(Generator& aGen) noexcept {
+		return randomLengthInput(aGen, [&](string& str_) {
+			str_ += static_cast<char>(aGen.next(256));
+		});
+	}
+
+	// Mostly ASCII with uppercase characters and control characters
+	string randomAscii(Generator& aGen) noexcept {
+		return randomLengthInput(aGen, [&](string& str_) {
+			switch (aGen.next(4)) {
+				case 0: str_ += static_cast<char>('A' + aGen.next(26)); break;
+				case 1: str_ += static_cast<char>(1 + aGen.next(0x7F)); break;
+				default: str_ += static_cast<char>('a' + aGen.next(26)); break;
+			}
+		});
+	}
+
+	// ASCII runs with valid and invalid multibyte sequences that often cross the chunk boundaries
+	string randomMixed(Generator& aGen) noexcept {
+		return randomLengthInput(aGen, [&](string& str_) {
+			auto r = aGen.next(16);
+			if (r == 0) {
+				str_ += invalidSequences[aGen.next(std::size(invalidSequences))];
+			} else if (r < 4) {
+				str_ += multibyteChars[aGen.next(std::size(multibyteChars))];
+			} else {
+				str_ += static_cast<char>((aGen.next(2) == 0 ? 'A' : 'a') + aGen.next(26));
+			}
+		});
+	}
+
+	string escape(const string& aStr) noexcept {
+		string ret;
+		for (auto c: aStr) {
+			char buf[8];
+			snprintf(buf, sizeof(buf), "\\x%02x", static_cast<uint8_t>(c));
+			ret += buf;
+		}
+
+		return ret;
+	}
+
+	class Fuzzer {
+	public:
+		void check(const string& aInput) noexcept {
+			checks++;
+
+			if (Text::validateUtf8(aInput) != validateUtf8Scalar(aInput)) {
+				fail("validateUtf8", aInput);
+			}
+
+			auto lower = Text::toLower(aInput);
+			if (lower != toLowerScalar(aInput)) {
+				fail("toLower", aInput);
+			}
+
+			bool lowerCaseOnly = true;
+			auto normal = dualStringNormalScalar(aInput, lowerCaseOnly);
+
+			DualString dualString(aInput);
+			if (dualString.getLower() != lower || dualString.getNormal() != normal || dualString.lowerCaseOnly() != lowerCaseOnly) {
+				fail("DualString", aInput);
+			}
+		}
+
+		void run(uint64_t aSeed, uint64_t aIterations) noexcept {
+			Generator gen(aSeed);
+			for (uint64_t i = 0; i < aIterations; ++i) {
+				check(randomBytes(gen));
+				check(randomAscii(gen));
+				check(randomMixed(gen));
+			}
+		}
+
+		uint64_t getChecks() const noexcept {
+			return checks;
+		}
+
+		uint64_t getFailures() const noexcept {
+			return failures;
+		}
+	private:
+		void fail(const string& aFunction, const string& aInput) noexcept {
+			// Don't flood the output
+			if (failures++ < 20) {
+				std::cerr << aFunction << " mismatch: \"" << escape(aInput) << "\"" << std::endl;
+			}
+		}
+
+		uint64_t checks = 0;
+		uint64_t failures = 0;
+	};
+}
+
+static void printUsage() {
+	std::cerr <<
+		"Usage: airdcpp-text-fuzz [options]\n"
+		"\n"
+		"  --iterations <count>  Number of inputs of each kind for each locale (default 1000000)\n"
+		"  --seed <value>        Seed for the input generator (default 1)\n";
+}
+
+int main(int argc, char* argv[]) {
+	uint64_t iterations = 1000000;
+	uint64_t seed = 1;
+
+	for (int i = 1; i < argc; ++i) {
+		string arg = argv[i];
+		if (i + 1 >= argc) {
+			printUsage();
+			return 1;
+		}
+
+		string value = argv[++i];
+		if (arg == "--iterations") {
+			iterations = static_cast<uint64_t>(Util::toInt64(value));
+		} else if (arg == "--seed") {
+			seed = static_cast<uint64_t>(Util::toInt64(value));
+		} else {
+			printUsage();
+			return 1;
+		}
+	}
+
+	Fuzzer fuzzer;
+
+	// The default C locale
+	fuzzer.run(seed, iterations);
+
+	// Locale from the environment (the ASCII fast paths are disabled if it has non-standard ASCII case mapping)
+	Text::initialize();
+	fuzzer.run(seed + 1, iterations);
+
+	std::cout << fuzzer.getChecks() << " inputs checked, " << fuzzer.getFailures() << " mismatches" << std::endl;
+	return fuzzer.getFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,250 @@
+/*
+ * Copyright (C) 2011-2024 AirDC++ Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "stdinc.h"
+#include "Generators.h"
+
+#include <airdcpp/util/text/StringTokenizer.h>
+
+namespace dcpp::bench {
+
+namespace {
+	const char* syllables[] = {
+		"ka", "lo", "mi", "ne", "su", "ta", "ri", "po", "da", "ve", "xo", "ly", "fa", "gu", "he", "jo",
+		"ba", "ce", "di", "fo", "gi", "ha", "ju", "ko", "le", "ma", "no", "pe", "qu", "ro", "si", "tu"
+	};
+
+	const char* extensions[] = {
+		"mkv", "mp3", "flac", "rar", "r01", "nfo", "jpg", "txt", "iso", "zip", "avi", "sfv"
+	};
+
+	const char* sidChars = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
+
+	const size_t MAX_DEPTH = 4;
+	const size_t MAX_DIRECTORY_FILES = 40;
+
+	void generateDirectory(Generator& aGen, SyntheticDirectory& dir_, size_t aDepth, size_t aFiles) noexcept {
+		if (aDepth == MAX_DEPTH || aFiles <= MAX_DIRECTORY_FILES) {
+			for (size_t i = 0; i < aFiles; ++i) {
+				dir_.files.push_back({ aGen.fileName(), aGen.tth(), aGen.fileSize() });
+			}
+
+			return;
+		}
+
+		// Split the remaining files between the subdirectories
+		auto childCount = min<size_t>(aFiles / MAX_DIRECTORY_FILES, 2 + aGen.next(30));
+		auto childFiles = aFiles / childCount;
+		for (size_t i = 0; i < childCount; ++i) {
+			SyntheticDirectory child;
+			child.name = aGen.words(1 + aGen.next(3)) + " " + std::to_string(i);
+			generateDirectory(aGen, child, aDepth + 1, i == childCount - 1 ? aFiles - childFiles * i : childFiles);
+			dir_.directories.push_back(std::move(child));
+		}
+	}
+
+	void directoryToXml(const SyntheticDirectory& aDir, string& xml_, string& indent_) noexcept {
+		xml_ += indent_ + "<Directory Name=\"" + aDir.name + "\" Date=\"1700000000\">\r\n";
+		indent_ += '\t';
+
+		for (const auto& d: aDir.directories) {
+			directoryToXml(d, xml_, indent_);
+		}
+
+		for (const auto& f: aDir.files) {
+			xml_ += indent_ + "<File Name=\"" + f.name + "\" Size=\"" + std::to_string(f.size) + "\" TTH=\"" + f.tth.toBase32() + "\"/>\r\n";
+		}
+
+		indent_.pop_back();
+		xml_ += indent_ + "</Directory>\r\n";
+	}
+
+	string escapeAdc(const string& aText) noexcept {
+		string ret;
+		for (auto c: aText) {
+			if (c == ' ') {
+				ret += "\\s";
+			} else {
+				ret += c;
+			}
+		}
+
+		return ret;
+	}
+}
+
+string Generator::word() noexcept {
+	string ret;
+	auto count = 2 + next(3);
+	for (uint64_t i = 0; i < count; ++i) {
+		ret += syllables[next(std::size(syllables))];
+	}
+
+	return ret;
+}
+
+string Generator::words(size_t aCount, char aSeparator) noexcept {
+	string ret;
+	for (size_t i = 0; i < aCount; ++i) {
+		if (i > 0) {
+			ret += aSeparator;
+		}
+
+		ret += word();
+	}
+
+	return ret;
+}
+
+TTHValue Generator::tth() noexcept {
+	TTHValue ret;
+	for (size_t i = 0; i < TTHValue::BYTES; i += sizeof(uint64_t)) {
+		auto v = rng();
+		memcpy(ret.data + i, &v, min(sizeof(uint64_t), TTHValue::BYTES - i));
+	}
+
+	return ret;
+}
+
+int64_t Generator::fileSize() noexcept {
+	return (static_cast<int64_t>(1024) << next(24)) + static_cast<int64_t>(next(1024));
+}
+
+string Generator::fileName() noexcept {
+	return words(1 + next(4), next(2) == 0 ? ' ' : '.') + "." + extensions[next(std::size(extensions))];
+}
+
+ByteVector Generator::bytes(size_t aSize) noexcept {
+	ByteVector ret(aSize);
+	for (size_t i = 0; i < aSize; i += sizeof(uint64_t)) {
+		auto v = rng();
+		memcpy(&ret[i], &v, min(sizeof(uint64_t), aSize - i));
+	}
+
+	return ret;
+}
+
+SyntheticDirectory generateTree(Generator& aGen, size_t aFiles) noexcept {
+	SyntheticDirectory root;
+	root.name = "share";
+	generateDirectory(aGen, root, 0, aFiles);
+	return root;
+}
+
+void forEachFile(const SyntheticDirectory& aRoot, const std::function<void (const SyntheticFile&)>& aF) noexcept {
+	for (const auto& d: aRoot.directories) {
+		forEachFile(d, aF);
+	}
+
+	for (const auto& f: aRoot.files) {
+		aF(f);
+	}
+}
+
+string generateFilelist(const SyntheticDirectory& aRoot) noexcept {
+	string xml = "<?xml version=\"1.0\" encoding=\"utf-8\" standalone=\"yes\"?>\r\n";
+	xml += "<FileListing Version=\"1\" CID=\"UOQLOQU3HCDW7JKMZNZVCFVGUZSXDGSDZ52QO3Y\" Base=\"/\" Generator=\"AirDC++ bench\">\r\n";
+
+	string indent = "\t";
+	for (const auto& d: aRoot.directories) {
+		directoryToXml(d, xml, indent);
+	}
+
+	xml += "</FileListing>";
+	return xml;
+}
+
+StringList generateAdcCommands(Generator& aGen, size_t aCount) noexcept {
+	auto sid = [&aGen] {
+		string ret;
+		for (int i = 0; i < 4; ++i) {
+			ret += sidChars[aGen.next(32)];
+		}
+
+		return ret;
+	};
+
+	StringList ret;
+	ret.reserve(aCount);
+	for (size_t i = 0; i < aCount; ++i) {
+		switch (aGen.next(6)) {
+			case 0:
+				ret.push_back("BINF " + sid() + " ID" + aGen.tth().toBase32() + " NI" + aGen.word() + " SL" + std::to_string(aGen.next(20)) +
+					" SS" + std::to_string(aGen.fileSize()) + " SF" + std::to_string(aGen.next(1000000)) + " HN1 HR0 HO0 VEAirDC++\\s4.21 SUSEGA,ADC0,TCP4,UDP4");
+				break;
+			case 1:
+				ret.push_back("BMSG " + sid() + " " + escapeAdc(aGen.words(1 + aGen.next(20))));
+				break;
+			case 2:
+				ret.push_back("BSCH " + sid() + " AN" + aGen.word() + " AN" + aGen.word() + " TO" + std::to_string(aGen.next(1000000)));
+				break;
+			case 3:
+				ret.push_back("DRES " + sid() + " " + sid() + " FN/" + escapeAdc(aGen.words(3, '/')) + "/" + escapeAdc(aGen.fileName()) +
+					" SI" + std::to_string(aGen.fileSize()) + " SL3 TR" + aGen.tth().toBase32() + " TO" + std::to_string(aGen.next(1000000)));
+				break;
+			case 4:
+				ret.push_back("DCTM " + sid() + " " + sid() + " ADCS/0.10 " + std::to_string(1024 + aGen.next(60000)) + " " + std::to_string(aGen.next(1000000)));
+				break;
+			default:
+				ret.push_back("CSND file TTH/" + aGen.tth().toBase32() + " " + std::to_string(aGen.next(1 << 20)) + " " + std::to_string(aGen.fileSize()));
+				break;
+		}
+	}
+
+	return ret;
+}
+
+vector<StringList> generateSearchQueries(Generator& aGen, const SyntheticDirectory& aRoot, size_t aCount) noexcept {
+	vector<const SyntheticFile*> files;
+	forEachFile(aRoot, [&files](const SyntheticFile& aFile) {
+		files.push_back(&aFile);
+	});
+
+	vector<StringList> ret;
+	ret.reserve(aCount);
+	for (size_t i = 0; i < aCount; ++i) {
+		StringList params;
+		if (!files.empty() && aGen.next(2) == 0) {
+			// Words from an existing file name
+			auto name = files[aGen.next(files.size())]->name;
+			name.erase(name.rfind('.'));
+			ranges::replace(name, '.', ' ');
+
+			auto words = StringTokenizer<string>(name, ' ').getTokens();
+			auto count = 1 + aGen.next(min<size_t>(words.size(), 3));
+			for (uint64_t j = 0; j < count; ++j) {
+				params.push_back("AN" + words[aGen.next(words.size())]);
+			}
+		} else {
+			auto count = 1 + aGen.next(4);
+			for (uint64_t j = 0; j < count; ++j) {
+				params.push_back("AN" + aGen.word());
+			}
+		}
+
+		if (aGen.next(8) == 0) {
+			params.push_back("EX" + string(extensions[aGen.next(std::size(extensions))]));
+		}
+
+		ret.push_back(std::move(params));
+	}
+
+	return ret;
+}
+
+} // namespace dcpp::bench
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2011-2024 AirDC++ Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef DCPLUSPLUS_BENCH_GENERATORS_H
+#define DCPLUSPLUS_BENCH_GENERATORS_H
+
+#include <airdcpp/core/header/typedefs.h>
+#include <airdcpp/hash/value/MerkleTree.h>
+
+#include <random>
+
+namespace dcpp::bench {
+
+// Deterministic data generators
+// The same seed will always produce the same data on all platforms (std::mt19937_64 is fully specified
+// and the standard distributions are avoided as their output is implementation-defined)
+class Generator {
+public:
+	explicit Generator(uint64_t aSeed) : rng(aSeed) { }
+
+	// Uniform value in range [0, aMax)
+	uint64_t next(uint64_t aMax) noexcept {
+		return rng() % aMax;
+	}
+
+	// Pronounceable pseudo-word
+	string word() noexcept;
+
+	// Words joined with the separator
+	string words(size_t aCount, char aSeparator = ' ') noexcept;
+
+	TTHValue tth() noexcept;
+
+	// Sizes are distributed exponentially between 1 KiB and 16 GiB
+	int64_t fileSize() noexcept;
+
+	string fileName() noexcept;
+
+	ByteVector bytes(size_t aSize) noexcept;
+private:
+	std::mt19937_64 rng;
+};
+
+struct SyntheticFile {
+	string name;
+	TTHValue tth;
+	int64_t size;
+};
+
+struct SyntheticDirectory {
+	string name;
+	vector<SyntheticDirectory> directories;
+	vector<SyntheticFile> files;
+};
+
+// Directory tree with about aFiles files (up to 4 levels, 1-40 files per directory)
+SyntheticDirectory generateTree(Generator& aGen, size_t aFiles) noexcept;
+
+// Filelist XML for the tree (same format as generated by ShareTree::toFilelist)
+string generateFilelist(const SyntheticDirectory& aRoot) noexcept;
+
+// Mix of ADC hub and client commands (INF, MSG, SCH, RES, CTM, SND)
+StringList generateAdcCommands(Generator& aGen, size_t aCount) noexcept;
+
+// ADC search parameters with 1-4 terms
+// About half of the queries use words that exist in the given tree
+vector<StringList> generateSearchQueries(Generator& aGen, const SyntheticDirectory& aRoot, size_t aCount) noexcept;
+
+// Calls the function for each file in the tree
+void forEachFile(const SyntheticDirectory& aRoot, const std::function<void (const SyntheticFile&)>& aF) noexcept;
+
+} // namespace dcpp::bench
+
+#endif // !defined(DCPLUSPLUS_BENCH_GENERATORS_H)
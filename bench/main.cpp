@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2011-2024 AirDC++ Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "stdinc.h"
+#include "Bench.h"
+
+#include <airdcpp/core/crypto/CryptoManager.h>
+#include <airdcpp/core/io/File.h>
+#include <airdcpp/core/timer/TimerManager.h>
+#include <airdcpp/core/timer/Tracer.h>
+#include <airdcpp/hub/ClientManager.h>
+#include <airdcpp/settings/SettingsManager.h>
+
+#include <iostream>
+
+using namespace dcpp;
+using namespace dcpp::bench;
+
+static void printUsage() {
+	std::cerr <<
+		"Usage: airdcpp-bench [options]\n"
+		"\n"
+		"  --filter <prefix>   Only run benchmarks starting with the prefix (hash, share, xml, adc, queue, speaker, tls)\n"
+		"  --files <count>     Number of files in the synthetic share and filelists (default 1000000)\n"
+		"  --repeat <count>    Number of measured runs for each benchmark (default 5)\n"
+		"  --seed <value>      Seed for the data generators (default 1)\n"
+		"  --temp <directory>  Directory for temporary files (default current directory)\n"
+		"  --output <path>     Write the JSON results to a file instead of stdout\n"
+		"  --trace <path>      Record the spans of the core and write them to a Chrome trace file\n";
+}
+
+int main(int argc, char* argv[]) {
+	Options options;
+	string outputPath;
+	string tracePath;
+
+	for (int i = 1; i < argc; ++i) {
+		string arg = argv[i];
+		if (i + 1 >= argc) {
+			printUsage();
+			return 1;
+		}
+
+		string value = argv[++i];
+		if (arg == "--filter") {
+			options.filter = value;
+		} else if (arg == "--files") {
+			options.files = static_cast<size_t>(Util::toInt64(value));
+		} else if (arg == "--repeat") {
+			options.repeat = max(Util::toInt(value), 1);
+		} else if (arg == "--seed") {
+			options.seed = static_cast<uint64_t>(Util::toInt64(value));
+		} else if (arg == "--temp") {
+			options.tempDirectory = value;
+		} else if (arg == "--output") {
+			outputPath = value;
+		} else if (arg == "--trace") {
+			tracePath = value;
+		} else {
+			printUsage();
+			return 1;
+		}
+	}
+
+	// Managers required by the benchmarked components (no settings or other data is loaded)
+	SettingsManager::newInstance();
+	TimerManager::newInstance();
+	ClientManager::newInstance();
+	CryptoManager::newInstance();
+
+	if (!tracePath.empty()) {
+		Tracer::setEnabled(true);
+	}
+
+	Runner runner(options);
+	runHashBenchmarks(runner);
+	runShareBenchmarks(runner);
+	runXMLBenchmarks(runner);
+	runProtocolBenchmarks(runner);
+	runQueueBenchmarks(runner);
+	runSpeakerBenchmarks(runner);
+	runTLSBenchmarks(runner);
+
+	CryptoManager::deleteInstance();
+	ClientManager::deleteInstance();
+	TimerManager::deleteInstance();
+	SettingsManager::deleteInstance();
+
+	if (!tracePath.empty()) {
+		try {
+			Tracer::exportChromeTrace(tracePath);
+		} catch (const FileException& e) {
+			std::cerr << "Failed to write the trace: " << e.getError() << std::endl;
+			return 1;
+		}
+	}
+
+	auto json = runner.toJson();
+	if (outputPath.empty()) {
+		std::cout << json;
+		return 0;
+	}
+
+	try {
+		File f(outputPath, File::WRITE, File::CREATE | File::TRUNCATE);
+		f.write(json);
+	} catch (const FileException& e) {
+		std::cerr << "Failed to write the results: " << e.getError() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}